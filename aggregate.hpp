@@ -0,0 +1,421 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+namespace middleout {
+
+/*
+
+Aggregates, predicate scans and downsampled buckets computed while decoding compressed values,
+which are never written to memory.
+
+Sum of integers wraps around. Segments (see middle-out) are summed separately, their sums are added
+in segment order and the uncompressed rest of values after them, so every kernel returns the same
+sum of doubles, which may differ in the last bits from sum of the values in order. NaNs are skipped
+by min and max (min is greater than max if all values are NaN).
+
+*/
+template <typename T>
+struct Aggregates {
+	T sum;
+	T min;
+	T max;
+	size_t count;  // mean is sum / count
+};
+
+// aggregates of the 8 segments, lane j aggregates segment j
+template <typename T>
+struct LaneAggregates {
+	T sums[8];
+	T mins[8];
+	T maxs[8];
+};
+
+template <typename T>
+static inline T addValues(T a, T b) {
+	if (std::is_floating_point<T>::value) {
+		return a + b;
+	}
+	// signed overflow wraps around
+	return (T)((uint64_t)a + (uint64_t)b);
+}
+
+// NaN value keeps the current one
+template <typename T>
+static inline T minValue(T value, T current) {
+	return value < current ? value : current;
+}
+
+template <typename T>
+static inline T maxValue(T value, T current) {
+	return value > current ? value : current;
+}
+
+// aggregates of no values, min and max are the identities
+template <typename T>
+static inline void initAggregates(Aggregates<T>* aggregates, size_t count) {
+	aggregates->sum = 0;
+	aggregates->min = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+	                                                      : std::numeric_limits<T>::max();
+	aggregates->max = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+	                                                      : std::numeric_limits<T>::lowest();
+	aggregates->count = count;
+}
+
+template <typename T>
+static inline void initLanes(LaneAggregates<T>* lanes) {
+	Aggregates<T> identity;
+	initAggregates(&identity, 0);
+	for (size_t j = 0; j < 8; j++) {
+		lanes->sums[j] = identity.sum;
+		lanes->mins[j] = identity.min;
+		lanes->maxs[j] = identity.max;
+	}
+}
+
+/*
+ Adds row of 8 values (one of each segment), min and max do not change if the row is the same as
+ the previous one
+*/
+template <typename T>
+static inline void aggregateRow(LaneAggregates<T>* lanes, const uint64_t* row, bool unchanged) {
+	T values[8];
+	memcpy(values, row, sizeof(values));
+	for (size_t j = 0; j < 8; j++) {
+		lanes->sums[j] = addValues(lanes->sums[j], values[j]);
+	}
+	if (unchanged) {
+		return;
+	}
+	for (size_t j = 0; j < 8; j++) {
+		lanes->mins[j] = minValue(values[j], lanes->mins[j]);
+		lanes->maxs[j] = maxValue(values[j], lanes->maxs[j]);
+	}
+}
+
+template <typename T>
+static inline void mergeLanes(const LaneAggregates<T>* lanes, Aggregates<T>* aggregates) {
+	for (size_t j = 0; j < 8; j++) {
+		aggregates->sum = addValues(aggregates->sum, lanes->sums[j]);
+		aggregates->min = minValue(lanes->mins[j], aggregates->min);
+		aggregates->max = maxValue(lanes->maxs[j], aggregates->max);
+	}
+}
+
+// adds count values stored uncompressed (possibly unaligned)
+template <typename T>
+static inline void aggregateValues(const char* input, size_t count, Aggregates<T>* aggregates) {
+	for (size_t i = 0; i < count; i++) {
+		T value;
+		memcpy(&value, &input[sizeof(T) * i], sizeof(T));
+		aggregates->sum = addValues(aggregates->sum, value);
+		aggregates->min = minValue(value, aggregates->min);
+		aggregates->max = maxValue(value, aggregates->max);
+	}
+}
+
+//
+// PREDICATE SCAN
+//
+// Scan marks values matching a predicate (value < threshold, ...) in a bitmap, bit i of word i / 64
+// is set for matching value i (bitmaps of scanBitmapWords(count) words). NaNs match SCAN_NOT_EQUAL
+// only, as in C++ comparisons. Rows are compared lane by lane, masks of 8 consecutive rows are
+// transposed to a byte of 8 consecutive positions of every segment.
+//
+
+enum ScanPredicate {
+	SCAN_LESS,
+	SCAN_LESS_EQUAL,
+	SCAN_GREATER,
+	SCAN_GREATER_EQUAL,
+	SCAN_EQUAL,
+	SCAN_NOT_EQUAL
+};
+
+static inline size_t scanBitmapWords(size_t count) {
+	return (count + 63) / 64;
+}
+
+template <ScanPredicate PREDICATE, typename T>
+static inline bool matches(T value, T threshold) {
+	switch (PREDICATE) {
+		case SCAN_LESS:
+			return value < threshold;
+		case SCAN_LESS_EQUAL:
+			return value <= threshold;
+		case SCAN_GREATER:
+			return value > threshold;
+		case SCAN_GREATER_EQUAL:
+			return value >= threshold;
+		case SCAN_EQUAL:
+			return value == threshold;
+		default:
+			return value != threshold;
+	}
+}
+
+/*
+ ORs 8 bits to bitmap from position on, bits behind the end of the bitmap must be zero
+*/
+static inline void setBitmapByte(uint64_t* bitmap, size_t position, uint8_t bits) {
+	size_t shift = position % 64;
+	bitmap[position / 64] |= (uint64_t)bits << shift;
+	if (shift > 56 && (bits >> (64 - shift)) != 0) {
+		bitmap[position / 64 + 1] |= (uint64_t)bits >> (64 - shift);
+	}
+}
+
+/*
+ Stores masks of 8 rows from firstRow on (bit j of byte r is lane j of row firstRow + r), rows
+ behind the last one must have zero masks
+*/
+static inline void storeRowMasks(uint64_t* bitmap,
+                                 size_t blockSize,
+                                 size_t firstRow,
+                                 uint64_t masks) {
+	// transpose of 8x8 bit matrix, bit r of byte j is lane j of row firstRow + r
+	uint64_t t = (masks ^ (masks >> 7)) & 0x00AA00AA00AA00AAULL;
+	masks ^= t ^ (t << 7);
+	t = (masks ^ (masks >> 14)) & 0x0000CCCC0000CCCCULL;
+	masks ^= t ^ (t << 14);
+	t = (masks ^ (masks >> 28)) & 0x00000000F0F0F0F0ULL;
+	masks ^= t ^ (t << 28);
+
+	for (size_t j = 0; j < 8; j++) {
+		setBitmapByte(bitmap, blockSize * j + firstRow, masks >> (8 * j));
+	}
+}
+
+// masks of rows of the current tile of 8 rows
+struct RowMasks {
+	uint64_t masks;
+	size_t matching;  // count of set bits of stored tiles
+};
+
+// bit j of the mask is lane j
+template <ScanPredicate PREDICATE, typename T>
+static inline uint8_t matchRow(const uint64_t* row, T threshold) {
+	T values[8];
+	memcpy(values, row, sizeof(values));
+	uint8_t mask = 0;
+	for (size_t j = 0; j < 8; j++) {
+		mask |= matches<PREDICATE>(values[j], threshold) << j;
+	}
+	return mask;
+}
+
+/*
+ Adds mask of row rowIndex (rows are added in order from 0 on), tiles are stored when complete
+*/
+static inline void addRowMask(RowMasks* rows,
+                              uint64_t* bitmap,
+                              size_t blockSize,
+                              size_t rowIndex,
+                              uint8_t mask) {
+	rows->masks |= (uint64_t)mask << (8 * (rowIndex % 8));
+	if (rowIndex % 8 == 7) {
+		rows->matching += __builtin_popcountll(rows->masks);
+		storeRowMasks(bitmap, blockSize, rowIndex - 7, rows->masks);
+		rows->masks = 0;
+	}
+}
+
+// stores the last incomplete tile, returns count of matching values of all rows
+static inline size_t finishRowMasks(RowMasks* rows, uint64_t* bitmap, size_t blockSize) {
+	if (blockSize % 8 != 0) {
+		rows->matching += __builtin_popcountll(rows->masks);
+		storeRowMasks(bitmap, blockSize, blockSize - blockSize % 8, rows->masks);
+	}
+	return rows->matching;
+}
+
+/*
+ Scans count values stored uncompressed (possibly unaligned), position is the index of the first
+ one. Returns number of matching values.
+*/
+template <ScanPredicate PREDICATE, typename T>
+static inline size_t scanValues(const char* input,
+                                size_t count,
+                                T threshold,
+                                uint64_t* bitmap,
+                                size_t position) {
+	size_t matching = 0;
+	for (size_t i = 0; i < count; i++) {
+		T value;
+		memcpy(&value, &input[sizeof(T) * i], sizeof(T));
+		if (matches<PREDICATE>(value, threshold)) {
+			bitmap[(position + i) / 64] |= (uint64_t)1 << ((position + i) % 64);
+			matching++;
+		}
+	}
+	return matching;
+}
+
+//
+// BUCKETS
+//
+// Downsampling to buckets of width consecutive values (the last one may be shorter), bucket holds
+// their first and last value and aggregates. Segments are decoded in parallel, every lane keeps a
+// partial bucket. Buckets within a segment are stored when complete, partial buckets at segment
+// boundaries (head, the first one of a segment, and the current one) are appended in order of
+// positions at the end, then values of the uncompressed rest. Sums of doubles are the same for
+// every kernel, see Aggregates.
+//
+
+template <typename T>
+struct Bucket {
+	T first;
+	T last;
+	T min;
+	T max;
+	T sum;
+	size_t count;  // mean is sum / count
+};
+
+static inline size_t getBucketsCount(size_t count, size_t width) {
+	return (count + width - 1) / width;
+}
+
+template <typename T>
+static inline void initBucket(Bucket<T>* bucket) {
+	Aggregates<T> identity;
+	initAggregates(&identity, 0);
+	*bucket = {0, 0, identity.min, identity.max, 0, 0};
+}
+
+// unchanged value (same as the previous one of the bucket) does not change min and max
+template <typename T>
+static inline void appendValue(Bucket<T>* bucket, T value, bool unchanged = false) {
+	if (bucket->count == 0) {
+		bucket->first = value;
+		bucket->sum = value;
+	} else {
+		bucket->sum = addValues(bucket->sum, value);
+	}
+	if (!unchanged || bucket->count == 0) {
+		bucket->min = minValue(value, bucket->min);
+		bucket->max = maxValue(value, bucket->max);
+	}
+	bucket->last = value;
+	bucket->count++;
+}
+
+// appends bucket of values following the ones of bucket
+template <typename T>
+static inline void appendBucket(Bucket<T>* bucket, const Bucket<T>* next) {
+	if (next->count == 0) {
+		return;
+	}
+	if (bucket->count == 0) {
+		*bucket = *next;
+		return;
+	}
+	bucket->last = next->last;
+	bucket->min = minValue(next->min, bucket->min);
+	bucket->max = maxValue(next->max, bucket->max);
+	bucket->sum = addValues(bucket->sum, next->sum);
+	bucket->count += next->count;
+}
+
+template <typename T>
+struct LaneBuckets {
+	Bucket<T> current[8];  // partial bucket of lane
+	Bucket<T> heads[8];    // the first bucket of segment, once the segment leaves it
+	bool hasHead[8];
+	size_t indexes[8];     // index of the current bucket
+	size_t remaining[8];   // values left to the end of the current bucket
+};
+
+template <typename T>
+static inline void initLaneBuckets(LaneBuckets<T>* lanes, size_t blockSize, size_t width) {
+	for (size_t j = 0; j < 8; j++) {
+		initBucket(&lanes->current[j]);
+		lanes->hasHead[j] = false;
+		lanes->indexes[j] = blockSize * j / width;
+		lanes->remaining[j] = width - blockSize * j % width;
+	}
+}
+
+/*
+ Stores complete current bucket of lane j (remaining is reset by caller). Buckets starting within
+ segment are complete, head of segment may hold the tail of the previous segment.
+*/
+template <typename T>
+static inline void flushLane(LaneBuckets<T>* lanes, size_t j, Bucket<T>* buckets) {
+	if (lanes->hasHead[j]) {
+		buckets[lanes->indexes[j]] = lanes->current[j];
+	} else {
+		lanes->heads[j] = lanes->current[j];
+		lanes->hasHead[j] = true;
+	}
+	lanes->indexes[j]++;
+	initBucket(&lanes->current[j]);
+}
+
+// adds row of 8 values (one of each segment), unchanged row is the same as the previous one
+template <typename T>
+static inline void bucketRow(LaneBuckets<T>* lanes,
+                             const uint64_t* row,
+                             bool unchanged,
+                             size_t width,
+                             Bucket<T>* buckets) {
+	T values[8];
+	memcpy(values, row, sizeof(values));
+	for (size_t j = 0; j < 8; j++) {
+		if (lanes->remaining[j] == 0) {
+			flushLane(lanes, j, buckets);
+			lanes->remaining[j] = width;
+		}
+		appendValue(&lanes->current[j], values[j], unchanged);
+		lanes->remaining[j]--;
+	}
+}
+
+// appends partial buckets of segment boundaries in order of positions
+template <typename T>
+static inline void finishLaneBuckets(LaneBuckets<T>* lanes,
+                                     size_t blockSize,
+                                     size_t width,
+                                     Bucket<T>* buckets) {
+	for (size_t j = 0; j < 8; j++) {
+		if (lanes->hasHead[j]) {
+			appendBucket(&buckets[blockSize * j / width], &lanes->heads[j]);
+		}
+		appendBucket(&buckets[lanes->indexes[j]], &lanes->current[j]);
+	}
+}
+
+/*
+ Appends count values stored uncompressed (possibly unaligned), position is the index of the first
+ one
+*/
+template <typename T>
+static inline void bucketValues(const char* input,
+                                size_t count,
+                                size_t width,
+                                Bucket<T>* buckets,
+                                size_t position) {
+	for (size_t i = 0; i < count; i++) {
+		T value;
+		memcpy(&value, &input[sizeof(T) * i], sizeof(T));
+		appendValue(&buckets[(position + i) / width], value);
+	}
+}
+
+}  // end namespace middleout
+
+#endif /* AGGREGATE_H */
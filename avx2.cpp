@@ -0,0 +1,435 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "avx2.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <immintrin.h>
+#include <memory>
+
+namespace middleout {
+
+template class Avx2<double>;
+template class Avx2<int64_t>;
+template class Avx2<uint64_t>;
+
+template <typename T>
+Avx2<T>::Avx2() {}
+
+//
+// SHUFFLE TABLES
+//
+// 8 values of a block are processed as two halves of 4 values (one 256 bit vector each).
+// Tables are plain integers (no vector statics), so nothing AVX2 runs before dispatch.
+//
+
+/*
+ Emulates _mm256_maskz_compress_epi64: permutevar8x32 indexes moving values selected by 4 bit mask
+ to the front of the vector.
+*/
+alignas(32) static const int32_t COMPRESS_PERMUTATIONS[16][8] = {
+    {0, 1, 0, 1, 0, 1, 0, 1},  // 0000
+    {0, 1, 0, 1, 0, 1, 0, 1},  // 0001
+    {2, 3, 0, 1, 0, 1, 0, 1},  // 0010
+    {0, 1, 2, 3, 0, 1, 0, 1},  // 0011
+    {4, 5, 0, 1, 0, 1, 0, 1},  // 0100
+    {0, 1, 4, 5, 0, 1, 0, 1},  // 0101
+    {2, 3, 4, 5, 0, 1, 0, 1},  // 0110
+    {0, 1, 2, 3, 4, 5, 0, 1},  // 0111
+    {6, 7, 0, 1, 0, 1, 0, 1},  // 1000
+    {0, 1, 6, 7, 0, 1, 0, 1},  // 1001
+    {2, 3, 6, 7, 0, 1, 0, 1},  // 1010
+    {0, 1, 2, 3, 6, 7, 0, 1},  // 1011
+    {4, 5, 6, 7, 0, 1, 0, 1},  // 1100
+    {0, 1, 4, 5, 6, 7, 0, 1},  // 1101
+    {2, 3, 4, 5, 6, 7, 0, 1},  // 1110
+    {0, 1, 2, 3, 4, 5, 6, 7},  // 1111
+};
+
+/*
+ Emulates _mm256_maskz_expand_epi32: position of each value selected by 4 bit mask among the
+ selected values (0 for not selected ones)
+*/
+alignas(16) static const int32_t EXPAND_RANKS[16][4] = {
+    {0, 0, 0, 0},  // 0000
+    {0, 0, 0, 0},  // 0001
+    {0, 0, 0, 0},  // 0010
+    {0, 1, 0, 0},  // 0011
+    {0, 0, 0, 0},  // 0100
+    {0, 0, 1, 0},  // 0101
+    {0, 0, 1, 0},  // 0110
+    {0, 1, 2, 0},  // 0111
+    {0, 0, 0, 0},  // 1000
+    {0, 0, 0, 1},  // 1001
+    {0, 0, 0, 1},  // 1010
+    {0, 1, 0, 2},  // 1011
+    {0, 0, 0, 1},  // 1100
+    {0, 0, 1, 2},  // 1101
+    {0, 0, 1, 2},  // 1110
+    {0, 1, 2, 3},  // 1111
+};
+
+/*
+ pshufb indexes squeezing two 8 byte values to their lowest N (= maxLength) bytes each
+*/
+alignas(16) static const int8_t SQUEEZE_PAIR[9][16] = {
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 2, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 2, 3, 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 2, 3, 4, 8, 9, 10, 11, 12, -1, -1, -1, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+};
+
+/**
+ * Returns mask of values different from zero (bit per value)
+ */
+static inline int notZeroMask(__m256i lo, __m256i hi) {
+	__m256i zero = _mm256_setzero_si256();
+	int zeroLo = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(lo, zero)));
+	int zeroHi = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(hi, zero)));
+	return ~(zeroLo | (zeroHi << 4)) & 0xFF;
+}
+
+/**
+ * Returns number of zero bytes from right in each element (8 for zero element) multiplied by 8
+ */
+static inline __m256i trailingZeroBytesBits(__m256i x) {
+	// 0xFF for every zero byte
+	__m256i zeroBytes = _mm256_cmpeq_epi8(x, _mm256_setzero_si256());
+	// keep 0xFF only in bytes preceded (from right) by zero bytes only
+	zeroBytes = _mm256_and_si256(zeroBytes, _mm256_or_si256(_mm256_slli_epi64(zeroBytes, 8),
+	                                                        _mm256_set1_epi64x(0xFF)));
+	zeroBytes = _mm256_and_si256(zeroBytes, _mm256_or_si256(_mm256_slli_epi64(zeroBytes, 16),
+	                                                        _mm256_set1_epi64x(0xFFFF)));
+	zeroBytes = _mm256_and_si256(zeroBytes, _mm256_or_si256(_mm256_slli_epi64(zeroBytes, 32),
+	                                                        _mm256_set1_epi64x(0xFFFFFFFF)));
+	// count them
+	__m256i count = _mm256_sad_epu8(_mm256_and_si256(zeroBytes, _mm256_set1_epi8(1)),
+	                                _mm256_setzero_si256());
+	return _mm256_slli_epi64(count, 3);
+}
+
+/**
+ * Stores 4 values selected by mask to output, each squeezed to its lowest maxLength bytes.
+ * Writes up to 16 bytes past the stored values - these are overwritten by the following writes.
+ */
+static inline void storeSqueezed(char* output, __m256i values, int mask, int maxLength) {
+	__m256i compressed = _mm256_permutevar8x32_epi32(
+	    values, _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPRESS_PERMUTATIONS[mask])));
+	__m256i squeezed = _mm256_shuffle_epi8(
+	    compressed, _mm256_broadcastsi128_si256(
+	                    _mm_load_si128(reinterpret_cast<const __m128i*>(SQUEEZE_PAIR[maxLength]))));
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm256_castsi256_si128(squeezed));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * maxLength),
+	                 _mm256_extracti128_si256(squeezed, 1));
+}
+
+/**
+ * Comress block of data
+ */
+template <typename T>
+static inline void compressBlock(const T* data,
+                                 char* output,
+                                 size_t* outputIndex,
+                                 const size_t i,          // position within middle-out block
+                                 const __m128i vindexLo,  // indexes of values 0-3
+                                 const __m128i vindexHi,  // indexes of values 4-7
+                                 __m256i* prevLo,
+                                 __m256i* prevHi) {
+	const long long* base = reinterpret_cast<const long long*>(&data[i]);
+	__m256i currLo = _mm256_i32gather_epi64(base, vindexLo, 8);
+	__m256i currHi = _mm256_i32gather_epi64(base, vindexHi, 8);
+
+	__m256i xoredLo = _mm256_xor_si256(*prevLo, currLo);
+	__m256i xoredHi = _mm256_xor_si256(*prevHi, currHi);
+
+	// preserve previous data in vector registers
+	*prevLo = currLo;
+	*prevHi = currHi;
+
+	int notSame = notZeroMask(xoredLo, xoredHi);
+
+	// store "not same" metadata
+	output[(*outputIndex)++] = ~notSame;
+
+	if (notSame == 0) {
+		// skip if all values are the same as previous
+		return;
+	}
+
+	// bit per non-zero byte of all 8 xored values
+	__m256i zero = _mm256_setzero_si256();
+	uint64_t notZeroBytes =
+	    ~((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(xoredLo, zero)) |
+	      (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(xoredHi, zero)) << 32);
+
+	uint32_t compressedOffsets = 0;
+	int offsetsShift = 3;  // skip 3 bits for max length
+	int maxLength = 0;
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		uint32_t bytes = (notZeroBytes >> (8 * j)) & 0xFF;
+		// lowest and highest non-zero byte (0 for not stored values)
+		uint32_t rightOffsetBytes = __builtin_ctz(bytes | 0x100) & 7;
+		int highestByte = 31 - __builtin_clz(bytes | 1);
+
+		maxLength = std::max(maxLength, highestByte + 1 - (int)rightOffsetBytes);
+		compressedOffsets |= rightOffsetBytes << offsetsShift;
+		offsetsShift += 3 * (bytes != 0);
+	}
+
+	int* outAsInts = reinterpret_cast<int*>(&output[*outputIndex]);
+	// store offsets and max length
+	// -1 becasue we need to store only values 1-8, so 3 bits are enought
+	outAsInts[0] = compressedOffsets | (maxLength - 1);
+
+	int notSameLo = notSame & 0xF;
+	int notSameHi = notSame >> 4;
+	int notSameCountLo = __builtin_popcount(notSameLo);
+	int notSameCount = notSameCountLo + __builtin_popcount(notSameHi);
+
+	// +1 because first 3 bits are maxLength
+	*outputIndex += getBytesLengthOfOffsets(notSameCount + 1);
+
+	// align non-zero xored part to right
+	__m256i shiftedLo = _mm256_srlv_epi64(xoredLo, trailingZeroBytesBits(xoredLo));
+	__m256i shiftedHi = _mm256_srlv_epi64(xoredHi, trailingZeroBytesBits(xoredHi));
+
+	// high half overwrites garbage written behind the low half
+	char* out = &output[*outputIndex];
+	storeSqueezed(out, shiftedLo, notSameLo, maxLength);
+	storeSqueezed(out + notSameCountLo * maxLength, shiftedHi, notSameHi, maxLength);
+
+	*outputIndex += notSameCount * maxLength;
+}
+
+/*
+
+Middle-out compression
+
+*/
+template <typename T>
+size_t Avx2<T>::compress(const T* data, size_t count, char* output, size_t capacity) {
+	if (capacity < maxCompressedSize(count)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		// not enough data to compress
+		return doNotCompressTheData(data, count, output);
+	}
+
+	// skip first 8 init values
+	size_t outputIndex = sizeof(T) * VECTOR_SIZE;
+	// "middle-out" data block size
+	size_t blockSize = count / VECTOR_SIZE;
+	// just copy init reference values
+	fillStart(data, output, blockSize);
+
+	__m128i vindexLo = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(blockSize));
+	__m128i vindexHi = _mm_mullo_epi32(_mm_setr_epi32(4, 5, 6, 7), _mm_set1_epi32(blockSize));
+
+	const long long* base = reinterpret_cast<const long long*>(&data[0]);
+	__m256i prevLo = _mm256_i32gather_epi64(base, vindexLo, 8);
+	__m256i prevHi = _mm256_i32gather_epi64(base, vindexHi, 8);
+
+	// main compression loop
+	for (size_t i = 1; i < blockSize; i += 1) {
+		compressBlock(data, output, &outputIndex, i, vindexLo, vindexHi, &prevLo, &prevHi);
+	}
+
+	// write rest data without any compression
+	for (size_t i = blockSize * VECTOR_SIZE; i < count; i++) {
+		T* outAsLongs = reinterpret_cast<T*>(&output[outputIndex]);
+		outAsLongs[0] = data[i];
+		outputIndex += sizeof(T);
+	}
+
+	return writeTrailer(output, outputIndex);
+}
+
+//
+// DECOMPRESSION
+//
+
+/**
+ * Mask with all bits set in values selected by 4 bit mask
+ */
+static inline __m256i expandMask(int mask) {
+	__m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+	return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(mask), bits), bits);
+}
+
+/**
+ * Reads 4 values selected by mask, where ranks are positions of values within stored ones
+ */
+static inline __m256i readXored(const char* input,
+                                int mask,
+                                __m128i ranks,
+                                uint32_t compresedOffsetsAndMaxLength,
+                                __m256i clearTopBitMask,
+                                uint8_t maxLength) {
+	__m128i readShifts = _mm_mullo_epi32(ranks, _mm_set1_epi32(maxLength));
+	__m256i toXor = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(),
+	                                            reinterpret_cast<const long long*>(input),
+	                                            readShifts, expandMask(mask), 1);
+
+	// offset of value with rank r is stored on bits 3 + 3 * r
+	__m256i ranks64 = _mm256_cvtepu32_epi64(ranks);
+	__m256i offsetsShifts =
+	    _mm256_add_epi64(_mm256_set1_epi64x(3),
+	                     _mm256_add_epi64(ranks64, _mm256_slli_epi64(ranks64, 1)));
+	__m256i offsets = _mm256_and_si256(
+	    _mm256_srlv_epi64(_mm256_set1_epi64x(compresedOffsetsAndMaxLength), offsetsShifts),
+	    _mm256_set1_epi64x(0b111));
+
+	toXor = _mm256_and_si256(toXor, clearTopBitMask);
+	// position to xor (offset * 8)
+	return _mm256_sllv_epi64(toXor, _mm256_slli_epi64(offsets, 3));
+}
+
+/**
+ * Emulates 8 values scatter
+ */
+template <typename T>
+static inline void storeBlock(T* data,
+                              const size_t blockSize,
+                              const size_t i,
+                              __m256i lo,
+                              __m256i hi) {
+	uint64_t values[VECTOR_SIZE];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(&values[0]), lo);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(&values[4]), hi);
+
+	uint64_t* dataAsLongs = reinterpret_cast<uint64_t*>(data);
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		dataAsLongs[blockSize * j + i] = values[j];
+	}
+}
+
+template <bool NON_TEMPORAL, typename T>
+static inline void decompressBlock(const char* input,
+                                   T* data,
+                                   size_t* inputIndex,      // position within input data
+                                   const size_t blockSize,  // size of middle-out block
+                                   const size_t i,          // position within block
+                                   __m256i* prevLo,
+                                   __m256i* prevHi) {
+	// read mask of same values
+	uint8_t sameMask = input[(*inputIndex)++];
+
+	if (sameMask == 0b11111111) {
+		// all values are the same as previous ones (non-temporal rows are streamed by tiles)
+		if (!NON_TEMPORAL) {
+			storeBlock(data, blockSize, i, *prevLo, *prevHi);
+		}
+		return;
+	}
+
+	int notSame = ~sameMask & 0xFF;
+	int notSameLo = notSame & 0xF;
+	int notSameHi = notSame >> 4;
+
+	// read unaligned offsets, where offset = number of empty bytes from right in XORed value
+	uint32_t compresedOffsetsAndMaxLength =
+	    reinterpret_cast<const uint32_t*>(&input[*inputIndex])[0];
+	// +1 because only 3 bits are stored and valid lengths are 1-8
+	uint8_t maxLength = (compresedOffsetsAndMaxLength & 0b111) + 1;
+
+	int notSameCountLo = __builtin_popcount(notSameLo);
+	int notSameCount = notSameCountLo + __builtin_popcount(notSameHi);
+
+	// +1 because first 3 bits are maxLength
+	*inputIndex += getBytesLengthOfOffsets(notSameCount + 1);
+
+	__m128i ranksLo = _mm_load_si128(reinterpret_cast<const __m128i*>(EXPAND_RANKS[notSameLo]));
+	__m128i ranksHi =
+	    _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(EXPAND_RANKS[notSameHi])),
+	                  _mm_set1_epi32(notSameCountLo));
+
+	__m256i clearTopBitMask = _mm256_set1_epi64x(~((uint64_t)0) >> (64 - 8 * maxLength));
+
+	const char* in = &input[*inputIndex];
+	__m256i toXorLo = readXored(in, notSameLo, ranksLo, compresedOffsetsAndMaxLength,
+	                            clearTopBitMask, maxLength);
+	__m256i toXorHi = readXored(in, notSameHi, ranksHi, compresedOffsetsAndMaxLength,
+	                            clearTopBitMask, maxLength);
+
+	// not stored values are zeros
+	*prevLo = _mm256_xor_si256(*prevLo, toXorLo);
+	*prevHi = _mm256_xor_si256(*prevHi, toXorHi);
+
+	if (!NON_TEMPORAL) {
+		storeBlock(data, blockSize, i, *prevLo, *prevHi);
+	}
+
+	*inputIndex += notSameCount * maxLength;
+}
+
+template <bool NON_TEMPORAL, typename T>
+static void decompressData(const char* input, size_t inputElements, T* data) {
+	// not enough data to compress
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return doNotDecompressTheData(input, inputElements, data);
+	}
+
+	//"middle-out" block size
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	// copy first ref. values
+	for (size_t i = 0; i < VECTOR_SIZE; i++) {
+		data[blockSize * i] = (reinterpret_cast<const T*>(input))[i];
+	}
+
+	// skip first 8 init values
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE;
+
+	__m256i prevLo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&input[0]));
+	__m256i prevHi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&input[32]));
+
+	// rows collected for non-temporal stores
+	uint64_t row[VECTOR_SIZE];
+	uint64_t tile[VECTOR_SIZE][VECTOR_SIZE];
+	size_t tileRows = 0;
+
+	// main decompression loop
+	for (size_t i = 1; i < blockSize; i += 1) {
+		decompressBlock<NON_TEMPORAL>(input, data, &inputIndex, blockSize, i, &prevLo, &prevHi);
+		if (NON_TEMPORAL) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&row[0]), prevLo);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&row[4]), prevHi);
+			streamRow(data, blockSize, i, row, tile, &tileRows);
+		}
+	}
+
+	// copy rest of data (uncompressed)
+	for (size_t i = blockSize * VECTOR_SIZE; i < inputElements; i++) {
+		data[i] = (reinterpret_cast<const T*>(&input[inputIndex]))[0];
+		inputIndex += sizeof(T);
+	}
+}
+
+template <typename T>
+void Avx2<T>::decompress(const char* input, size_t inputElements, T* data) {
+	decompressData<false>(input, inputElements, data);
+}
+
+template <typename T>
+void Avx2<T>::decompressNonTemporal(const char* input, size_t inputElements, T* data) {
+	decompressData<true>(input, inputElements, data);
+	_mm_sfence();
+}
+
+}  // end namespace middleout
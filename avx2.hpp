@@ -0,0 +1,57 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+#include <memory>
+
+#ifndef AVX2_H
+#define AVX2_H
+
+namespace middleout {
+
+template <typename T>
+
+class Avx2 {
+	static_assert(sizeof(T) == 8, "Must use datatype with length of 8 bytes.");
+
+   public:
+	Avx2();
+
+	static std::unique_ptr<std::vector<char>> compressSimple(std::vector<T>& data);
+
+	static size_t compress(std::vector<T>& data, std::vector<char>& output);
+
+	/*
+	 Compresses count values to output. Returns 0 (nothing written) if capacity is less than
+	 maxCompressedSize(count).
+	*/
+	static size_t compress(const T* data, size_t count, char* output, size_t capacity);
+
+	static void decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data);
+
+	static void decompress(const char* input, size_t itemsCount, T* data);
+
+	// writes data by non-temporal stores (bypassing caches)
+	static void decompressNonTemporal(const char* input, size_t itemsCount, T* data);
+
+	static size_t maxCompressedSize(size_t count) {
+		size_t blockCount = count / 8;
+		// 8*8            : init reference values
+		// 5*blockClount  : max size of block headers
+		// 8*8*blockCount : max size of xored data: 8 bytes * 8 values
+		// 8*(count%8)    : uncompressed rest of values
+		return 8 * 8 + blockCount * 5 + 8 * 8 * blockCount + 8 * (count % 8);
+	}
+};
+
+}  // end namespace middleout
+
+#endif /* AVX2_H */
\ No newline at end of file
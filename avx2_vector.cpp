@@ -0,0 +1,52 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "avx2.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace middleout {
+
+/*
+ std::vector wrappers of the Avx2 kernel, compiled for the scalar target (see Makefile). std
+ templates they instantiate are weak symbols the linker may take from any object, so objects built
+ for vector targets must not instantiate them.
+*/
+template <typename T>
+std::unique_ptr<std::vector<char>> Avx2<T>::compressSimple(std::vector<T>& data) {
+	std::unique_ptr<std::vector<char>> compressed(
+	    new std::vector<char>(Avx2<T>::maxCompressedSize(data.size())));
+	size_t size = Avx2<T>::compress(data, *compressed);
+	compressed->resize(size);
+	compressed->shrink_to_fit();
+	return compressed;
+}
+
+template <typename T>
+size_t Avx2<T>::compress(std::vector<T>& data, std::vector<char>& output) {
+	return Avx2<T>::compress(data.data(), data.size(), output.data(), output.size());
+}
+
+template <typename T>
+void Avx2<T>::decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data) {
+	Avx2<T>::decompress(input.data(), itemsCount, data.data());
+}
+
+template std::unique_ptr<std::vector<char>> Avx2<double>::compressSimple(std::vector<double>&);
+template size_t Avx2<double>::compress(std::vector<double>&, std::vector<char>&);
+template void Avx2<double>::decompress(std::vector<char>&, size_t, std::vector<double>&);
+template std::unique_ptr<std::vector<char>> Avx2<int64_t>::compressSimple(std::vector<int64_t>&);
+template size_t Avx2<int64_t>::compress(std::vector<int64_t>&, std::vector<char>&);
+template void Avx2<int64_t>::decompress(std::vector<char>&, size_t, std::vector<int64_t>&);
+template std::unique_ptr<std::vector<char>> Avx2<uint64_t>::compressSimple(std::vector<uint64_t>&);
+template size_t Avx2<uint64_t>::compress(std::vector<uint64_t>&, std::vector<char>&);
+template void Avx2<uint64_t>::decompress(std::vector<char>&, size_t, std::vector<uint64_t>&);
+
+}  // end namespace middleout
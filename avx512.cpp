@@ -24,20 +24,10 @@ template class Avx52<uint64_t>;
 template <typename T>
 Avx52<T>::Avx52() {}
 
-template <typename T>
-std::unique_ptr<std::vector<char>> Avx52<T>::compressSimple(std::vector<T>& data) {
-	std::unique_ptr<std::vector<char>> compressed(
-	    new std::vector<char>(Avx52<T>::maxCompressedSize(data.size())));
-	size_t size = Avx52<T>::compress(data, *compressed);
-	compressed->resize(size);
-	compressed->shrink_to_fit();
-	return compressed;
-}
-
 /**
  * return length in bytes within left zeros and right zeros
  */
-inline __m512i byteLength(__mmask8 mask, __m512i leftOffset, __m512i rightOffset) {
+static inline __m512i byteLength(__mmask8 mask, __m512i leftOffset, __m512i rightOffset) {
 	// return 8 - (leftOffset + rightOffset);
 	__m512i baseLength = _mm512_set1_epi64(8);
 	__m512i offsetsSum = _mm512_add_epi64(leftOffset, rightOffset);
@@ -46,7 +36,7 @@ inline __m512i byteLength(__mmask8 mask, __m512i leftOffset, __m512i rightOffset
 /**
  * From number of bits, computes number of bytes (bytes). E.g. bits/8
  */
-inline __m512i byteRound(__m512i x) {
+static inline __m512i byteRound(__m512i x) {
 	//	return x >> 3;
 	return _mm512_srli_epi64(x, 3);
 }
@@ -54,7 +44,7 @@ inline __m512i byteRound(__m512i x) {
 /**
  * Compresses offsets. Skip offsets by mask. Using 3bits per one offset
  */
-inline int compressOffsets(__mmask8 notSame, __m512i offsets) {
+static inline int compressOffsets(__mmask8 notSame, __m512i offsets) {
 	// shift each offset to correct position
 	__m512i compressed = _mm512_maskz_compress_epi64(notSame, offsets);
 	// shift within one vector to final position
@@ -68,7 +58,7 @@ inline int compressOffsets(__mmask8 notSame, __m512i offsets) {
 /**
  * Reverses bytes within elements of vector
  */
-inline __m512i byte_reverse_within_epi64(__m512i a) {
+static inline __m512i byte_reverse_within_epi64(__m512i a) {
 	// set *EPI16* positions for permutations
 	__m512i idx = _mm512_set_epi32(28 << 16 | 29, 30 << 16 | 31,  //
 	                               24 << 16 | 25, 26 << 16 | 27,  //
@@ -101,18 +91,62 @@ inline __m512i byte_reverse_within_epi64(__m512i a) {
 }
 
 /**
- * Comress block of data
+ * Transposes 8x8 tile of 64bit elements: element j of vector k is moved to element k of vector j
  */
-template <typename T>
-inline void compressBlock(std::vector<T>& data,
-                          std::vector<char>& output,
-                          size_t blockSize,  // size of one middle-out block
-                          size_t* outputIndex,
-                          const size_t i,        // position within middle-out block
-                          const __m256i vindex,  // indexes within middle-out block
-                          __m512i* prev) {
-	__m512i curr = _mm512_i32gather_epi64(vindex, &data[i], 8);
+static inline void transpose8x8(__m512i* tile) {
+	// pairs of rows interleaved: 0 1 0 1 ...
+	__m512i t0 = _mm512_unpacklo_epi64(tile[0], tile[1]);
+	__m512i t1 = _mm512_unpackhi_epi64(tile[0], tile[1]);
+	__m512i t2 = _mm512_unpacklo_epi64(tile[2], tile[3]);
+	__m512i t3 = _mm512_unpackhi_epi64(tile[2], tile[3]);
+	__m512i t4 = _mm512_unpacklo_epi64(tile[4], tile[5]);
+	__m512i t5 = _mm512_unpackhi_epi64(tile[4], tile[5]);
+	__m512i t6 = _mm512_unpacklo_epi64(tile[6], tile[7]);
+	__m512i t7 = _mm512_unpackhi_epi64(tile[6], tile[7]);
 
+	// quads of rows: 0 1 2 3 in each 256bit half
+	__m512i evenPairs = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+	__m512i oddPairs = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+	__m512i u0 = _mm512_permutex2var_epi64(t0, evenPairs, t2);
+	__m512i u1 = _mm512_permutex2var_epi64(t1, evenPairs, t3);
+	__m512i u2 = _mm512_permutex2var_epi64(t0, oddPairs, t2);
+	__m512i u3 = _mm512_permutex2var_epi64(t1, oddPairs, t3);
+	__m512i u4 = _mm512_permutex2var_epi64(t4, evenPairs, t6);
+	__m512i u5 = _mm512_permutex2var_epi64(t5, evenPairs, t7);
+	__m512i u6 = _mm512_permutex2var_epi64(t4, oddPairs, t6);
+	__m512i u7 = _mm512_permutex2var_epi64(t5, oddPairs, t7);
+
+	// low halves of quads hold elements 0 - 3, high halves elements 4 - 7
+	tile[0] = _mm512_shuffle_i64x2(u0, u4, 0x44);
+	tile[1] = _mm512_shuffle_i64x2(u1, u5, 0x44);
+	tile[2] = _mm512_shuffle_i64x2(u2, u6, 0x44);
+	tile[3] = _mm512_shuffle_i64x2(u3, u7, 0x44);
+	tile[4] = _mm512_shuffle_i64x2(u0, u4, 0xEE);
+	tile[5] = _mm512_shuffle_i64x2(u1, u5, 0xEE);
+	tile[6] = _mm512_shuffle_i64x2(u2, u6, 0xEE);
+	tile[7] = _mm512_shuffle_i64x2(u3, u7, 0xEE);
+}
+
+/**
+ * Exclusive prefix sum of elements, e.g. positions of values of given lengths stored one after
+ * another
+ */
+static inline __m512i exclusivePrefixSum(__m512i x) {
+	__m512i zero = _mm512_setzero_si512();
+	// elements shifted up by 1, 2 and 4 positions
+	__m512i sum = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 7));
+	sum = _mm512_add_epi64(sum, _mm512_alignr_epi64(sum, zero, 6));
+	sum = _mm512_add_epi64(sum, _mm512_alignr_epi64(sum, zero, 4));
+	return _mm512_sub_epi64(sum, x);
+}
+
+/**
+ * Comress block of data
+ */
+static inline void compressBlock(char* output,
+                                 size_t* outputIndex,
+                                 const __m512i curr,  // values of row, one per middle-out block
+                                 __m512i* prev) {
 	__m512i xored = _mm512_xor_epi64(*prev, curr);
 	__mmask8 notSame = _mm512_cmp_epi64_mask(xored, _mm512_set1_epi64(0), _MM_CMPINT_NE);
 
@@ -168,75 +202,371 @@ inline void compressBlock(std::vector<T>& data,
 	*prev = curr;
 }
 
+/**
+ * Compress block of data as adaptive row (see helpers.hpp), same output as compressAdaptiveRow
+ */
+static inline void compressBlockAdaptive(char* output,
+                                         size_t* outputIndex,
+                                         const __m512i curr,  // values of row
+                                         __m512i* prev,
+                                         size_t* unchangedRows) {
+	__m512i xored = _mm512_xor_epi64(*prev, curr);
+	__mmask8 notSame = _mm512_cmp_epi64_mask(xored, _mm512_set1_epi64(0), _MM_CMPINT_NE);
+
+	if (notSame == 0) {
+		// written as a row or run-length token before the next changed row
+		(*unchangedRows)++;
+		return;
+	}
+	*outputIndex += writeUnchangedRows(&output[*outputIndex], *unchangedRows);
+	*unchangedRows = 0;
+	output[(*outputIndex)++] = ~notSame;
+
+	int notSameCount = __builtin_popcount(notSame);
+	// stored values are compressed to the lowest elements
+	__mmask8 stored = (1 << notSameCount) - 1;
+
+	__m512i leadingZeros = _mm512_maskz_lzcnt_epi64(notSame, xored);
+	__m512i trailingZeros = _mm512_maskz_lzcnt_epi64(notSame, byte_reverse_within_epi64(xored));
+	__m512i leftOffsetBytes = byteRound(leadingZeros);
+	__m512i rightOffsetBytes = byteRound(trailingZeros);
+	__m512i lengthBytes = byteLength(notSame, leftOffsetBytes, rightOffsetBytes);
+
+	int maxLength = (int)_mm512_reduce_max_epi64(lengthBytes);
+	int lengthsSum = (int)_mm512_reduce_add_epi64(lengthBytes);
+	// zero bytes shared by all stored values
+	int minLeftOffset = (int)_mm512_mask_reduce_min_epi64(notSame, leftOffsetBytes);
+	int minRightOffset = (int)_mm512_mask_reduce_min_epi64(notSame, rightOffsetBytes);
+	int leadingLength = 8 - minLeftOffset - minRightOffset;
+
+	int sharedSize = getBytesLengthOfSharedHeader(notSameCount) + notSameCount * maxLength;
+	int leadingSize = ADAPTIVE_LEADING_HEADER_SIZE + notSameCount * leadingLength;
+	int lanesSize = getBytesLengthOfLanesHeader(notSameCount) + lengthsSum;
+
+	// values aligned to right, each by its offset or all by the shared one (leading-aligned)
+	__m512i shifts = _mm512_slli_epi64(rightOffsetBytes, 3);
+	if (leadingSize < sharedSize && leadingSize <= lanesSize) {
+		shifts = _mm512_set1_epi64(8 * minRightOffset);
+	}
+	__m512i compressedXoredShifted =
+	    _mm512_maskz_compress_epi64(notSame, _mm512_srlv_epi64(xored, shifts));
+
+	uint64_t header;
+	__m512i storeBase;
+	if (lanesSize < std::min(sharedSize, leadingSize)) {
+		// length - 1 | offset << 3 of each stored value, 6 bits each after the mode bit
+		__m512i fields = _mm512_maskz_compress_epi64(
+		    notSame, _mm512_or_epi64(_mm512_sub_epi64(lengthBytes, _mm512_set1_epi64(1)),
+		                             _mm512_slli_epi64(rightOffsetBytes, 3)));
+		fields = _mm512_sllv_epi64(fields, _mm512_setr_epi64(1, 7, 13, 19, 25, 31, 37, 43));
+		header = _mm512_reduce_or_epi64(fields) | ADAPTIVE_LANES;
+
+		memcpy(&output[*outputIndex], &header, sizeof(header));
+		*outputIndex += getBytesLengthOfLanesHeader(notSameCount);
+		storeBase = exclusivePrefixSum(_mm512_maskz_compress_epi64(notSame, lengthBytes));
+	} else if (leadingSize < sharedSize) {
+		output[(*outputIndex)++] =
+		    ADAPTIVE_LEADING | (leadingLength - 1) << 2 | minLeftOffset << 5;
+		storeBase = _mm512_mullo_epi64(_mm512_set1_epi64(leadingLength),
+		                               _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+		lengthsSum = notSameCount * leadingLength;
+	} else {
+		// offsets and max length as in compressBlock, after the mode bits
+		header = (uint64_t)(compressOffsets(notSame, rightOffsetBytes) | (maxLength - 1)) << 2;
+
+		memcpy(&output[*outputIndex], &header, sizeof(header));
+		*outputIndex += getBytesLengthOfSharedHeader(notSameCount);
+		storeBase = _mm512_mullo_epi64(_mm512_set1_epi64(maxLength),
+		                               _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+		lengthsSum = notSameCount * maxLength;
+	}
+
+	// only stored values are scattered, stores are done in strong order (overlapping)
+	_mm512_mask_i64scatter_epi64(&output[*outputIndex], stored, storeBase, compressedXoredShifted,
+	                             1);
+	*outputIndex += lengthsSum;
+
+	*prev = curr;
+}
+
+//
+// CHECKSUM (see helpers.hpp)
+//
+
+struct RowHashVector {
+	__m512i accumulators;
+	__m512i keys;
+};
+
+static inline void initRowHash(RowHashVector* hash) {
+	hash->accumulators = _mm512_setzero_si512();
+	hash->keys = _mm512_mullo_epi64(_mm512_set1_epi64(HASH_PRIME_2),
+	                                _mm512_setr_epi64(1, 2, 3, 4, 5, 6, 7, 8));
+}
+
+static inline void hashRow(RowHashVector* hash, __m512i row) {
+	__m512i keyed = _mm512_xor_si512(row, hash->keys);
+	// product of 32bit halves
+	__m512i product = _mm512_mul_epu32(keyed, _mm512_srli_epi64(keyed, 32));
+	__m512i rotated = _mm512_rol_epi64(hash->accumulators, HASH_ROTATION);
+	hash->accumulators = _mm512_add_epi64(rotated, _mm512_add_epi64(product, row));
+	hash->keys = _mm512_add_epi64(hash->keys, _mm512_set1_epi64(HASH_PRIME_1));
+}
+
+template <bool ADAPTIVE>
+static inline void compressAnyBlock(char* output,
+                                    size_t* outputIndex,
+                                    const __m512i curr,
+                                    __m512i* prev,
+                                    size_t* unchangedRows) {
+	if (ADAPTIVE) {
+		compressBlockAdaptive(output, outputIndex, curr, prev, unchangedRows);
+	} else {
+		compressBlock(output, outputIndex, curr, prev);
+	}
+}
+
+/*
+ Vectorized getTruncatedBitsCount, mask of kept bits of 8 values
+*/
+static inline __m512i getTruncationMask(__m512i values, ErrorBoundMode mode, __m512i base) {
+	const __m512i zero = _mm512_setzero_si512();
+	__m512i exponents = _mm512_and_si512(_mm512_srli_epi64(values, DOUBLE_MANTISSA_BITS),
+	                                     _mm512_set1_epi64(DOUBLE_EXPONENT_MASK));
+
+	__m512i truncated;
+	if (mode == ERROR_BOUND_RELATIVE) {
+		// subnormal values are kept
+		truncated = _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(exponents, exponents), base);
+	} else {
+		truncated = _mm512_sub_epi64(base, _mm512_max_epi64(exponents, _mm512_set1_epi64(1)));
+		__mmask8 magnitude =
+		    _mm512_cmpgt_epi64_mask(truncated, _mm512_set1_epi64(DOUBLE_MANTISSA_BITS));
+		truncated = _mm512_mask_mov_epi64(truncated, magnitude,
+		                                  _mm512_set1_epi64(TRUNCATED_MAGNITUDE));
+	}
+	truncated = _mm512_max_epi64(truncated, zero);
+
+	// infinities and NaNs are kept
+	__mmask8 special = _mm512_cmpeq_epi64_mask(exponents, _mm512_set1_epi64(DOUBLE_EXPONENT_MASK));
+	truncated = _mm512_mask_mov_epi64(truncated, special, zero);
+	return _mm512_sllv_epi64(_mm512_set1_epi64(-1), truncated);
+}
+
+/*
+ Values truncated within bound by mask of getTruncationMask (LOSSY only)
+*/
+template <bool LOSSY>
+static inline __m512i truncateRow(__m512i values, ErrorBoundMode mode, __m512i base) {
+	if (!LOSSY) {
+		return values;
+	}
+	return _mm512_and_si512(values, getTruncationMask(values, mode, base));
+}
+
+/*
+ Vectorized encodeDeltaRow (see helpers.hpp), values and deltas of the previous row are kept in
+ registers
+*/
+template <Transform TRANSFORM>
+static inline __m512i encodeDeltaVector(__m512i row, __m512i* values, __m512i* deltas) {
+	if (TRANSFORM == TRANSFORM_NONE) {
+		return row;
+	}
+	__m512i delta = _mm512_sub_epi64(row, *values);
+	*values = row;
+	__m512i encoded = delta;
+	if (TRANSFORM == TRANSFORM_DELTA_OF_DELTA) {
+		encoded = _mm512_sub_epi64(delta, *deltas);
+		*deltas = delta;
+	}
+	// zigzag
+	return _mm512_xor_si512(_mm512_slli_epi64(encoded, 1), _mm512_srai_epi64(encoded, 63));
+}
+
 /*
 
 Middle-out compression
 
 */
-template <typename T>
-size_t Avx52<T>::compress(std::vector<T>& data, std::vector<char>& output) {
-	if (data.size() <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+template <bool ADAPTIVE, bool CHECKSUM, bool LOSSY, Transform TRANSFORM, typename T>
+static size_t compressData(const T* data,
+                           size_t count,
+                           char* output,
+                           size_t capacity,
+                           ErrorBound bound = LOSSLESS) {
+	static_assert(!(ADAPTIVE && CHECKSUM), "Adaptive rows are not checksummed.");
+	static_assert(!(CHECKSUM && LOSSY), "Truncated values are not checksummed.");
+	static_assert(TRANSFORM == TRANSFORM_NONE || !(ADAPTIVE || CHECKSUM || LOSSY),
+	              "Only plain rows are transformed.");
+
+	if (capacity < Avx52<T>::maxCompressedSize(count)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
 		// not enough data to compress
-		return doNotCompressTheData(data, output);
+		if (LOSSY) {
+			Avx52<T>::truncatePrecision(data, count, reinterpret_cast<T*>(output), bound);
+			return sizeof(T) * count;
+		}
+		return doNotCompressTheData(data, count, output);
 	}
 
 	// skip first 8 init values
 	size_t outputIndex = sizeof(T) * VECTOR_SIZE;
 	// "middle-out" data block size
-	size_t blockSize = data.size() / VECTOR_SIZE;
+	size_t blockSize = count / VECTOR_SIZE;
 	// just copy init reference values
 	fillStart(data, output, blockSize);
 
 	__m256i vindex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
 	vindex = _mm256_mullo_epi32(vindex, _mm256_set1_epi32(blockSize));
 
+	// lossy values are truncated as they are loaded, before XOR with the previous row
+	__m512i truncationBase = _mm512_set1_epi64(getTruncationBase(bound));
 	__m512i prev = _mm512_i32gather_epi64(vindex, &data[0], 8);
+	if (LOSSY) {
+		prev = truncateRow<LOSSY>(prev, bound.mode, truncationBase);
+		_mm512_storeu_si512(output, prev);
+	}
+	// adaptive rows only
+	size_t unchangedRows = 0;
+	// transform state, reference values are kept
+	__m512i values = prev;
+	__m512i deltas = _mm512_setzero_si512();
+
+	// checksum of values by rows, reference values are the row 0
+	RowHashVector hash;
+	if (CHECKSUM) {
+		initRowHash(&hash);
+		hashRow(&hash, prev);
+	}
+
+	// main compression loop, by tiles of 8 rows: 8 contiguous loads (cache lines of one segment
+	// each) transposed to rows are much cheaper than 8 gathers touching 8 lines each
+	size_t i = 1;
+	for (; i + VECTOR_SIZE <= blockSize; i += VECTOR_SIZE) {
+		prefetchRows<PREFETCH_READ>(data, blockSize, i);
+
+		__m512i tile[VECTOR_SIZE];
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			tile[j] = truncateRow<LOSSY>(_mm512_loadu_si512(&data[blockSize * j + i]), bound.mode,
+			                             truncationBase);
+		}
+		transpose8x8(tile);
+
+		for (size_t row = 0; row < VECTOR_SIZE; row++) {
+			if (CHECKSUM) {
+				hashRow(&hash, tile[row]);
+			}
+			__m512i curr = encodeDeltaVector<TRANSFORM>(tile[row], &values, &deltas);
+			compressAnyBlock<ADAPTIVE>(output, &outputIndex, curr, &prev, &unchangedRows);
+		}
+	}
 
-	// main compression loop
-	for (size_t i = 1; i < blockSize; i += 1) {
-		compressBlock(data, output, blockSize, &outputIndex, i, vindex, &prev);
+	// rest of rows
+	for (; i < blockSize; i++) {
+		__m512i curr = truncateRow<LOSSY>(_mm512_i32gather_epi64(vindex, &data[i], 8), bound.mode,
+		                                  truncationBase);
+		if (CHECKSUM) {
+			hashRow(&hash, curr);
+		}
+		curr = encodeDeltaVector<TRANSFORM>(curr, &values, &deltas);
+		compressAnyBlock<ADAPTIVE>(output, &outputIndex, curr, &prev, &unchangedRows);
 	}
+	outputIndex += writeUnchangedRows(&output[outputIndex], unchangedRows);
 
 	// write rest data without any compression
-	for (size_t i = blockSize * VECTOR_SIZE; i < data.size(); i++) {
+	for (size_t i = blockSize * VECTOR_SIZE; i < count; i++) {
 		T* outAsLongs = reinterpret_cast<T*>(&output[outputIndex]);
 		outAsLongs[0] = data[i];
 		outputIndex += sizeof(T);
 	}
+	if (LOSSY) {
+		size_t restCount = count - blockSize * VECTOR_SIZE;
+		T* rest = reinterpret_cast<T*>(&output[outputIndex - sizeof(T) * restCount]);
+		Avx52<T>::truncatePrecision(rest, restCount, rest, bound);
+	}
+
+	if (CHECKSUM) {
+		uint64_t accumulators[VECTOR_SIZE];
+		_mm512_storeu_si512(accumulators, hash.accumulators);
+		uint32_t checksum = finishRowHash(accumulators, &data[blockSize * VECTOR_SIZE], count);
+		return writeChecksumTrailer(output, outputIndex, checksum);
+	}
+	return writeTrailer(output, outputIndex);
+}
+
+template <typename T>
+size_t Avx52<T>::compress(const T* data, size_t count, char* output, size_t capacity) {
+	return compressData<false, false, false, TRANSFORM_NONE>(data, count, output, capacity);
+}
+
+template <typename T>
+size_t Avx52<T>::compressChecksummed(const T* data, size_t count, char* output, size_t capacity) {
+	return compressData<false, true, false, TRANSFORM_NONE>(data, count, output, capacity);
+}
 
-	// write compress algorithm version and datatype constant
-	output[outputIndex++] = 0x7E;  //== 0b01111110
+template <typename T>
+size_t Avx52<T>::compressAdaptive(const T* data, size_t count, char* output, size_t capacity) {
+	return compressData<true, false, false, TRANSFORM_NONE>(data, count, output, capacity);
+}
+
+template <typename T>
+size_t Avx52<T>::compressLossy(const T* data,
+                               size_t count,
+                               char* output,
+                               size_t capacity,
+                               ErrorBound bound) {
+	if (!isValidErrorBound(bound)) {
+		return 0;
+	}
+	return compressData<false, false, true, TRANSFORM_NONE>(data, count, output, capacity, bound);
+}
 
-	// to avoid access to invalid memory on decompression
-	return outputIndex + 6;
+template <typename T>
+size_t Avx52<T>::compressTransformed(const T* data,
+                                     size_t count,
+                                     char* output,
+                                     size_t capacity,
+                                     Transform transform) {
+	switch (transform) {
+		case TRANSFORM_DELTA:
+			return compressData<false, false, false, TRANSFORM_DELTA>(data, count, output,
+			                                                         capacity);
+		case TRANSFORM_DELTA_OF_DELTA:
+			return compressData<false, false, false, TRANSFORM_DELTA_OF_DELTA>(data, count, output,
+			                                                                  capacity);
+		default:
+			return compress(data, count, output, capacity);
+	}
 }
 
 //
 // DECOMPRESSION
 //
-template <typename T>
-inline void decompressBlock(std::vector<char>& input,
-                            size_t inputElements,
-                            std::vector<T>& data,
-                            size_t* inputIndex,      // position within input data
-                            const size_t blockSize,  // size of middle-out block
-                            const size_t i,          // position within block
-                            const __m256i vindex,    // vector of output data indexes
-                            __m512i* prev) {
+
+/*
+ Decompresses row to prev, values of row are stored by caller
+*/
+static inline void decompressBlock(const char* input,
+                                   size_t* inputIndex,  // position within input data
+                                   __m512i* prev) {
 	// read mask of same values
 	uint8_t sameMask = input[(*inputIndex)++];
 
 	if (sameMask == 0b11111111) {
 		// all values are the same as previous ones
-		// simple store prev elements
-		_mm512_i32scatter_epi64(&data[i], vindex, *prev, 8);
 		return;
 	}
 
 	__mmask8 notSameMask = ~sameMask;
 
 	// read unaligned offsets, where offset = number of empty bytes from right in XORed value
-	uint32_t compresedOffsetsAndMaxLength = reinterpret_cast<uint32_t*>(&input[*inputIndex])[0];
+	uint32_t compresedOffsetsAndMaxLength =
+	    reinterpret_cast<const uint32_t*>(&input[*inputIndex])[0];
 	// +1 because only 3 bits are stored and valid lengths are 1-8
 	uint8_t maxLength = (compresedOffsetsAndMaxLength & 0b111) + 1;
 
@@ -278,24 +608,183 @@ inline void decompressBlock(std::vector<char>& input,
 	toXor = _mm512_sllv_epi64(toXor, offsets);
 	__m512i xored = _mm512_mask_xor_epi64(*prev, notSameMask, *prev, toXor);
 
-	_mm512_i32scatter_epi64(&data[i], vindex, xored, 8);
-
-	*inputIndex += (sizeof(T) - sameCount) * maxLength;
+	*inputIndex += notSameCount * maxLength;
 	*prev = xored;
 }
 
-template <typename T>
-void Avx52<T>::decompress(std::vector<char>& input, size_t inputElements, std::vector<T>& data) {
+/*
+ Same as decompressBlock, reads nothing behind rowsEnd and the trailer. Returns false if the row
+ does not fit in front of rowsEnd.
+*/
+static inline bool decompressBlockSafe(const char* input,
+                                       size_t* inputIndex,
+                                       size_t rowsEnd,
+                                       __m512i* prev) {
+	if (*inputIndex + MAX_ROW_LENGTH <= rowsEnd) {
+		decompressBlock(input, inputIndex, prev);
+		return true;
+	}
+
+	// last rows are decoded from a padded copy
+	char padded[MAX_ROW_LENGTH + ROW_READ_AHEAD];
+	size_t length = padRow(&input[*inputIndex], rowsEnd - *inputIndex, padded);
+	if (length == 0) {
+		return false;
+	}
+	size_t paddedIndex = 0;
+	decompressBlock(padded, &paddedIndex, prev);
+	*inputIndex += length;
+	return true;
+}
+
+/*
+ Decompresses adaptive row (see helpers.hpp) to prev
+*/
+static inline void decompressBlockAdaptive(const char* input,
+                                           size_t* inputIndex,
+                                           __m512i* prev,
+                                           size_t rowsLeft,  // rows from this one to block end
+                                           size_t* runLeft) {
+	if (*runLeft) {
+		// in run of unchanged rows
+		(*runLeft)--;
+		return;
+	}
+
+	uint8_t sameMask = input[*inputIndex];
+	if (sameMask == 0b11111111) {
+		size_t rows;
+		*inputIndex += readUnchangedRows(&input[*inputIndex], rowsLeft, &rows);
+		*runLeft = rows - 1;
+		return;
+	}
+	(*inputIndex)++;
+
+	__mmask8 notSameMask = ~sameMask;
+	int notSameCount = 8 - __builtin_popcount(sameMask);
+	// stored values are read to the lowest elements, expanded to their segments at the end
+	__mmask8 stored = (1 << notSameCount) - 1;
+
+	uint64_t header;
+	memcpy(&header, &input[*inputIndex], sizeof(header));
+
+	__m512i lengths;
+	__m512i offsets;
+	__m512i readShifts;
+	if (header & ADAPTIVE_LANES) {
+		*inputIndex += getBytesLengthOfLanesHeader(notSameCount);
+		__m512i fields = _mm512_srlv_epi64(_mm512_set1_epi64(header),
+		                                   _mm512_setr_epi64(1, 7, 13, 19, 25, 31, 37, 43));
+		// +1 because only 3 bits are stored and valid lengths are 1-8
+		lengths = _mm512_maskz_add_epi64(stored, _mm512_and_epi64(fields, _mm512_set1_epi64(7)),
+		                                 _mm512_set1_epi64(1));
+		offsets = _mm512_and_epi64(_mm512_srli_epi64(fields, 3), _mm512_set1_epi64(7));
+		readShifts = exclusivePrefixSum(lengths);
+	} else {
+		int maxLength = ((header >> 2) & 0b111) + 1;
+		lengths = _mm512_maskz_mov_epi64(stored, _mm512_set1_epi64(maxLength));
+		if (header & ADAPTIVE_LEADING) {
+			*inputIndex += ADAPTIVE_LEADING_HEADER_SIZE;
+			offsets = _mm512_set1_epi64(8 - ((header >> 5) & 0b111) - maxLength);
+		} else {
+			*inputIndex += getBytesLengthOfSharedHeader(notSameCount);
+			offsets = _mm512_and_epi64(
+			    _mm512_srlv_epi64(_mm512_set1_epi64(header),
+			                      _mm512_setr_epi64(5, 8, 11, 14, 17, 20, 23, 26)),
+			    _mm512_set1_epi64(7));
+		}
+		readShifts = _mm512_mullo_epi64(_mm512_set1_epi64(maxLength),
+		                                _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+	}
+
+	__m512i toXor = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), stored, readShifts,
+	                                            &input[*inputIndex], 1);
+	// clear bytes behind each value's length (all of not stored ones), position it
+	__m512i lengthMasks =
+	    _mm512_srlv_epi64(_mm512_set1_epi64(~0),
+	                      _mm512_sub_epi64(_mm512_set1_epi64(64), _mm512_slli_epi64(lengths, 3)));
+	toXor = _mm512_sllv_epi64(_mm512_and_epi64(toXor, lengthMasks), _mm512_slli_epi64(offsets, 3));
+
+	*prev = _mm512_xor_epi64(*prev, _mm512_maskz_expand_epi64(notSameMask, toXor));
+	*inputIndex += _mm512_reduce_add_epi64(lengths);
+}
+
+template <bool ADAPTIVE>
+static inline void decompressAnyBlock(const char* input,
+                                      size_t* inputIndex,
+                                      __m512i* prev,
+                                      size_t rowsLeft,
+                                      size_t* runLeft) {
+	if (ADAPTIVE) {
+		decompressBlockAdaptive(input, inputIndex, prev, rowsLeft, runLeft);
+	} else {
+		decompressBlock(input, inputIndex, prev);
+	}
+}
+
+/*
+ Reverts encodeDeltaVector, values and deltas are the same state of the previous rows
+*/
+template <Transform TRANSFORM>
+static inline __m512i decodeDeltaVector(__m512i row, __m512i* values, __m512i* deltas) {
+	if (TRANSFORM == TRANSFORM_NONE) {
+		return row;
+	}
+	// zigzag
+	__m512i decoded = _mm512_xor_si512(
+	    _mm512_srli_epi64(row, 1),
+	    _mm512_sub_epi64(_mm512_setzero_si512(), _mm512_and_si512(row, _mm512_set1_epi64(1))));
+	if (TRANSFORM == TRANSFORM_DELTA_OF_DELTA) {
+		*deltas = _mm512_add_epi64(*deltas, decoded);
+		decoded = *deltas;
+	}
+	*values = _mm512_add_epi64(*values, decoded);
+	return *values;
+}
+
+/*
+ Stores 8 consecutive values of a segment. Non-temporal vector store needs 64 bytes alignment,
+ unaligned segments are stored value by value.
+*/
+template <bool NON_TEMPORAL, typename T>
+static inline void storeSegment(T* address, __m512i values) {
+	if (!NON_TEMPORAL) {
+		_mm512_storeu_si512(address, values);
+	} else if ((reinterpret_cast<uintptr_t>(address) & 63) == 0) {
+		_mm512_stream_si512(reinterpret_cast<__m512i*>(address), values);
+	} else {
+		uint64_t buffer[VECTOR_SIZE];
+		_mm512_storeu_si512(buffer, values);
+		for (size_t k = 0; k < VECTOR_SIZE; k++) {
+			streamValue(&address[k], buffer[k]);
+		}
+	}
+}
+
+/*
+ Returns position of the trailer, values are hashed to hash if CHECKSUM is set. Transformed rows
+ are reverted while decoding.
+*/
+template <bool NON_TEMPORAL, bool ADAPTIVE, bool CHECKSUM, Transform TRANSFORM, typename T>
+static size_t decompressData(const char* input,
+                             size_t inputElements,
+                             T* data,
+                             RowHashVector* hash) {
+	static_assert(!(ADAPTIVE && CHECKSUM), "Adaptive rows are not checksummed.");
+	static_assert(TRANSFORM == TRANSFORM_NONE || !(ADAPTIVE || CHECKSUM),
+	              "Only plain rows are transformed.");
+
 	// not enough data to compress
 	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
-		return doNotDecompressTheData(input, inputElements, data);
+		doNotDecompressTheData(input, inputElements, data);
+		return sizeof(T) * inputElements;
 	}
 
 	//"middle-out" block size
 	size_t blockSize = inputElements / VECTOR_SIZE;
 	// copy first ref. values
 	for (size_t i = 0; i < VECTOR_SIZE; i++) {
-		data[blockSize * i] = (reinterpret_cast<T*>(input.data()))[i];
+		data[blockSize * i] = (reinterpret_cast<const T*>(input))[i];
 	}
 
 	// skip first 8 init values
@@ -306,17 +795,535 @@ void Avx52<T>::decompress(std::vector<char>& input, size_t inputElements, std::v
 	vindex = _mm256_mullo_epi32(vindex, _mm256_set1_epi32(blockSize));
 
 	__m512i prev = _mm512_loadu_si512(&input[0]);
+	// rows left in run of unchanged rows (adaptive rows only)
+	size_t runLeft = 0;
+	if (CHECKSUM) {
+		hashRow(hash, prev);
+	}
+	// reverse transform state, reference values are kept
+	__m512i values = prev;
+	__m512i deltas = _mm512_setzero_si512();
+
+	size_t i = 1;
+	if (NON_TEMPORAL) {
+		// first row of 64 bytes aligned tiles of the first segment (of all segments if blockSize
+		// is a multiple of 8), rows before it are scattered
+		size_t alignedRow = VECTOR_SIZE - (reinterpret_cast<uintptr_t>(data) & 63) / sizeof(T);
+		for (; i < alignedRow && i < blockSize; i++) {
+			decompressAnyBlock<ADAPTIVE>(input, &inputIndex, &prev, blockSize - i, &runLeft);
+			if (CHECKSUM) {
+				hashRow(hash, prev);
+			}
+			__m512i decoded = decodeDeltaVector<TRANSFORM>(prev, &values, &deltas);
+			_mm512_i32scatter_epi64(&data[i], vindex, decoded, 8);
+		}
+	}
+
+	// main decompression loop, by tiles of 8 rows transposed to 8 contiguous stores
+	for (; i + VECTOR_SIZE <= blockSize; i += VECTOR_SIZE) {
+		// non-temporal stores do not need the lines in cache
+		if (!NON_TEMPORAL) {
+			prefetchRows<PREFETCH_WRITE>(data, blockSize, i);
+		}
+
+		if (ADAPTIVE && runLeft >= VECTOR_SIZE) {
+			// whole tile in run of unchanged rows, segments are filled by their last value
+			for (size_t j = 0; j < VECTOR_SIZE; j++) {
+				__m512i value = _mm512_permutexvar_epi64(_mm512_set1_epi64(j), prev);
+				storeSegment<NON_TEMPORAL>(&data[blockSize * j + i], value);
+			}
+			runLeft -= VECTOR_SIZE;
+			continue;
+		}
 
-	// main decompression loop
-	for (size_t i = 1; i < blockSize; i += 1) {
-		decompressBlock(input, inputElements, data, &inputIndex, blockSize, i, vindex, &prev);
+		__m512i tile[VECTOR_SIZE];
+		for (size_t row = 0; row < VECTOR_SIZE; row++) {
+			decompressAnyBlock<ADAPTIVE>(input, &inputIndex, &prev, blockSize - i - row, &runLeft);
+			if (CHECKSUM) {
+				hashRow(hash, prev);
+			}
+			tile[row] = decodeDeltaVector<TRANSFORM>(prev, &values, &deltas);
+		}
+		transpose8x8(tile);
+
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			storeSegment<NON_TEMPORAL>(&data[blockSize * j + i], tile[j]);
+		}
+	}
+
+	// rest of rows
+	for (; i < blockSize; i++) {
+		decompressAnyBlock<ADAPTIVE>(input, &inputIndex, &prev, blockSize - i, &runLeft);
+		if (CHECKSUM) {
+			hashRow(hash, prev);
+		}
+		__m512i decoded = decodeDeltaVector<TRANSFORM>(prev, &values, &deltas);
+		_mm512_i32scatter_epi64(&data[i], vindex, decoded, 8);
 	}
 
 	// copy rest of data (uncompressed)
 	for (size_t i = blockSize * VECTOR_SIZE; i < inputElements; i++) {
-		data[i] = (reinterpret_cast<T*>(&input[inputIndex]))[0];
+		data[i] = (reinterpret_cast<const T*>(&input[inputIndex]))[0];
 		inputIndex += sizeof(T);
 	}
+	return inputIndex;
+}
+
+/*
+ Values are hashed and verified if CHECKSUM is set, transformed rows are reverted
+*/
+template <bool CHECKSUM, Transform TRANSFORM, typename T>
+static DecodeStatus decompressSafeData(const char* input,
+                                       size_t inputSize,
+                                       size_t inputElements,
+                                       T* data) {
+	static_assert(!CHECKSUM || TRANSFORM == TRANSFORM_NONE,
+	              "Transformed values are not checksummed.");
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	for (size_t i = 0; i < VECTOR_SIZE; i++) {
+		data[blockSize * i] = (reinterpret_cast<const T*>(input))[i];
+	}
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE;
+	size_t rowsEnd = getRowsEnd(inputSize, inputElements);
+
+	__m256i vindex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	vindex = _mm256_mullo_epi32(vindex, _mm256_set1_epi32(blockSize));
+	__m512i prev = _mm512_loadu_si512(&input[0]);
+
+	RowHashVector hash;
+	if (CHECKSUM) {
+		initRowHash(&hash);
+		hashRow(&hash, prev);
+	}
+	__m512i values = prev;
+	__m512i deltas = _mm512_setzero_si512();
+
+	size_t i = 1;
+	for (; i + VECTOR_SIZE <= blockSize; i += VECTOR_SIZE) {
+		prefetchRows<PREFETCH_WRITE>(data, blockSize, i);
+
+		__m512i tile[VECTOR_SIZE];
+		for (size_t row = 0; row < VECTOR_SIZE; row++) {
+			if (!decompressBlockSafe(input, &inputIndex, rowsEnd, &prev)) {
+				return DECODE_MALFORMED;
+			}
+			if (CHECKSUM) {
+				hashRow(&hash, prev);
+			}
+			tile[row] = decodeDeltaVector<TRANSFORM>(prev, &values, &deltas);
+		}
+		transpose8x8(tile);
+
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			_mm512_storeu_si512(&data[blockSize * j + i], tile[j]);
+		}
+	}
+
+	for (; i < blockSize; i++) {
+		if (!decompressBlockSafe(input, &inputIndex, rowsEnd, &prev)) {
+			return DECODE_MALFORMED;
+		}
+		if (CHECKSUM) {
+			hashRow(&hash, prev);
+		}
+		__m512i decoded = decodeDeltaVector<TRANSFORM>(prev, &values, &deltas);
+		_mm512_i32scatter_epi64(&data[i], vindex, decoded, 8);
+	}
+
+	uint64_t accumulators[VECTOR_SIZE];
+	if (CHECKSUM) {
+		_mm512_storeu_si512(accumulators, hash.accumulators);
+	}
+	return decompressSafeRest(input, inputIndex, inputSize, inputElements, data,
+	                          CHECKSUM ? accumulators : NULL);
+}
+
+template <typename T>
+DecodeStatus Avx52<T>::decompressSafe(const char* input,
+                                      size_t inputSize,
+                                      size_t inputElements,
+                                      T* data) {
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return decompressSafeUncompressed(input, inputSize, inputElements, data);
+	}
+	if (inputSize < getMinCompressedSize(inputElements)) {
+		return DECODE_TRUNCATED;
+	}
+
+	if (hasChecksum(input, inputSize)) {
+		return decompressSafeData<true, TRANSFORM_NONE>(input, inputSize, inputElements, data);
+	}
+	return decompressSafeData<false, TRANSFORM_NONE>(input, inputSize, inputElements, data);
+}
+
+template <typename T>
+DecodeStatus Avx52<T>::decompressSafeTransformed(const char* input,
+                                                 size_t inputSize,
+                                                 size_t inputElements,
+                                                 T* data,
+                                                 Transform transform) {
+	if (transform == TRANSFORM_NONE || inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return decompressSafe(input, inputSize, inputElements, data);
+	}
+	if (inputSize < getMinCompressedSize(inputElements)) {
+		return DECODE_TRUNCATED;
+	}
+	// transformed values are not checksummed, the trailer has to be plain
+	if (hasChecksum(input, inputSize)) {
+		return DECODE_MALFORMED;
+	}
+	if (transform == TRANSFORM_DELTA) {
+		return decompressSafeData<false, TRANSFORM_DELTA>(input, inputSize, inputElements, data);
+	}
+	return decompressSafeData<false, TRANSFORM_DELTA_OF_DELTA>(input, inputSize, inputElements,
+	                                                           data);
+}
+
+template <typename T>
+void Avx52<T>::decompress(const char* input, size_t inputElements, T* data) {
+	decompressData<false, false, false, TRANSFORM_NONE>(input, inputElements, data, NULL);
+}
+
+template <typename T>
+void Avx52<T>::decompressTransformed(const char* input,
+                                     size_t inputElements,
+                                     T* data,
+                                     Transform transform) {
+	switch (transform) {
+		case TRANSFORM_DELTA:
+			decompressData<false, false, false, TRANSFORM_DELTA>(input, inputElements, data, NULL);
+			break;
+		case TRANSFORM_DELTA_OF_DELTA:
+			decompressData<false, false, false, TRANSFORM_DELTA_OF_DELTA>(input, inputElements,
+			                                                              data, NULL);
+			break;
+		default:
+			decompress(input, inputElements, data);
+	}
+}
+
+template <typename T>
+DecodeStatus Avx52<T>::decompressVerified(const char* input, size_t inputElements, T* data) {
+	RowHashVector hash;
+	initRowHash(&hash);
+	size_t trailerIndex =
+	    decompressData<false, false, true, TRANSFORM_NONE>(input, inputElements, data, &hash);
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		// stored uncompressed, without checksum
+		return DECODE_OK;
+	}
+	uint64_t accumulators[VECTOR_SIZE];
+	_mm512_storeu_si512(accumulators, hash.accumulators);
+	return verifyChecksum(&input[trailerIndex], accumulators, data, inputElements);
+}
+
+template <typename T>
+void Avx52<T>::decompressNonTemporal(const char* input, size_t inputElements, T* data) {
+	decompressData<true, false, false, TRANSFORM_NONE>(input, inputElements, data, NULL);
+	_mm_sfence();
+}
+
+template <typename T>
+void Avx52<T>::decompressAdaptive(const char* input, size_t inputElements, T* data) {
+	decompressData<false, true, false, TRANSFORM_NONE>(input, inputElements, data, NULL);
+}
+
+//
+// AGGREGATION
+//
+
+template <typename T>
+static inline __m512i addVector(__m512i a, __m512i b) {
+	if (std::is_floating_point<T>::value) {
+		return _mm512_castpd_si512(_mm512_add_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b)));
+	}
+	return _mm512_add_epi64(a, b);
+}
+
+// NaN values keep the current ones (second operand of min_pd and max_pd)
+template <typename T>
+static inline __m512i minVector(__m512i values, __m512i current) {
+	if (std::is_floating_point<T>::value) {
+		return _mm512_castpd_si512(
+		    _mm512_min_pd(_mm512_castsi512_pd(values), _mm512_castsi512_pd(current)));
+	}
+	return std::is_signed<T>::value ? _mm512_min_epi64(values, current)
+	                                : _mm512_min_epu64(values, current);
+}
+
+template <typename T>
+static inline __m512i maxVector(__m512i values, __m512i current) {
+	if (std::is_floating_point<T>::value) {
+		return _mm512_castpd_si512(
+		    _mm512_max_pd(_mm512_castsi512_pd(values), _mm512_castsi512_pd(current)));
+	}
+	return std::is_signed<T>::value ? _mm512_max_epi64(values, current)
+	                                : _mm512_max_epu64(values, current);
+}
+
+template <typename T>
+void Avx52<T>::decompressAggregates(const char* input,
+                                    size_t inputElements,
+                                    Aggregates<T>* aggregates) {
+	initAggregates(aggregates, inputElements);
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		aggregateValues(input, inputElements, aggregates);
+		return;
+	}
+
+	LaneAggregates<T> lanes;
+	initLanes(&lanes);
+	__m512i prev = _mm512_loadu_si512(&input[0]);
+	__m512i sums = addVector<T>(_mm512_loadu_si512(lanes.sums), prev);
+	__m512i mins = minVector<T>(prev, _mm512_loadu_si512(lanes.mins));
+	__m512i maxs = maxVector<T>(prev, _mm512_loadu_si512(lanes.maxs));
+
+	// rows stay in registers, nothing is stored
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE;
+	for (size_t i = 1; i < blockSize; i++) {
+		if ((uint8_t)input[inputIndex] == 0b11111111) {
+			// min and max of unchanged row do not change
+			inputIndex++;
+			sums = addVector<T>(sums, prev);
+			continue;
+		}
+		decompressBlock(input, &inputIndex, &prev);
+		sums = addVector<T>(sums, prev);
+		mins = minVector<T>(prev, mins);
+		maxs = maxVector<T>(prev, maxs);
+	}
+
+	_mm512_storeu_si512(lanes.sums, sums);
+	_mm512_storeu_si512(lanes.mins, mins);
+	_mm512_storeu_si512(lanes.maxs, maxs);
+	mergeLanes(&lanes, aggregates);
+	aggregateValues(&input[inputIndex], inputElements % VECTOR_SIZE, aggregates);
+}
+
+/*
+ Stores current buckets of lanes in mask (last values are prev) to lanes
+*/
+template <typename T>
+static inline void storeLanes(LaneBuckets<T>* lanes,
+                              __mmask8 mask,
+                              __m512i firsts,
+                              __m512i prev,
+                              __m512i mins,
+                              __m512i maxs,
+                              __m512i sums,
+                              __m512i counts) {
+	T values[5][VECTOR_SIZE];
+	uint64_t lengths[VECTOR_SIZE];
+	_mm512_storeu_si512(values[0], firsts);
+	_mm512_storeu_si512(values[1], prev);
+	_mm512_storeu_si512(values[2], mins);
+	_mm512_storeu_si512(values[3], maxs);
+	_mm512_storeu_si512(values[4], sums);
+	_mm512_storeu_si512(lengths, counts);
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		if (mask & (1 << j)) {
+			lanes->current[j] = {values[0][j], values[1][j], values[2][j],
+			                     values[3][j], values[4][j], lengths[j]};
+		}
+	}
+}
+
+template <typename T>
+size_t Avx52<T>::decompressBuckets(const char* input,
+                                   size_t inputElements,
+                                   size_t bucketWidth,
+                                   Bucket<T>* buckets) {
+	if (bucketWidth == 0) {
+		return 0;
+	}
+	size_t bucketsCount = getBucketsCount(inputElements, bucketWidth);
+	for (size_t i = 0; i < bucketsCount; i++) {
+		initBucket(&buckets[i]);
+	}
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		bucketValues(input, inputElements, bucketWidth, buckets, 0);
+		return bucketsCount;
+	}
+
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	LaneBuckets<T> lanes;
+	initLaneBuckets(&lanes, blockSize, bucketWidth);
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i one = _mm512_set1_epi64(1);
+	const __m512i width = _mm512_set1_epi64(bucketWidth);
+	Aggregates<T> identity;
+	initAggregates(&identity, 0);
+	const __m512i minIdentity = _mm512_set1_epi64(reinterpret_cast<int64_t&>(identity.min));
+	const __m512i maxIdentity = _mm512_set1_epi64(reinterpret_cast<int64_t&>(identity.max));
+
+	// current buckets of lanes, last values are in prev
+	__m512i prev = _mm512_loadu_si512(&input[0]);
+	__m512i firsts = prev;
+	__m512i sums = prev;
+	__m512i mins = minVector<T>(prev, minIdentity);
+	__m512i maxs = maxVector<T>(prev, maxIdentity);
+	__m512i counts = one;
+	__m512i remaining = _mm512_sub_epi64(_mm512_loadu_si512(lanes.remaining), one);
+
+	// rows stay in registers, nothing is stored
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE;
+	for (size_t i = 1; i < blockSize; i++) {
+		// lanes starting a new bucket
+		__mmask8 reset = _mm512_cmpeq_epi64_mask(remaining, zero);
+		if (reset) {
+			storeLanes(&lanes, reset, firsts, prev, mins, maxs, sums, counts);
+			for (size_t j = 0; j < VECTOR_SIZE; j++) {
+				if (reset & (1 << j)) {
+					flushLane(&lanes, j, buckets);
+				}
+			}
+			remaining = _mm512_mask_mov_epi64(remaining, reset, width);
+			counts = _mm512_mask_mov_epi64(counts, reset, zero);
+			mins = _mm512_mask_mov_epi64(mins, reset, minIdentity);
+			maxs = _mm512_mask_mov_epi64(maxs, reset, maxIdentity);
+		}
+
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		if (unchanged) {
+			inputIndex++;
+		} else {
+			decompressBlock(input, &inputIndex, &prev);
+		}
+
+		// new buckets start by the value
+		sums = _mm512_mask_mov_epi64(addVector<T>(sums, prev), reset, prev);
+		firsts = _mm512_mask_mov_epi64(firsts, reset, prev);
+		if (!unchanged || reset) {
+			mins = minVector<T>(prev, mins);
+			maxs = maxVector<T>(prev, maxs);
+		}
+		counts = _mm512_add_epi64(counts, one);
+		remaining = _mm512_sub_epi64(remaining, one);
+	}
+
+	// current buckets end with segments
+	storeLanes(&lanes, 0b11111111, firsts, prev, mins, maxs, sums, counts);
+	finishLaneBuckets(&lanes, blockSize, bucketWidth, buckets);
+	bucketValues(&input[inputIndex], inputElements % VECTOR_SIZE, bucketWidth, buckets,
+	             blockSize * VECTOR_SIZE);
+	return bucketsCount;
+}
+
+//
+// PREDICATE SCAN
+//
+
+static constexpr int getFloatComparison(ScanPredicate predicate) {
+	// NaNs match SCAN_NOT_EQUAL only (ordered comparisons, unordered inequality)
+	return predicate == SCAN_LESS            ? _CMP_LT_OQ
+	       : predicate == SCAN_LESS_EQUAL    ? _CMP_LE_OQ
+	       : predicate == SCAN_GREATER       ? _CMP_GT_OQ
+	       : predicate == SCAN_GREATER_EQUAL ? _CMP_GE_OQ
+	       : predicate == SCAN_EQUAL         ? _CMP_EQ_OQ
+	                                         : _CMP_NEQ_UQ;
+}
+
+static constexpr int getIntComparison(ScanPredicate predicate) {
+	return predicate == SCAN_LESS            ? _MM_CMPINT_LT
+	       : predicate == SCAN_LESS_EQUAL    ? _MM_CMPINT_LE
+	       : predicate == SCAN_GREATER       ? _MM_CMPINT_NLE
+	       : predicate == SCAN_GREATER_EQUAL ? _MM_CMPINT_NLT
+	       : predicate == SCAN_EQUAL         ? _MM_CMPINT_EQ
+	                                         : _MM_CMPINT_NE;
+}
+
+template <ScanPredicate PREDICATE, typename T>
+static inline __mmask8 compareVector(__m512i values, __m512i threshold) {
+	if (std::is_floating_point<T>::value) {
+		return _mm512_cmp_pd_mask(_mm512_castsi512_pd(values), _mm512_castsi512_pd(threshold),
+		                          getFloatComparison(PREDICATE));
+	}
+	return std::is_signed<T>::value
+	           ? _mm512_cmp_epi64_mask(values, threshold, getIntComparison(PREDICATE))
+	           : _mm512_cmp_epu64_mask(values, threshold, getIntComparison(PREDICATE));
+}
+
+template <ScanPredicate PREDICATE, typename T>
+static size_t scanData(const char* input, size_t inputElements, T threshold, uint64_t* bitmap) {
+	memset(bitmap, 0, sizeof(uint64_t) * scanBitmapWords(inputElements));
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return scanValues<PREDICATE>(input, inputElements, threshold, bitmap, 0);
+	}
+
+	__m512i thresholds = _mm512_set1_epi64(reinterpret_cast<int64_t&>(threshold));
+	__m512i prev = _mm512_loadu_si512(&input[0]);
+	__mmask8 mask = compareVector<PREDICATE, T>(prev, thresholds);
+	RowMasks rows = {0, 0};
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	addRowMask(&rows, bitmap, blockSize, 0, mask);
+
+	// rows stay in registers, nothing is stored
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE;
+	for (size_t i = 1; i < blockSize; i++) {
+		if ((uint8_t)input[inputIndex] == 0b11111111) {
+			// unchanged row keeps the mask of the previous one
+			inputIndex++;
+		} else {
+			decompressBlock(input, &inputIndex, &prev);
+			mask = compareVector<PREDICATE, T>(prev, thresholds);
+		}
+		addRowMask(&rows, bitmap, blockSize, i, mask);
+	}
+
+	size_t matching = finishRowMasks(&rows, bitmap, blockSize);
+	return matching + scanValues<PREDICATE>(&input[inputIndex], inputElements % VECTOR_SIZE,
+	                                        threshold, bitmap, blockSize * VECTOR_SIZE);
+}
+
+template <typename T>
+size_t Avx52<T>::scan(const char* input,
+                      size_t inputElements,
+                      ScanPredicate predicate,
+                      T threshold,
+                      uint64_t* bitmap) {
+	switch (predicate) {
+		case SCAN_LESS:
+			return scanData<SCAN_LESS>(input, inputElements, threshold, bitmap);
+		case SCAN_LESS_EQUAL:
+			return scanData<SCAN_LESS_EQUAL>(input, inputElements, threshold, bitmap);
+		case SCAN_GREATER:
+			return scanData<SCAN_GREATER>(input, inputElements, threshold, bitmap);
+		case SCAN_GREATER_EQUAL:
+			return scanData<SCAN_GREATER_EQUAL>(input, inputElements, threshold, bitmap);
+		case SCAN_EQUAL:
+			return scanData<SCAN_EQUAL>(input, inputElements, threshold, bitmap);
+		default:
+			return scanData<SCAN_NOT_EQUAL>(input, inputElements, threshold, bitmap);
+	}
+}
+
+//
+// PRECISION TRUNCATION
+//
+
+template <typename T>
+void Avx52<T>::truncatePrecision(const T* data, size_t count, T* output, ErrorBound bound) {
+	if (bound.mode == ERROR_BOUND_NONE) {
+		if (output != data) {
+			memcpy(output, data, sizeof(T) * count);
+		}
+		return;
+	}
+
+	__m512i base = _mm512_set1_epi64(getTruncationBase(bound));
+	size_t i = 0;
+	for (; i + VECTOR_SIZE <= count; i += VECTOR_SIZE) {
+		__m512i values = _mm512_loadu_si512(&data[i]);
+		values = _mm512_and_si512(values, getTruncationMask(values, bound.mode, base));
+		_mm512_storeu_si512(&output[i], values);
+	}
+
+	// masked loads do not touch memory behind data
+	__mmask8 rest = (1 << (count - i)) - 1;
+	__m512i values = _mm512_maskz_loadu_epi64(rest, &data[i]);
+	values = _mm512_and_si512(values, getTruncationMask(values, bound.mode, base));
+	_mm512_mask_storeu_epi64(&output[i], rest, values);
 }
 
 }  // end namespace middleout
\ No newline at end of file
@@ -0,0 +1,249 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "avx512_32.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <immintrin.h>
+#include <memory>
+
+namespace middleout {
+
+template class Avx52x32<float>;
+template class Avx52x32<int32_t>;
+template class Avx52x32<uint32_t>;
+
+template <typename T>
+Avx52x32<T>::Avx52x32() {}
+
+/**
+ * Number of zero bits from right in each element (undefined for zero elements)
+ */
+static inline __m512i trailingZeros(__mmask16 mask, __m512i x) {
+	// isolate lowest set bit, its position is 31 - leading zeros
+	__m512i lowestBit = _mm512_and_si512(x, _mm512_sub_epi32(_mm512_setzero_si512(), x));
+	return _mm512_maskz_sub_epi32(mask, _mm512_set1_epi32(31), _mm512_lzcnt_epi32(lowestBit));
+}
+
+/**
+ * Compresses offsets. Skip offsets by mask. Using 2bits per one offset
+ */
+static inline uint32_t compressOffsets(__mmask16 notSame, __m512i offsets) {
+	__m512i compressed = _mm512_maskz_compress_epi32(notSame, offsets);
+	// 16 offsets of 2 bits fit to 32 bits
+	__m512i positioned = _mm512_sllv_epi32(
+	    compressed,
+	    _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30));
+	return (uint32_t)_mm512_reduce_or_epi32(positioned);
+}
+
+/**
+ * Comress block of data
+ */
+template <typename T>
+static inline void compressBlock(const T* data,
+                                 char* output,
+                                 size_t* outputIndex,
+                                 const size_t i,        // position within middle-out block
+                                 const __m512i vindex,  // indexes within middle-out block
+                                 __m512i* prev) {
+	__m512i curr = _mm512_i32gather_epi32(vindex, &data[i], 4);
+
+	__m512i xored = _mm512_xor_si512(*prev, curr);
+	__mmask16 notSame = _mm512_test_epi32_mask(xored, xored);
+
+	// store "not same" metadata
+	uint16_t sameMask = ~notSame;
+	memcpy(&output[*outputIndex], &sameMask, sizeof(sameMask));
+	*outputIndex += sizeof(sameMask);
+
+	if (notSame == 0) {
+		// skip if all values are the same as previous
+		return;
+	}
+
+	int notSameCount = __builtin_popcount(notSame);
+
+	__m512i leftOffsetBytes = _mm512_srli_epi32(_mm512_maskz_lzcnt_epi32(notSame, xored), 3);
+	__m512i rightOffsetBytes = _mm512_srli_epi32(trailingZeros(notSame, xored), 3);
+
+	// 4 - (leftOffset + rightOffset)
+	__m512i lengthBytes = _mm512_maskz_sub_epi32(
+	    notSame, _mm512_set1_epi32(4), _mm512_add_epi32(leftOffsetBytes, rightOffsetBytes));
+	uint8_t maxLength = (uint8_t)_mm512_reduce_max_epi32(lengthBytes);
+
+	// align non-zero xored part to right
+	__m512i shiftedXored = _mm512_srlv_epi32(xored, _mm512_slli_epi32(rightOffsetBytes, 3));
+
+	// store offsets and max length
+	// -1 becasue we need to store only values 1-4, so 2 bits are enought
+	uint64_t header = (uint64_t)compressOffsets(notSame, rightOffsetBytes) << 2 | (maxLength - 1);
+	memcpy(&output[*outputIndex], &header, sizeof(header));
+
+	// +1 because first 2 bits are maxLength
+	*outputIndex += getBytesLengthOfOffsets32(notSameCount + 1);
+
+	// maxLength * position
+	__m512i storeBase = _mm512_mullo_epi32(
+	    _mm512_set1_epi32(maxLength),
+	    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+	// compress within vector - store is done in strong order (documented behavior)
+	// compression is done by data overlapping
+	__m512i compressedXoredShifted = _mm512_maskz_compress_epi32(notSame, shiftedXored);
+	_mm512_mask_i32scatter_epi32(&output[*outputIndex], (__mmask16)((1 << notSameCount) - 1),
+	                             storeBase, compressedXoredShifted, 1);
+
+	*outputIndex += notSameCount * maxLength;
+
+	// preserve previous data in vector register
+	*prev = curr;
+}
+
+/*
+
+Middle-out compression
+
+*/
+template <typename T>
+size_t Avx52x32<T>::compress(const T* data, size_t count, char* output, size_t capacity) {
+	if (capacity < maxCompressedSize(count)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD_32) {
+		// not enough data to compress
+		return doNotCompressTheData(data, count, output);
+	}
+
+	// "middle-out" data block size
+	size_t blockSize = count / VECTOR_SIZE_32;
+
+	__m512i vindex = _mm512_mullo_epi32(
+	    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+	    _mm512_set1_epi32(blockSize));
+
+	// just copy init reference values
+	__m512i prev = _mm512_i32gather_epi32(vindex, &data[0], 4);
+	_mm512_storeu_si512(output, prev);
+	// skip first 16 init values
+	size_t outputIndex = sizeof(T) * VECTOR_SIZE_32;
+
+	// main compression loop
+	for (size_t i = 1; i < blockSize; i += 1) {
+		compressBlock(data, output, &outputIndex, i, vindex, &prev);
+	}
+
+	// write rest data without any compression
+	for (size_t i = blockSize * VECTOR_SIZE_32; i < count; i++) {
+		memcpy(&output[outputIndex], &data[i], sizeof(T));
+		outputIndex += sizeof(T);
+	}
+
+	return writeTrailer(output, outputIndex);
+}
+
+//
+// DECOMPRESSION
+//
+template <typename T>
+static inline void decompressBlock(const char* input,
+                                   T* data,
+                                   size_t* inputIndex,    // position within input data
+                                   const size_t i,        // position within block
+                                   const __m512i vindex,  // vector of output data indexes
+                                   __m512i* prev) {
+	// read mask of same values
+	uint16_t sameMask;
+	memcpy(&sameMask, &input[*inputIndex], sizeof(sameMask));
+	*inputIndex += sizeof(sameMask);
+
+	if (sameMask == 0xFFFF) {
+		// all values are the same as previous ones
+		_mm512_i32scatter_epi32(&data[i], vindex, *prev, 4);
+		return;
+	}
+
+	__mmask16 notSameMask = ~sameMask;
+
+	// read unaligned offsets, where offset = number of empty bytes from right in XORed value
+	uint64_t compresedOffsetsAndMaxLength;
+	memcpy(&compresedOffsetsAndMaxLength, &input[*inputIndex], sizeof(uint64_t));
+	// +1 because only 2 bits are stored and valid lengths are 1-4
+	uint8_t maxLength = (compresedOffsetsAndMaxLength & 0b11) + 1;
+
+	int notSameCount = __builtin_popcount(notSameMask);
+
+	// +1 because first 2 bits are maxLength
+	*inputIndex += getBytesLengthOfOffsets32(notSameCount + 1);
+
+	__m512i decompressOffsets = _mm512_maskz_expand_epi32(
+	    notSameMask, _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	__m512i readShifts = _mm512_mullo_epi32(_mm512_set1_epi32(maxLength), decompressOffsets);
+
+	__m512i toXor =
+	    _mm512_mask_i32gather_epi32(*prev, notSameMask, readShifts, &input[*inputIndex], 1);
+
+	// 2 bit offsets of stored values follow max length
+	__m512i offsets = _mm512_srlv_epi32(
+	    _mm512_set1_epi32((uint32_t)(compresedOffsetsAndMaxLength >> 2)),
+	    _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30));
+	offsets = _mm512_and_si512(offsets, _mm512_set1_epi32(0b11));
+	// get offsets to positions corresponding with compressed values
+	offsets = _mm512_maskz_expand_epi32(notSameMask, offsets);
+
+	// clear unused bytes and shift to position (offset * 8)
+	toXor = _mm512_and_si512(toXor, _mm512_set1_epi32(~((uint32_t)0) >> (32 - 8 * maxLength)));
+	toXor = _mm512_sllv_epi32(toXor, _mm512_slli_epi32(offsets, 3));
+	__m512i xored = _mm512_mask_xor_epi32(*prev, notSameMask, *prev, toXor);
+
+	_mm512_i32scatter_epi32(&data[i], vindex, xored, 4);
+
+	*inputIndex += notSameCount * maxLength;
+	*prev = xored;
+}
+
+template <typename T>
+void Avx52x32<T>::decompress(const char* input, size_t inputElements, T* data) {
+	// not enough data to compress
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD_32) {
+		return doNotDecompressTheData(input, inputElements, data);
+	}
+
+	//"middle-out" block size
+	size_t blockSize = inputElements / VECTOR_SIZE_32;
+
+	__m512i vindex = _mm512_mullo_epi32(
+	    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+	    _mm512_set1_epi32(blockSize));
+
+	// copy first ref. values
+	__m512i prev = _mm512_loadu_si512(&input[0]);
+	_mm512_i32scatter_epi32(&data[0], vindex, prev, 4);
+
+	// skip first 16 init values
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE_32;
+
+	// main decompression loop
+	for (size_t i = 1; i < blockSize; i += 1) {
+		decompressBlock(input, data, &inputIndex, i, vindex, &prev);
+	}
+
+	// copy rest of data (uncompressed)
+	for (size_t i = blockSize * VECTOR_SIZE_32; i < inputElements; i++) {
+		memcpy(&data[i], &input[inputIndex], sizeof(T));
+		inputIndex += sizeof(T);
+	}
+}
+
+}  // end namespace middleout
@@ -0,0 +1,56 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+#include <memory>
+
+#ifndef AVX52_32_H
+#define AVX52_32_H
+
+namespace middleout {
+
+/*
+ AVX-512 implementation of the 32bit format (see scalar32.hpp), 16 segments at once
+*/
+template <typename T>
+class Avx52x32 {
+	static_assert(sizeof(T) == 4, "Must use datatype with length of 4 bytes.");
+
+   public:
+	Avx52x32();
+
+	static std::unique_ptr<std::vector<char>> compressSimple(std::vector<T>& data);
+
+	static size_t compress(std::vector<T>& data, std::vector<char>& output);
+
+	/*
+	 Compresses count values to output. Returns 0 (nothing written) if capacity is less than
+	 maxCompressedSize(count).
+	*/
+	static size_t compress(const T* data, size_t count, char* output, size_t capacity);
+
+	static void decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data);
+
+	static void decompress(const char* input, size_t itemsCount, T* data);
+
+	static size_t maxCompressedSize(size_t count) {
+		size_t blockCount = count / 16;
+		// 4*16            : init reference values
+		// 7*blockClount   : max size of block headers
+		// 4*16*blockCount : max size of xored data: 4 bytes * 16 values
+		// 4*(count%16)    : uncompressed rest of values
+		return 4 * 16 + blockCount * 7 + 4 * 16 * blockCount + 4 * (count % 16);
+	}
+};
+
+}  // end namespace middleout
+
+#endif /* AVX52_32_H */
@@ -0,0 +1,84 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "avx512.hpp"
+#include "avx512_32.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace middleout {
+
+/*
+ std::vector wrappers of the Avx52 and Avx52x32 kernels, compiled for the scalar target (see
+ Makefile). std templates they instantiate are weak symbols the linker may take from any object, so
+ objects built for vector targets must not instantiate them.
+*/
+template <typename T>
+std::unique_ptr<std::vector<char>> Avx52<T>::compressSimple(std::vector<T>& data) {
+	std::unique_ptr<std::vector<char>> compressed(
+	    new std::vector<char>(Avx52<T>::maxCompressedSize(data.size())));
+	size_t size = Avx52<T>::compress(data, *compressed);
+	compressed->resize(size);
+	compressed->shrink_to_fit();
+	return compressed;
+}
+
+template <typename T>
+size_t Avx52<T>::compress(std::vector<T>& data, std::vector<char>& output) {
+	return Avx52<T>::compress(data.data(), data.size(), output.data(), output.size());
+}
+
+template <typename T>
+void Avx52<T>::decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data) {
+	Avx52<T>::decompress(input.data(), itemsCount, data.data());
+}
+
+template <typename T>
+std::unique_ptr<std::vector<char>> Avx52x32<T>::compressSimple(std::vector<T>& data) {
+	std::unique_ptr<std::vector<char>> compressed(
+	    new std::vector<char>(Avx52x32<T>::maxCompressedSize(data.size())));
+	size_t size = Avx52x32<T>::compress(data, *compressed);
+	compressed->resize(size);
+	compressed->shrink_to_fit();
+	return compressed;
+}
+
+template <typename T>
+size_t Avx52x32<T>::compress(std::vector<T>& data, std::vector<char>& output) {
+	return Avx52x32<T>::compress(data.data(), data.size(), output.data(), output.size());
+}
+
+template <typename T>
+void Avx52x32<T>::decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data) {
+	Avx52x32<T>::decompress(input.data(), itemsCount, data.data());
+}
+
+template std::unique_ptr<std::vector<char>> Avx52<double>::compressSimple(std::vector<double>&);
+template size_t Avx52<double>::compress(std::vector<double>&, std::vector<char>&);
+template void Avx52<double>::decompress(std::vector<char>&, size_t, std::vector<double>&);
+template std::unique_ptr<std::vector<char>> Avx52<int64_t>::compressSimple(std::vector<int64_t>&);
+template size_t Avx52<int64_t>::compress(std::vector<int64_t>&, std::vector<char>&);
+template void Avx52<int64_t>::decompress(std::vector<char>&, size_t, std::vector<int64_t>&);
+template std::unique_ptr<std::vector<char>> Avx52<uint64_t>::compressSimple(std::vector<uint64_t>&);
+template size_t Avx52<uint64_t>::compress(std::vector<uint64_t>&, std::vector<char>&);
+template void Avx52<uint64_t>::decompress(std::vector<char>&, size_t, std::vector<uint64_t>&);
+template std::unique_ptr<std::vector<char>> Avx52x32<float>::compressSimple(std::vector<float>&);
+template size_t Avx52x32<float>::compress(std::vector<float>&, std::vector<char>&);
+template void Avx52x32<float>::decompress(std::vector<char>&, size_t, std::vector<float>&);
+template std::unique_ptr<std::vector<char>> Avx52x32<int32_t>::compressSimple(
+    std::vector<int32_t>&);
+template size_t Avx52x32<int32_t>::compress(std::vector<int32_t>&, std::vector<char>&);
+template void Avx52x32<int32_t>::decompress(std::vector<char>&, size_t, std::vector<int32_t>&);
+template std::unique_ptr<std::vector<char>> Avx52x32<uint32_t>::compressSimple(
+    std::vector<uint32_t>&);
+template size_t Avx52x32<uint32_t>::compress(std::vector<uint32_t>&, std::vector<char>&);
+template void Avx52x32<uint32_t>::decompress(std::vector<char>&, size_t, std::vector<uint32_t>&);
+
+}  // end namespace middleout
@@ -0,0 +1,113 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "batch.hpp"
+#include "helpers.hpp"
+#include "scalar.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace middleout {
+
+template class Batch<double>;
+template class Batch<int64_t>;
+template class Batch<uint64_t>;
+
+/*
+ Length of the longest series of group, i.e. length of its middle-out segments
+*/
+static size_t getGroupLength(const size_t* lengths, size_t seriesCount, size_t group) {
+	size_t first = group * VECTOR_SIZE;
+	size_t last = std::min(first + VECTOR_SIZE, seriesCount);
+	return *std::max_element(&lengths[first], &lengths[last]);
+}
+
+static size_t getMaxGroupLength(const size_t* lengths, size_t seriesCount) {
+	return seriesCount == 0 ? 0 : *std::max_element(lengths, lengths + seriesCount);
+}
+
+template <typename T>
+size_t Batch<T>::getGroupsCount(size_t seriesCount) {
+	return (seriesCount + VECTOR_SIZE - 1) / VECTOR_SIZE;
+}
+
+template <typename T>
+size_t Batch<T>::maxCompressedSize(const size_t* lengths, size_t seriesCount) {
+	size_t size = 0;
+	for (size_t group = 0; group < getGroupsCount(seriesCount); group++) {
+		size_t groupLength = getGroupLength(lengths, seriesCount, group);
+		// all kernels share the format, so the max size too
+		size += Scalar<T>::maxCompressedSize(VECTOR_SIZE * groupLength);
+	}
+	return size;
+}
+
+template <typename T>
+size_t Batch<T>::compress(CompressFunction compress,
+                          const T* const* series,
+                          const size_t* lengths,
+                          size_t seriesCount,
+                          char* output,
+                          size_t capacity,
+                          size_t* offsets) {
+	if (capacity < maxCompressedSize(lengths, seriesCount)) {
+		// output could overflow
+		return 0;
+	}
+
+	// series of a group are laid out one after another, i.e. as middle-out segments
+	std::vector<T> values(VECTOR_SIZE * getMaxGroupLength(lengths, seriesCount));
+
+	size_t outputIndex = 0;
+	for (size_t group = 0; group < getGroupsCount(seriesCount); group++) {
+		size_t groupLength = getGroupLength(lengths, seriesCount, group);
+
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			size_t i = group * VECTOR_SIZE + j;
+			T* segment = values.data() + groupLength * j;
+			size_t length = 0;
+			if (i < seriesCount) {
+				length = lengths[i];
+				memcpy(segment, series[i], sizeof(T) * length);
+			}
+			// repeated value is the cheapest padding
+			T padding = length == 0 ? T() : segment[length - 1];
+			std::fill(segment + length, segment + groupLength, padding);
+		}
+
+		offsets[group] = outputIndex;
+		outputIndex += compress(values.data(), VECTOR_SIZE * groupLength, &output[outputIndex],
+		                        capacity - outputIndex);
+	}
+	return outputIndex;
+}
+
+template <typename T>
+void Batch<T>::decompress(DecompressFunction decompress,
+                          const char* input,
+                          const size_t* offsets,
+                          const size_t* lengths,
+                          size_t seriesCount,
+                          T* const* series) {
+	std::vector<T> values(VECTOR_SIZE * getMaxGroupLength(lengths, seriesCount));
+
+	for (size_t group = 0; group < getGroupsCount(seriesCount); group++) {
+		size_t groupLength = getGroupLength(lengths, seriesCount, group);
+		decompress(&input[offsets[group]], VECTOR_SIZE * groupLength, values.data());
+
+		for (size_t j = 0; j < VECTOR_SIZE && group * VECTOR_SIZE + j < seriesCount; j++) {
+			size_t i = group * VECTOR_SIZE + j;
+			memcpy(series[i], values.data() + groupLength * j, sizeof(T) * lengths[i]);
+		}
+	}
+}
+
+}  // end namespace middleout
@@ -0,0 +1,67 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef BATCH_H
+#define BATCH_H
+
+namespace middleout {
+
+/*
+
+Compression of many short series in one call.
+
+A short series alone is not worth compressing: it does not fill the middle-out rows and pays for 8
+reference values and the trailer. Consecutive series are grouped by 8 instead, every group is
+compressed as one middle-out block with one series per segment, so row i holds value i of each of
+the 8 series (one SIMD lane per series). Series shorter than the longest one of their group are
+padded by repeating their last value, which costs bits of the row's same mask only. Series missing
+in the last group are zeros.
+
+Groups are stored back to back, offsets[g] is the start of group g within output, so groups can be
+decompressed independently. Lengths of the series are not stored.
+
+*/
+template <typename T>
+class Batch {
+   public:
+	typedef size_t (*CompressFunction)(const T* data, size_t count, char* output, size_t capacity);
+	typedef void (*DecompressFunction)(const char* input, size_t itemsCount, T* data);
+
+	// number of offsets written by compress
+	static size_t getGroupsCount(size_t seriesCount);
+
+	static size_t maxCompressedSize(const size_t* lengths, size_t seriesCount);
+
+	/*
+	 Compresses seriesCount series (series[i] holds lengths[i] values) by kernel's compress. Returns
+	 0 (nothing written) if capacity is less than maxCompressedSize(lengths, seriesCount).
+	*/
+	static size_t compress(CompressFunction compress,
+	                       const T* const* series,
+	                       const size_t* lengths,
+	                       size_t seriesCount,
+	                       char* output,
+	                       size_t capacity,
+	                       size_t* offsets);
+
+	static void decompress(DecompressFunction decompress,
+	                       const char* input,
+	                       const size_t* offsets,
+	                       const size_t* lengths,
+	                       size_t seriesCount,
+	                       T* const* series);
+};
+
+}  // end namespace middleout
+
+#endif /* BATCH_H */
@@ -0,0 +1,374 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#ifndef CODEC_H
+#define CODEC_H
+
+namespace middleout {
+
+/*
+
+Header-only middle-out codec, block geometry is fixed at compile time.
+
+Data are split to Segments segments compressed side by side, row i holds value i of every segment
+xored with value i - 1 of the same segment:
+
+	T        reference[Segments]   first value of each segment
+	rows                           one per value 1 .. blockSize - 1 of the segments
+	T        rest[count % Segments]
+	uint8_t  version               0x7E followed by 6 zero bytes (read-ahead padding)
+
+	row:
+	Mask     sameMask              bit j is set if value of segment j repeats
+	header                         unless all values repeat: max length - 1 and trailing zero
+	                               bytes of each stored xored value, OFFSET_BITS each
+	payload                        max length bytes of each stored xored value
+
+Codec<8 byte T, 8> is the format of Scalar, Avx2 and Avx52, Codec<4 byte T, 16> the one of Scalar32
+and Avx52x32, so the codec reads and writes data of the compiled kernels. Other geometries (e.g.
+Codec<double, 16>) are readable by the same Codec only. Up to 2 * Segments values are stored
+uncompressed.
+
+*/
+template <typename T, size_t Segments>
+struct CodecGeometry {
+	static_assert(sizeof(T) == 8 || sizeof(T) == 4, "Must use datatype with length of 4 or 8.");
+	static_assert(Segments == 8 || Segments == 16, "Segments must be 8 or 16.");
+
+	// value as bits
+	typedef typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type Word;
+	typedef typename std::conditional<Segments == 8, uint8_t, uint16_t>::type Mask;
+
+	static constexpr size_t SEGMENTS = Segments;
+	static constexpr size_t MIN_DATA_SIZE_COMPRESSION_TRESHOLD = 2 * Segments;
+	static constexpr Mask ALL_SAME = static_cast<Mask>(~0);
+
+	// lengths 1 .. sizeof(T) are stored as length - 1, offsets are 0 .. sizeof(T) - 1
+	static constexpr int OFFSET_BITS = sizeof(T) == 8 ? 3 : 2;
+	static constexpr uint64_t OFFSET_MASK = (1 << OFFSET_BITS) - 1;
+
+	static constexpr uint8_t VERSION = 0x7E;
+	static constexpr size_t PADDING_SIZE = 6;
+
+	// bytes of row header by count of stored values (max length + offsets, rounded up to bytes)
+	struct HeaderSizes {
+		size_t sizes[Segments + 1];
+
+		constexpr HeaderSizes() : sizes() {
+			for (size_t stored = 0; stored <= Segments; stored++) {
+				sizes[stored] = ((stored + 1) * OFFSET_BITS + 7) >> 3;
+			}
+		}
+	};
+
+	// masks of the lowest length bytes by length
+	struct LengthMasks {
+		Word masks[sizeof(T) + 1];
+
+		constexpr LengthMasks() : masks() {
+			for (size_t length = 1; length <= sizeof(T); length++) {
+				masks[length] = static_cast<Word>(~0ull) >> (8 * (sizeof(T) - length));
+			}
+		}
+	};
+
+	static constexpr HeaderSizes HEADER_SIZES = HeaderSizes();
+	static constexpr LengthMasks LENGTH_MASKS = LengthMasks();
+
+	// header is written and read as one uint64_t
+	static_assert((Segments + 1) * OFFSET_BITS <= 64, "Header must fit to 64 bits.");
+};
+
+template <typename T, size_t Segments>
+constexpr typename CodecGeometry<T, Segments>::HeaderSizes CodecGeometry<T, Segments>::HEADER_SIZES;
+
+template <typename T, size_t Segments>
+constexpr typename CodecGeometry<T, Segments>::LengthMasks CodecGeometry<T, Segments>::LENGTH_MASKS;
+
+namespace backend {
+
+/*
+ Branchless row coding without intrinsics, builds for any target. SIMD kernels need their own target
+ flags and stay in the compiled library (middleout.hpp picks one at runtime).
+*/
+struct Portable {
+	/*
+	 Writes row of curr values xored with prev ones, returns its length. Writes up to 8 bytes past
+	 the row, these are overwritten by the following data or the trailer.
+	*/
+	template <typename G>
+	static inline size_t encodeRow(const typename G::Word* prev,
+	                               const typename G::Word* curr,
+	                               char* output) {
+		typedef typename G::Word Word;
+
+		typename G::Mask sameMask = 0;
+		int maxLength = 0;
+		uint64_t offsets = 0;
+		int offsetsShift = 0;
+		size_t storedCount = 0;
+
+		// temp arrays allow to perform compression logic wihout loop dependency
+		Word xoredShifted[G::SEGMENTS];
+		int dataStoreFlags[G::SEGMENTS];
+
+		for (size_t j = 0; j < G::SEGMENTS; j++) {
+			Word xored = prev[j] ^ curr[j];
+			int isStored = xored != 0;
+
+			// set bits keep both counts defined for zero (length is negative then)
+			int rightOffsetBytes = countTrailingZeros(xored | topBit<Word>()) >> 3;
+			int leftOffsetBytes = countLeadingZeros(xored | 1) >> 3;
+			maxLength = std::max(int(sizeof(Word)) - leftOffsetBytes - rightOffsetBytes, maxLength);
+
+			sameMask |= (1 - isStored) << j;
+			offsets |= (uint64_t)(rightOffsetBytes * isStored) << offsetsShift;
+			offsetsShift += G::OFFSET_BITS * isStored;
+			storedCount += isStored;
+
+			// aligned to right
+			xoredShifted[j] = xored >> (8 * rightOffsetBytes);
+			dataStoreFlags[j] = isStored;
+		}
+
+		memcpy(output, &sameMask, sizeof(sameMask));
+		size_t outputIndex = sizeof(sameMask);
+
+		// do not store max length and offsets if all values are the same
+		if (sameMask == G::ALL_SAME) {
+			return outputIndex;
+		}
+
+		uint64_t header = offsets << G::OFFSET_BITS | (maxLength - 1);
+		memcpy(&output[outputIndex], &header, sizeof(header));
+		outputIndex += G::HEADER_SIZES.sizes[storedCount];
+
+		// stored values overwrite unused bytes of previous ones
+		for (size_t j = 0; j < G::SEGMENTS; j++) {
+			memcpy(&output[outputIndex], &xoredShifted[j], sizeof(Word));
+			outputIndex += dataStoreFlags[j] * maxLength;
+		}
+		return outputIndex;
+	}
+
+	/*
+	 Xors values (the previous row) with row of input, returns its length. Reads up to 8 bytes past
+	 the row.
+	*/
+	template <typename G>
+	static inline size_t decodeRow(const char* input, typename G::Word* values) {
+		typedef typename G::Word Word;
+
+		typename G::Mask sameMask;
+		memcpy(&sameMask, input, sizeof(sameMask));
+		size_t inputIndex = sizeof(sameMask);
+
+		if (sameMask == G::ALL_SAME) {
+			return inputIndex;
+		}
+
+		uint64_t header;
+		memcpy(&header, &input[inputIndex], sizeof(header));
+		int maxLength = (header & G::OFFSET_MASK) + 1;
+		Word lengthMask = G::LENGTH_MASKS.masks[maxLength];
+		inputIndex += G::HEADER_SIZES.sizes[G::SEGMENTS - __builtin_popcount(sameMask)];
+
+		int offsetsShift = G::OFFSET_BITS;  // skip max length
+		for (size_t j = 0; j < G::SEGMENTS; j++) {
+			// all bits set if value is stored
+			Word isStored = static_cast<Word>((sameMask >> j) & 1) - 1;
+
+			Word toXor;
+			memcpy(&toXor, &input[inputIndex], sizeof(Word));
+			int shiftBits = ((header >> offsetsShift) & G::OFFSET_MASK) * 8;
+
+			// branchless: not stored values xor zero and do not move the cursors
+			values[j] ^= ((toXor & lengthMask) << shiftBits) & isStored;
+			offsetsShift += G::OFFSET_BITS & isStored;
+			inputIndex += maxLength & isStored;
+		}
+		return inputIndex;
+	}
+
+   private:
+	template <typename Word>
+	static constexpr Word topBit() {
+		return static_cast<Word>(1) << (8 * sizeof(Word) - 1);
+	}
+
+	static inline int countTrailingZeros(uint64_t x) { return __builtin_ctzll(x); }
+	static inline int countTrailingZeros(uint32_t x) { return __builtin_ctz(x); }
+	static inline int countLeadingZeros(uint64_t x) { return __builtin_clzll(x); }
+	static inline int countLeadingZeros(uint32_t x) { return __builtin_clz(x); }
+};
+
+}  // end namespace backend
+
+/*
+ Compression by Backend's rows, everything inlines to the caller. Default geometry is the format of
+ compiled kernels for the type.
+*/
+template <typename T,
+          size_t Segments = (sizeof(T) == 8 ? 8 : 16),
+          typename Backend = backend::Portable>
+class Codec {
+   public:
+	typedef CodecGeometry<T, Segments> Geometry;
+	typedef typename Geometry::Word Word;
+
+	// longest row: mask, header and all values stored
+	static constexpr size_t MAX_ROW_SIZE = sizeof(typename Geometry::Mask) +
+	                                       Geometry::HEADER_SIZES.sizes[Segments] +
+	                                       sizeof(T) * Segments;
+
+	static constexpr size_t maxCompressedSize(size_t count) {
+		// reference values, rows (mask, header and all values stored), rest of values; there is one
+		// row less than counted, it leaves room for the trailer
+		return sizeof(T) * Segments + count / Segments * MAX_ROW_SIZE +
+		       sizeof(T) * (count % Segments);
+	}
+
+	/*
+	 Exact worst case size of compressed data: reference values, all rows stored in full, rest of
+	 values and the trailer. Unlike maxCompressedSize it leaves no room for writes past the data, so
+	 it sizes compressBounded output only.
+	*/
+	static constexpr size_t compressBound(size_t count) {
+		return count <= Geometry::MIN_DATA_SIZE_COMPRESSION_TRESHOLD
+		           ? sizeof(T) * count
+		           : sizeof(T) * Segments + (count / Segments - 1) * MAX_ROW_SIZE +
+		                 sizeof(T) * (count % Segments) + 1 + Geometry::PADDING_SIZE;
+	}
+
+	/*
+	 Compresses count values to output. Returns 0 (nothing written) if capacity is less than
+	 maxCompressedSize(count).
+	*/
+	static size_t compress(const T* data, size_t count, char* output, size_t capacity) {
+		if (capacity < maxCompressedSize(count)) {
+			// output could overflow
+			return 0;
+		}
+		return compressData<false>(data, count, output, capacity);
+	}
+
+	/*
+	 Compresses count values to output of any capacity, never writes past it. Returns 0 if
+	 compressed data do not fit, output is clobbered then. Capacity of compressBound(count) always
+	 suffices.
+	*/
+	static size_t compressBounded(const T* data, size_t count, char* output, size_t capacity) {
+		return compressData<true>(data, count, output, capacity);
+	}
+
+	static void decompress(const char* input, size_t itemsCount, T* data) {
+		if (itemsCount <= Geometry::MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+			// not enough data to compress
+			memcpy(data, input, sizeof(T) * itemsCount);
+			return;
+		}
+
+		// middle-out block size
+		size_t blockSize = itemsCount / Segments;
+
+		Word row[Segments];
+		memcpy(row, input, sizeof(row));
+		for (size_t j = 0; j < Segments; j++) {
+			memcpy(&data[blockSize * j], &row[j], sizeof(T));
+		}
+		size_t inputIndex = sizeof(row);
+
+		for (size_t i = 1; i < blockSize; i++) {
+			inputIndex += Backend::template decodeRow<Geometry>(&input[inputIndex], row);
+			for (size_t j = 0; j < Segments; j++) {
+				memcpy(&data[blockSize * j + i], &row[j], sizeof(T));
+			}
+		}
+
+		// copy rest of data (uncompressed)
+		size_t restCount = itemsCount - blockSize * Segments;
+		memcpy(&data[blockSize * Segments], &input[inputIndex], sizeof(T) * restCount);
+	}
+
+   private:
+	template <bool BOUNDED>
+	static size_t compressData(const T* data, size_t count, char* output, size_t capacity) {
+		if (count <= Geometry::MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+			if (BOUNDED && capacity < sizeof(T) * count) {
+				return 0;
+			}
+			// not enough data to compress
+			memcpy(output, data, sizeof(T) * count);
+			return sizeof(T) * count;
+		}
+
+		if (BOUNDED && capacity < sizeof(T) * Segments) {
+			// reference values do not fit
+			return 0;
+		}
+
+		// "middle-out" data block size
+		size_t blockSize = count / Segments;
+
+		Word prev[Segments];
+		for (size_t j = 0; j < Segments; j++) {
+			memcpy(&prev[j], &data[blockSize * j], sizeof(T));
+		}
+		memcpy(output, prev, sizeof(prev));
+		size_t outputIndex = sizeof(prev);
+
+		for (size_t i = 1; i < blockSize; i++) {
+			Word curr[Segments];
+			for (size_t j = 0; j < Segments; j++) {
+				memcpy(&curr[j], &data[blockSize * j + i], sizeof(T));
+			}
+
+			// rows far enough from the end of output are written in place, write-ahead included
+			if (!BOUNDED || outputIndex + MAX_ROW_SIZE + sizeof(uint64_t) <= capacity) {
+				outputIndex +=
+				    Backend::template encodeRow<Geometry>(prev, curr, &output[outputIndex]);
+			} else {
+				char row[MAX_ROW_SIZE + sizeof(uint64_t)];
+				size_t rowLength = Backend::template encodeRow<Geometry>(prev, curr, row);
+				if (outputIndex + rowLength > capacity) {
+					return 0;
+				}
+				memcpy(&output[outputIndex], row, rowLength);
+				outputIndex += rowLength;
+			}
+			memcpy(prev, curr, sizeof(prev));
+		}
+
+		// write rest of the data without any compression
+		size_t restCount = count - blockSize * Segments;
+		if (BOUNDED &&
+		    capacity - outputIndex < sizeof(T) * restCount + 1 + Geometry::PADDING_SIZE) {
+			return 0;
+		}
+		memcpy(&output[outputIndex], &data[blockSize * Segments], sizeof(T) * restCount);
+		outputIndex += sizeof(T) * restCount;
+
+		output[outputIndex++] = Geometry::VERSION;
+		memset(&output[outputIndex], 0, Geometry::PADDING_SIZE);
+		return outputIndex + Geometry::PADDING_SIZE;
+	}
+};
+
+template <typename T, size_t Segments, typename Backend>
+constexpr size_t Codec<T, Segments, Backend>::MAX_ROW_SIZE;
+
+}  // end namespace middleout
+
+#endif /* CODEC_H */
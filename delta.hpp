@@ -0,0 +1,38 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef DELTA_H
+#define DELTA_H
+
+namespace middleout {
+
+/*
+
+Optional transform of 64bit integers (e.g. timestamps), applied by the kernels to every row as it
+is compressed (and reverted as it is decoded), the previous row and deltas are kept in registers.
+
+XOR of two consecutive timestamps flips low bits unpredictably, while their difference is (nearly)
+constant. Every middle-out segment is transformed on its own: its first value (the reference value)
+is kept, the others are replaced by zigzag encoded difference to the previous value (delta) or by
+difference of two consecutive deltas (delta of delta, zero for a regular interval). Values behind
+the segments (stored uncompressed) are kept too.
+
+*/
+enum Transform {
+	TRANSFORM_NONE = 0,
+	TRANSFORM_DELTA = 1,
+	TRANSFORM_DELTA_OF_DELTA = 2
+};
+
+}  // end namespace middleout
+
+#endif /* DELTA_H */
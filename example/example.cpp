@@ -223,7 +223,8 @@ void testMyData() {
 
 int main(void) {
 	auto msg = "Middle-out compression example";
-	std::cout << msg << std::endl << std::endl;
+	std::cout << msg << std::endl;
+	std::cout << "kernel: " << middleout::kernelName() << std::endl << std::endl;
 
 	std::cout << "4 MB of sequence (0.1 * position). Randomly repeating." << std::endl;
 	testSequence<double>(0, 500000.0);
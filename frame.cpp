@@ -0,0 +1,645 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "frame.hpp"
+#include "helpers.hpp"
+#include "scalar.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace middleout {
+
+template class Frame<double>;
+template class Frame<int64_t>;
+template class Frame<uint64_t>;
+
+// magic, version, type, flags
+const size_t FRAME_FIXED_HEADER_SIZE = 5;
+
+// mode and error
+const size_t FRAME_ERROR_BOUND_SIZE = sizeof(uint8_t) + sizeof(double);
+
+static uint8_t getType(const int64_t*) {
+	return FRAME_TYPE_INT64;
+}
+
+static uint8_t getType(const uint64_t*) {
+	return FRAME_TYPE_UINT64;
+}
+
+static uint8_t getType(const double*) {
+	return FRAME_TYPE_DOUBLE;
+}
+
+static uint8_t getTransformFlags(Transform transform) {
+	switch (transform) {
+		case TRANSFORM_DELTA:
+			return FRAME_DELTA;
+		case TRANSFORM_DELTA_OF_DELTA:
+			return FRAME_DELTA_OF_DELTA;
+		default:
+			return 0;
+	}
+}
+
+//
+// CHECKSUM
+//
+
+const uint64_t CHECKSUM_PRIME_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t CHECKSUM_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+static inline uint64_t rotateLeft(uint64_t x, int bits) {
+	return (x << bits) | (x >> (64 - bits));
+}
+
+static inline uint64_t checksumRound(uint64_t accumulator, uint64_t word) {
+	return rotateLeft(accumulator + word * CHECKSUM_PRIME_2, 31) * CHECKSUM_PRIME_1;
+}
+
+static inline uint64_t readWord(const char* input) {
+	uint64_t word;
+	memcpy(&word, input, sizeof(word));
+	return word;
+}
+
+/*
+ 32 bit hash of payload, 4 independent accumulators hide multiplication latency
+*/
+static uint32_t checksum(const char* input, size_t size) {
+	uint64_t accumulators[4] = {CHECKSUM_PRIME_1 + CHECKSUM_PRIME_2, CHECKSUM_PRIME_2, 0,
+	                            0 - CHECKSUM_PRIME_1};
+
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		for (size_t j = 0; j < 4; j++) {
+			accumulators[j] = checksumRound(accumulators[j], readWord(&input[i + 8 * j]));
+		}
+	}
+
+	uint64_t hash = rotateLeft(accumulators[0], 1) + rotateLeft(accumulators[1], 7) +
+	                rotateLeft(accumulators[2], 12) + rotateLeft(accumulators[3], 18) + size;
+	for (; i + 8 <= size; i += 8) {
+		hash = checksumRound(hash, readWord(&input[i]));
+	}
+	for (; i < size; i++) {
+		hash = checksumRound(hash, (uint8_t)input[i]);
+	}
+
+	// final avalanche
+	hash ^= hash >> 33;
+	hash *= CHECKSUM_PRIME_2;
+	hash ^= hash >> 29;
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+//
+// INDEX
+//
+
+/*
+ Offset of the following row + values of the row + state of the reverse transform: decoded values
+ for delta, decoded values and deltas for delta of delta
+*/
+static size_t getCheckpointSize(Transform transform) {
+	return sizeof(uint64_t) * (1 + VECTOR_SIZE * (1 + transform));
+}
+
+static size_t getCheckpointsCount(size_t count, size_t indexInterval) {
+	if (indexInterval == 0 || count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return 0;
+	}
+	// row 0 are the reference values
+	return (count / VECTOR_SIZE - 1) / indexInterval;
+}
+
+static size_t getIndexSize(size_t count, size_t indexInterval, Transform transform) {
+	return getCheckpointsCount(count, indexInterval) * getCheckpointSize(transform);
+}
+
+/*
+ Writes checkpoint of every indexInterval-th row, row offsets are found by walking the payload.
+ Values of the rows are compressed ones, truncated within errorBound or transformed the way the
+ kernel does while compressing.
+*/
+template <typename T>
+static void writeIndex(const T* data,
+                       size_t count,
+                       const char* payload,
+                       size_t indexInterval,
+                       Transform transform,
+                       ErrorBound errorBound,
+                       char* output) {
+	size_t checkpointsCount = getCheckpointsCount(count, indexInterval);
+	size_t blockSize = count / VECTOR_SIZE;
+	int truncationBase = getTruncationBase(errorBound);
+	const uint64_t* integers = reinterpret_cast<const uint64_t*>(data);
+
+	size_t payloadIndex = sizeof(T) * VECTOR_SIZE;
+	size_t row = 0;
+	for (size_t checkpoint = 1; checkpoint <= checkpointsCount; checkpoint++) {
+		for (; row < checkpoint * indexInterval; row++) {
+			payloadIndex += getRowLength(&payload[payloadIndex]);
+		}
+
+		uint64_t offset = payloadIndex;
+		memcpy(output, &offset, sizeof(offset));
+		output += sizeof(offset);
+
+		// state of the transform at the previous row, row 1 has no previous delta
+		uint64_t values[VECTOR_SIZE];
+		uint64_t decoded[VECTOR_SIZE];
+		uint64_t deltas[VECTOR_SIZE] = {0};
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			size_t position = blockSize * j + row;
+			values[j] = truncateBits(integers[position], errorBound.mode, truncationBase);
+			decoded[j] = integers[position - 1];
+			if (transform == TRANSFORM_DELTA_OF_DELTA && row > 1) {
+				deltas[j] = integers[position - 1] - integers[position - 2];
+			}
+		}
+		if (transform != TRANSFORM_NONE) {
+			encodeDeltaRow(values, decoded, deltas, transform);
+		}
+
+		memcpy(output, values, sizeof(values));
+		output += sizeof(values);
+		if (transform == TRANSFORM_NONE) {
+			continue;
+		}
+		memcpy(output, decoded, sizeof(decoded));
+		output += sizeof(decoded);
+		if (transform == TRANSFORM_DELTA_OF_DELTA) {
+			memcpy(output, deltas, sizeof(deltas));
+			output += sizeof(deltas);
+		}
+	}
+}
+
+template <typename T>
+size_t Frame<T>::maxCompressedSize(size_t count, size_t indexInterval, Transform transform) {
+	size_t maxPayloadSize = Scalar<T>::maxCompressedSize(count);
+	size_t size = FRAME_FIXED_HEADER_SIZE + getVarintLength(count) +
+	              getVarintLength(maxPayloadSize) + sizeof(uint32_t) + FRAME_ERROR_BOUND_SIZE +
+	              maxPayloadSize;
+	if (indexInterval != 0) {
+		size += getVarintLength(indexInterval) + getIndexSize(count, indexInterval, transform);
+	}
+	return size;
+}
+
+/*
+ Writes frame of count values, payload is written by compressPayload(data, count, payload,
+ capacity), which truncates or transforms them by errorBound or transform. Capacity must be checked
+ by caller.
+*/
+template <typename T, typename COMPRESS>
+static size_t writeFrame(COMPRESS compressPayload,
+                         const T* data,
+                         size_t count,
+                         char* output,
+                         bool checksum,
+                         size_t indexInterval,
+                         Transform transform,
+                         ErrorBound errorBound) {
+	output[0] = FRAME_MAGIC_0;
+	output[1] = FRAME_MAGIC_1;
+	output[2] = FRAME_VERSION;
+	output[3] = getType(data);
+	output[4] = (checksum ? FRAME_CHECKSUM : 0) | (indexInterval != 0 ? FRAME_INDEX : 0) |
+	            getTransformFlags(transform) |
+	            (errorBound.mode != ERROR_BOUND_NONE ? FRAME_ERROR_BOUND : 0);
+	size_t outputIndex = FRAME_FIXED_HEADER_SIZE;
+
+	size_t countLength = getVarintLength(count);
+	writeVarint(&output[outputIndex], count, countLength);
+	outputIndex += countLength;
+
+	// payload size is known after compression, reserve space for the max one
+	size_t maxPayloadSize = Scalar<T>::maxCompressedSize(count);
+	size_t payloadSizeIndex = outputIndex;
+	size_t payloadSizeLength = getVarintLength(maxPayloadSize);
+	outputIndex += payloadSizeLength;
+
+	size_t checksumIndex = outputIndex;
+	if (checksum) {
+		outputIndex += sizeof(uint32_t);
+	}
+
+	if (indexInterval != 0) {
+		size_t intervalLength = getVarintLength(indexInterval);
+		writeVarint(&output[outputIndex], indexInterval, intervalLength);
+		outputIndex += intervalLength;
+	}
+
+	if (errorBound.mode != ERROR_BOUND_NONE) {
+		output[outputIndex] = errorBound.mode;
+		memcpy(&output[outputIndex + 1], &errorBound.error, sizeof(double));
+		outputIndex += FRAME_ERROR_BOUND_SIZE;
+	}
+
+	// index is filled in once payload is written
+	size_t indexIndex = outputIndex;
+	outputIndex += getIndexSize(count, indexInterval, transform);
+
+	char* payload = &output[outputIndex];
+	size_t payloadSize = compressPayload(data, count, payload, maxPayloadSize);
+
+	writeVarint(&output[payloadSizeIndex], payloadSize, payloadSizeLength);
+	writeIndex(data, count, payload, indexInterval, transform, errorBound, &output[indexIndex]);
+	if (checksum) {
+		uint32_t frameChecksum =
+		    middleout::checksum(&output[indexIndex], outputIndex - indexIndex + payloadSize);
+		memcpy(&output[checksumIndex], &frameChecksum, sizeof(frameChecksum));
+	}
+
+	return outputIndex + payloadSize;
+}
+
+template <typename T>
+size_t Frame<T>::compress(CompressFunction compress,
+                          const T* data,
+                          size_t count,
+                          char* output,
+                          size_t capacity,
+                          bool checksum,
+                          size_t indexInterval) {
+	if (capacity < maxCompressedSize(count, indexInterval, TRANSFORM_NONE)) {
+		// output could overflow
+		return 0;
+	}
+	return writeFrame(compress, data, count, output, checksum, indexInterval, TRANSFORM_NONE,
+	                  LOSSLESS);
+}
+
+template <typename T>
+size_t Frame<T>::compress(TransformedCompressFunction compress,
+                          const T* data,
+                          size_t count,
+                          char* output,
+                          size_t capacity,
+                          bool checksum,
+                          size_t indexInterval,
+                          Transform transform) {
+	if (capacity < maxCompressedSize(count, indexInterval, transform)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (transform != TRANSFORM_NONE && getType(data) == FRAME_TYPE_DOUBLE) {
+		// only integers are transformed
+		return 0;
+	}
+
+	// values are transformed by the kernel while compressed, no copy of them
+	auto compressTransformed = [&](const T* values, size_t count, char* payload, size_t capacity) {
+		return compress(values, count, payload, capacity, transform);
+	};
+	return writeFrame(compressTransformed, data, count, output, checksum, indexInterval, transform,
+	                  LOSSLESS);
+}
+
+template <typename T>
+size_t Frame<T>::compress(LossyCompressFunction compress,
+                          const T* data,
+                          size_t count,
+                          char* output,
+                          size_t capacity,
+                          bool checksum,
+                          size_t indexInterval,
+                          ErrorBound errorBound) {
+	if (capacity < maxCompressedSize(count, indexInterval, TRANSFORM_NONE)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (!isValidErrorBound(errorBound) || getType(data) != FRAME_TYPE_DOUBLE) {
+		// only doubles are truncated
+		return 0;
+	}
+
+	// values are truncated by the kernel while compressed, no copy of them
+	auto compressTruncated = [&](const T* values, size_t count, char* payload, size_t capacity) {
+		return compress(values, count, payload, capacity, errorBound);
+	};
+	return writeFrame(compressTruncated, data, count, output, checksum, indexInterval,
+	                  TRANSFORM_NONE, errorBound);
+}
+
+/*
+ Reads varint, distinguishing input which ends within the varint
+*/
+static FrameStatus readHeaderVarint(const char* input,
+                                    size_t size,
+                                    size_t* inputIndex,
+                                    uint64_t* value) {
+	size_t length = readVarint(&input[*inputIndex], size - *inputIndex, value);
+	if (length == 0) {
+		return size - *inputIndex < 10 ? FRAME_TRUNCATED : FRAME_MALFORMED;
+	}
+	*inputIndex += length;
+	return FRAME_VALID;
+}
+
+template <typename T>
+FrameStatus Frame<T>::parse(const char* input, size_t inputSize, FrameInfo* info) {
+	const uint8_t prefix[] = {FRAME_MAGIC_0, FRAME_MAGIC_1, FRAME_VERSION};
+	for (size_t i = 0; i < sizeof(prefix) && i < inputSize; i++) {
+		if ((uint8_t)input[i] != prefix[i]) {
+			return FRAME_MALFORMED;
+		}
+	}
+	if (inputSize < FRAME_FIXED_HEADER_SIZE) {
+		return FRAME_TRUNCATED;
+	}
+
+	info->type = input[3];
+	info->flags = input[4];
+	if (info->type < FRAME_TYPE_INT64 || info->type > FRAME_TYPE_DOUBLE ||
+	    (info->flags & ~(FRAME_CHECKSUM | FRAME_INDEX | FRAME_DELTA | FRAME_DELTA_OF_DELTA |
+	                     FRAME_ERROR_BOUND)) != 0) {
+		// unknown type or features
+		return FRAME_MALFORMED;
+	}
+
+	info->transform = TRANSFORM_NONE;
+	if (info->flags & (FRAME_DELTA | FRAME_DELTA_OF_DELTA)) {
+		if ((info->flags & FRAME_DELTA) && (info->flags & FRAME_DELTA_OF_DELTA)) {
+			return FRAME_MALFORMED;
+		}
+		if (info->type == FRAME_TYPE_DOUBLE) {
+			// only integers are transformed
+			return FRAME_MALFORMED;
+		}
+		info->transform = info->flags & FRAME_DELTA ? TRANSFORM_DELTA : TRANSFORM_DELTA_OF_DELTA;
+	}
+	size_t inputIndex = FRAME_FIXED_HEADER_SIZE;
+
+	FrameStatus status = readHeaderVarint(input, inputSize, &inputIndex, &info->itemsCount);
+	if (status != FRAME_VALID) {
+		return status;
+	}
+
+	uint64_t payloadSize;
+	status = readHeaderVarint(input, inputSize, &inputIndex, &payloadSize);
+	if (status != FRAME_VALID) {
+		return status;
+	}
+
+	info->checksum = 0;
+	if (info->flags & FRAME_CHECKSUM) {
+		if (inputSize - inputIndex < sizeof(uint32_t)) {
+			return FRAME_TRUNCATED;
+		}
+		memcpy(&info->checksum, &input[inputIndex], sizeof(uint32_t));
+		inputIndex += sizeof(uint32_t);
+	}
+
+	uint64_t indexInterval = 0;
+	if (info->flags & FRAME_INDEX) {
+		status = readHeaderVarint(input, inputSize, &inputIndex, &indexInterval);
+		if (status != FRAME_VALID) {
+			return status;
+		}
+		if (indexInterval == 0) {
+			return FRAME_MALFORMED;
+		}
+	}
+
+	info->errorBound = LOSSLESS;
+	if (info->flags & FRAME_ERROR_BOUND) {
+		if (info->type != FRAME_TYPE_DOUBLE) {
+			// only doubles are truncated
+			return FRAME_MALFORMED;
+		}
+		if (inputSize - inputIndex < FRAME_ERROR_BOUND_SIZE) {
+			return FRAME_TRUNCATED;
+		}
+		uint8_t mode = input[inputIndex];
+		if (mode != ERROR_BOUND_ABSOLUTE && mode != ERROR_BOUND_RELATIVE) {
+			return FRAME_MALFORMED;
+		}
+		info->errorBound.mode = (ErrorBoundMode)mode;
+		memcpy(&info->errorBound.error, &input[inputIndex + 1], sizeof(double));
+		inputIndex += FRAME_ERROR_BOUND_SIZE;
+		if (!isValidErrorBound(info->errorBound)) {
+			return FRAME_MALFORMED;
+		}
+	}
+
+	if (payloadSize < getMinCompressedSize(info->itemsCount)) {
+		// payload too short for its items
+		return FRAME_MALFORMED;
+	}
+
+	info->headerSize = inputIndex;
+	info->indexInterval = indexInterval;
+	info->indexSize = getIndexSize(info->itemsCount, indexInterval, info->transform);
+	info->payloadSize = payloadSize;
+
+	if (info->indexSize > inputSize - inputIndex ||
+	    payloadSize > inputSize - inputIndex - info->indexSize) {
+		return FRAME_TRUNCATED;
+	}
+	return FRAME_VALID;
+}
+
+template <typename T>
+bool Frame<T>::readInfo(const char* input, size_t inputSize, FrameInfo* info) {
+	return parse(input, inputSize, info) == FRAME_VALID;
+}
+
+/*
+ Payload of valid frame is decompressed by decompressPayload(payload, payloadSize, itemsCount,
+ data, transform)
+*/
+template <typename T, typename DECOMPRESS>
+static bool readFrame(DECOMPRESS decompressPayload,
+                      const char* input,
+                      size_t inputSize,
+                      T* data,
+                      size_t capacity) {
+	FrameInfo info;
+	if (!Frame<T>::readInfo(input, inputSize, &info) || info.type != getType(data) ||
+	    info.itemsCount > capacity) {
+		return false;
+	}
+
+	if ((info.flags & FRAME_CHECKSUM) &&
+	    checksum(&input[info.headerSize], info.indexSize + info.payloadSize) != info.checksum) {
+		return false;
+	}
+
+	return decompressPayload(&input[info.headerSize + info.indexSize], info.payloadSize,
+	                         info.itemsCount, data, info.transform) == DECODE_OK;
+}
+
+template <typename T>
+bool Frame<T>::decompress(DecompressFunction decompress,
+                          const char* input,
+                          size_t inputSize,
+                          T* data,
+                          size_t capacity) {
+	auto decompressPlain = [&](const char* payload, size_t payloadSize, size_t itemsCount,
+	                           T* data, Transform transform) {
+		if (transform != TRANSFORM_NONE) {
+			// transform would not be reverted
+			return DECODE_MALFORMED;
+		}
+		return decompress(payload, payloadSize, itemsCount, data);
+	};
+	return readFrame(decompressPlain, input, inputSize, data, capacity);
+}
+
+template <typename T>
+bool Frame<T>::decompress(TransformedDecompressFunction decompress,
+                          const char* input,
+                          size_t inputSize,
+                          T* data,
+                          size_t capacity) {
+	return readFrame(decompress, input, inputSize, data, capacity);
+}
+
+/*
+ Decompresses rows rowFrom to rowTo (inclusive) and stores their values falling into from - to.
+ Checkpoint offsets and rows are bounds-checked the way decompressSafe checks rows, returns false
+ if they do not fit in front of the uncompressed rest.
+*/
+template <typename T>
+static bool decompressRows(const FrameInfo& info,
+                           const char* input,
+                           size_t rowFrom,
+                           size_t rowTo,
+                           size_t from,
+                           size_t to,
+                           T* data) {
+	const char* index = &input[info.headerSize];
+	const char* payload = index + info.indexSize;
+	size_t blockSize = info.itemsCount / VECTOR_SIZE;
+	size_t rowsEnd = getRowsEnd(info.payloadSize, info.itemsCount);
+
+	// start at the nearest checkpoint, reference values are the checkpoint 0
+	size_t checkpoint = info.indexInterval == 0 ? 0 : rowFrom / info.indexInterval;
+	uint64_t values[VECTOR_SIZE];
+	// state of the reverse transform, decoded values are the values of not transformed frame
+	uint64_t decoded[VECTOR_SIZE];
+	uint64_t deltas[VECTOR_SIZE] = {0};
+	uint64_t payloadIndex;
+	if (checkpoint == 0) {
+		memcpy(values, payload, sizeof(values));
+		memcpy(decoded, payload, sizeof(decoded));
+		payloadIndex = sizeof(values);
+	} else {
+		size_t checkpointSize = getCheckpointSize(info.transform);
+		const char* stored = &index[(checkpoint - 1) * checkpointSize];
+		memcpy(&payloadIndex, stored, sizeof(payloadIndex));
+		// offsets increase from the first row on (every row takes a byte at least)
+		uint64_t previousIndex = sizeof(values);
+		if (checkpoint > 1) {
+			memcpy(&previousIndex, stored - checkpointSize, sizeof(previousIndex));
+		}
+		if (payloadIndex <= previousIndex || payloadIndex > rowsEnd) {
+			return false;
+		}
+		stored += sizeof(payloadIndex);
+		memcpy(values, stored, sizeof(values));
+		memcpy(decoded, info.transform == TRANSFORM_NONE ? stored : stored + sizeof(values),
+		       sizeof(decoded));
+		if (info.transform == TRANSFORM_DELTA_OF_DELTA) {
+			memcpy(deltas, stored + sizeof(values) + sizeof(decoded), sizeof(deltas));
+		}
+	}
+
+	for (size_t row = checkpoint * info.indexInterval; row <= rowTo; row++) {
+		if (row > checkpoint * info.indexInterval) {
+			if (payloadIndex + MAX_ROW_LENGTH <= rowsEnd) {
+				payloadIndex += decompressRow(&payload[payloadIndex], values);
+			} else {
+				// rows close to the rest are checked and decoded from a padded copy
+				char padded[MAX_ROW_LENGTH + ROW_READ_AHEAD];
+				size_t length = padRow(&payload[payloadIndex], rowsEnd - payloadIndex, padded);
+				if (length == 0) {
+					return false;
+				}
+				decompressRow(padded, values);
+				payloadIndex += length;
+			}
+			if (info.transform == TRANSFORM_NONE) {
+				memcpy(decoded, values, sizeof(decoded));
+			} else {
+				decodeDeltaRow(values, decoded, deltas, info.transform);
+			}
+		}
+		if (row < rowFrom) {
+			continue;
+		}
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			size_t position = blockSize * j + row;
+			if (position >= from && position < to) {
+				memcpy(&data[position - from], &decoded[j], sizeof(T));
+			}
+		}
+	}
+	return true;
+}
+
+template <typename T>
+bool Frame<T>::decompressRange(const char* input,
+                               size_t inputSize,
+                               size_t from,
+                               size_t to,
+                               T* data) {
+	FrameInfo info;
+	if (!readInfo(input, inputSize, &info) || info.type != getType(data) || from > to ||
+	    to > info.itemsCount) {
+		return false;
+	}
+
+	const char* payload = &input[info.headerSize + info.indexSize];
+	if (info.itemsCount <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		// stored uncompressed
+		memcpy(data, &payload[sizeof(T) * from], sizeof(T) * (to - from));
+		return true;
+	}
+
+	size_t blockSize = info.itemsCount / VECTOR_SIZE;
+	size_t compressedEnd = std::min(to, blockSize * VECTOR_SIZE);
+	if (from < compressedEnd) {
+		// values of a segment are in consecutive rows
+		size_t rowFrom = from % blockSize;
+		size_t rowTo = (compressedEnd - 1) % blockSize;
+		size_t segmentsCount = (compressedEnd - 1) / blockSize - from / blockSize + 1;
+
+		bool decompressed;
+		if (segmentsCount == 1) {
+			decompressed = decompressRows(info, input, rowFrom, rowTo, from, to, data);
+		} else if (segmentsCount == 2 && rowTo < rowFrom) {
+			// end of one segment and start of the next one, rows in between are not needed
+			decompressed = decompressRows(info, input, 0, rowTo, from, to, data) &&
+			               decompressRows(info, input, rowFrom, blockSize - 1, from, to, data);
+		} else {
+			decompressed = decompressRows(info, input, 0, blockSize - 1, from, to, data);
+		}
+		if (!decompressed) {
+			return false;
+		}
+	}
+
+	// rest of values is stored uncompressed in front of the trailer
+	size_t restStart =
+	    info.payloadSize - TRAILER_SIZE - sizeof(T) * (info.itemsCount % VECTOR_SIZE);
+	for (size_t i = std::max(from, blockSize * VECTOR_SIZE); i < to; i++) {
+		memcpy(&data[i - from], &payload[restStart + sizeof(T) * (i - blockSize * VECTOR_SIZE)],
+		       sizeof(T));
+	}
+	return true;
+}
+
+}  // end namespace middleout
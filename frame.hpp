@@ -0,0 +1,210 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include "delta.hpp"
+#include "precision.hpp"
+#include "status.hpp"
+
+#ifndef FRAME_H
+#define FRAME_H
+
+namespace middleout {
+
+const uint8_t FRAME_MAGIC_0 = 'M';
+const uint8_t FRAME_MAGIC_1 = 'O';
+const uint8_t FRAME_VERSION = 1;
+
+// frame flags
+const uint8_t FRAME_CHECKSUM = 1 << 0;        // checksum of index and payload is stored in header
+const uint8_t FRAME_INDEX = 1 << 1;           // row index for random access precedes payload
+const uint8_t FRAME_DELTA = 1 << 2;           // integers are delta transformed (see delta.hpp)
+const uint8_t FRAME_DELTA_OF_DELTA = 1 << 3;  // integers are delta of delta transformed
+const uint8_t FRAME_ERROR_BOUND = 1 << 4;     // doubles are truncated (see precision.hpp)
+
+// suggested number of rows between two index checkpoints (8K values)
+const size_t FRAME_INDEX_INTERVAL = 1024;
+
+// element types
+const uint8_t FRAME_TYPE_INT64 = 1;
+const uint8_t FRAME_TYPE_UINT64 = 2;
+const uint8_t FRAME_TYPE_DOUBLE = 3;
+
+// result of frame header parsing
+enum FrameStatus {
+	FRAME_VALID,
+	FRAME_TRUNCATED,  // input ends before the end of frame
+	FRAME_MALFORMED
+};
+
+/*
+ Parsed frame header
+*/
+struct FrameInfo {
+	uint8_t type;
+	uint8_t flags;
+	uint64_t itemsCount;
+	size_t headerSize;      // index (if any) starts here, payload follows it
+	size_t indexInterval;   // rows between checkpoints, 0 if FRAME_INDEX flag is not set
+	size_t indexSize;       // index length
+	size_t payloadSize;     // compressed data length
+	uint32_t checksum;      // valid if FRAME_CHECKSUM flag is set
+	Transform transform;    // by FRAME_DELTA and FRAME_DELTA_OF_DELTA flags
+	ErrorBound errorBound;  // ERROR_BOUND_NONE if FRAME_ERROR_BOUND flag is not set
+};
+
+/*
+
+Self-describing container of compressed data.
+
+	uint8_t  magic[2]      'M', 'O'
+	uint8_t  version
+	uint8_t  type          FRAME_TYPE_*
+	uint8_t  flags         FRAME_*
+	varint   itemsCount    LEB128
+	varint   payloadSize   LEB128, zero-padded to the width of the max payload size
+	uint32_t checksum      only if FRAME_CHECKSUM flag is set
+	varint   indexInterval only if FRAME_INDEX flag is set
+	uint8_t  boundMode     ErrorBoundMode, only if FRAME_ERROR_BOUND flag is set
+	double   boundError    only if FRAME_ERROR_BOUND flag is set
+	index                  only if FRAME_INDEX flag is set
+	payload                middle-out compressed data (kernel format, incl. version byte)
+
+Index holds a checkpoint for every indexInterval-th row (except row 0, the reference values), so
+random access decodes at most indexInterval rows per requested range:
+
+	uint64_t offset        start of the following row, relative to payload
+	T        values[8]     values of the row
+
+Payload of a delta transformed frame holds transformed values, so its checkpoints hold the state of
+the reverse transform too:
+
+	T        decoded[8]    original values of the row
+	T        deltas[8]     differences to the previous row, delta of delta only
+
+*/
+template <typename T>
+class Frame {
+   public:
+	typedef size_t (*CompressFunction)(const T* data, size_t count, char* output, size_t capacity);
+	// compressLossy, values are truncated within bound while compressed
+	typedef size_t (*LossyCompressFunction)(const T* data,
+	                                        size_t count,
+	                                        char* output,
+	                                        size_t capacity,
+	                                        ErrorBound bound);
+	// compressTransformed, integers are transformed while compressed
+	typedef size_t (*TransformedCompressFunction)(const T* data,
+	                                              size_t count,
+	                                              char* output,
+	                                              size_t capacity,
+	                                              Transform transform);
+	// validating decompress (decompressSafe), payload comes from outside
+	typedef DecodeStatus (*DecompressFunction)(const char* input,
+	                                           size_t inputSize,
+	                                           size_t itemsCount,
+	                                           T* data);
+	// decompressSafeTransformed, reverts transform of the frame
+	typedef DecodeStatus (*TransformedDecompressFunction)(const char* input,
+	                                                      size_t inputSize,
+	                                                      size_t itemsCount,
+	                                                      T* data,
+	                                                      Transform transform);
+
+	static size_t maxCompressedSize(size_t count, size_t indexInterval, Transform transform);
+
+	/*
+	 Compresses count values to frame by kernel's compress, with row index for random access if
+	 indexInterval is not 0. Returns 0 (nothing written) if capacity is less than
+	 maxCompressedSize(count, indexInterval, TRANSFORM_NONE).
+	*/
+	static size_t compress(CompressFunction compress,
+	                       const T* data,
+	                       size_t count,
+	                       char* output,
+	                       size_t capacity,
+	                       bool checksum,
+	                       size_t indexInterval);
+
+	/*
+	 Frame of integers by kernel's compressTransformed, the transform is recorded in the header.
+	 Returns 0 (nothing written) if capacity is less than maxCompressedSize(count, indexInterval,
+	 transform) or values are doubles.
+	*/
+	static size_t compress(TransformedCompressFunction compress,
+	                       const T* data,
+	                       size_t count,
+	                       char* output,
+	                       size_t capacity,
+	                       bool checksum,
+	                       size_t indexInterval,
+	                       Transform transform);
+
+	/*
+	 Lossy frame of doubles by kernel's compressLossy, which truncates them within errorBound, the
+	 bound is recorded in the header. Returns 0 (nothing written) if capacity is less than
+	 maxCompressedSize(count, indexInterval, TRANSFORM_NONE), values are integers or the bound is
+	 not valid.
+	*/
+	static size_t compress(LossyCompressFunction compress,
+	                       const T* data,
+	                       size_t count,
+	                       char* output,
+	                       size_t capacity,
+	                       bool checksum,
+	                       size_t indexInterval,
+	                       ErrorBound errorBound);
+
+	/*
+	 Parses and validates header (not the checksum). Returns false for malformed header or
+	 frame longer than inputSize.
+	*/
+	static bool readInfo(const char* input, size_t inputSize, FrameInfo* info);
+
+	/*
+	 Same as readInfo, tells truncated frame (more input is needed) from malformed one
+	*/
+	static FrameStatus parse(const char* input, size_t inputSize, FrameInfo* info);
+
+	/*
+	 Decompresses frame to data, capacity is the number of values data can hold. Returns false if
+	 frame is malformed (payload included), holds other type or more values than capacity, or
+	 checksum does not match. Transformed frames are read by the TransformedDecompressFunction
+	 variant only.
+	*/
+	static bool decompress(DecompressFunction decompress,
+	                       const char* input,
+	                       size_t inputSize,
+	                       T* data,
+	                       size_t capacity);
+
+	static bool decompress(TransformedDecompressFunction decompress,
+	                       const char* input,
+	                       size_t inputSize,
+	                       T* data,
+	                       size_t capacity);
+
+	/*
+	 Decompresses values from (inclusive) to to (exclusive) only, starting at the nearest index
+	 checkpoint (or at the reference values of frame without index). Checksum is not verified (it
+	 covers the whole frame), checkpoint offsets and rows decoded are bounds-checked instead, so a
+	 corrupted frame may give wrong values but is never read past. Returns false if frame is
+	 malformed (as far as decoded), holds other type or range is out of bounds.
+	*/
+	static bool decompressRange(const char* input,
+	                            size_t inputSize,
+	                            size_t from,
+	                            size_t to,
+	                            T* data);
+};
+
+}  // end namespace middleout
+
+#endif /* FRAME_H */
@@ -0,0 +1,168 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "../frame.hpp"
+#include "../scalar.hpp"
+#ifdef USE_AVX512
+#include "../avx512.hpp"
+#endif
+
+using namespace middleout;
+
+// rows between checkpoints of fuzzed frames, small to have many of them
+const size_t FUZZ_INDEX_INTERVAL = 3;
+
+/*
+ Frame (arbitrary bytes or a valid one) is parsed, decompressed and read by ranges and single
+ values (as get does). Values of a valid frame are checked, corrupted one must not be read past.
+*/
+static void fuzzFrame(const std::vector<char>& frame,
+                      const std::vector<int64_t>& values,
+                      size_t from,
+                      size_t to) {
+	FrameInfo info;
+	if (Frame<int64_t>::parse(frame.data(), frame.size(), &info) != FRAME_VALID ||
+	    info.type != FRAME_TYPE_INT64) {
+		if (!values.empty()) {
+			__builtin_trap();
+		}
+		return;
+	}
+
+	// parsed frame holds its payload, so itemsCount is bounded by the input size
+	std::vector<int64_t> dataOut(info.itemsCount);
+	bool decompressed =
+	    Frame<int64_t>::decompress(Scalar<int64_t>::decompressSafeTransformed, frame.data(),
+	                               frame.size(), dataOut.data(), dataOut.size());
+	if (!values.empty() && (!decompressed || values != dataOut)) {
+		__builtin_trap();
+	}
+
+	from = std::min<size_t>(from, info.itemsCount);
+	to = std::min<size_t>(std::max(from, to), info.itemsCount);
+	std::vector<int64_t> range(to - from);
+	bool read = Frame<int64_t>::decompressRange(frame.data(), frame.size(), from, to, range.data());
+	if (!values.empty() &&
+	    (!read || !std::equal(range.begin(), range.end(), values.begin() + from))) {
+		__builtin_trap();
+	}
+	for (size_t i = 0; i < info.itemsCount; i += info.itemsCount / 16 + 1) {
+		int64_t value;
+		read = Frame<int64_t>::decompressRange(frame.data(), frame.size(), i, i + 1, &value);
+		if (!values.empty() && (!read || value != values[i])) {
+			__builtin_trap();
+		}
+	}
+}
+
+/*
+ libFuzzer target of the validating decoders (see make fuzz), plain and adaptive rows and frames.
+ The first two bytes of input are itemsCount, the rest is decoded as compressed data (arbitrary
+ bytes) or, if the count is odd, compressed first and decoded back (valid data of any shape). A
+ valid frame is transformed by the rest of the count and corrupted at a byte given by it if the
+ second bit of the count is set.
+*/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* input, size_t size) {
+	if (size < 2) {
+		return 0;
+	}
+	size_t itemsCount = input[0] | input[1] << 8;
+	size_t mode = itemsCount;
+	const char* payload = reinterpret_cast<const char*>(input + 2);
+	size_t payloadSize = size - 2;
+
+	std::vector<char> compressed(payload, payload + payloadSize);
+	std::vector<int64_t> values;
+	if (itemsCount & 1) {
+		// values of the payload, compressed to exactly sized buffer
+		itemsCount = payloadSize / sizeof(int64_t);
+		values.resize(itemsCount);
+		memcpy(values.data(), payload, sizeof(int64_t) * itemsCount);
+		compressed.resize(Scalar<int64_t>::maxCompressedSize(itemsCount));
+		size_t length = Scalar<int64_t>::compress(values.data(), itemsCount, compressed.data(),
+		                                          compressed.size());
+		compressed.resize(length);
+		compressed.shrink_to_fit();
+	}
+
+	std::vector<int64_t> dataOut(itemsCount);
+	DecodeStatus status = Scalar<int64_t>::decompressSafe(compressed.data(), compressed.size(),
+	                                                      itemsCount, dataOut.data());
+	if (!values.empty() && (status != DECODE_OK || values != dataOut)) {
+		__builtin_trap();
+	}
+
+#ifdef USE_AVX512
+	// both kernels accept the same inputs and decode them to the same values
+	std::vector<int64_t> vectorOut(itemsCount);
+	DecodeStatus vectorStatus = Avx52<int64_t>::decompressSafe(
+	    compressed.data(), compressed.size(), itemsCount, vectorOut.data());
+	if (vectorStatus != status || (status == DECODE_OK && vectorOut != dataOut)) {
+		__builtin_trap();
+	}
+#endif
+
+	// adaptive rows, the same way
+	std::vector<char> adaptive(payload, payload + payloadSize);
+	if (!values.empty()) {
+		adaptive.resize(Scalar<int64_t>::maxCompressedSize(itemsCount));
+		size_t length = Scalar<int64_t>::compressAdaptive(values.data(), itemsCount,
+		                                                  adaptive.data(), adaptive.size());
+		adaptive.resize(length);
+		adaptive.shrink_to_fit();
+	}
+	DecodeStatus adaptiveStatus = Scalar<int64_t>::decompressAdaptiveSafe(
+	    adaptive.data(), adaptive.size(), itemsCount, dataOut.data());
+	if (!values.empty() && (adaptiveStatus != DECODE_OK || values != dataOut)) {
+		__builtin_trap();
+	}
+
+	// frames with index, the same way, range is given by the bytes of the count
+	std::vector<char> frame(payload, payload + payloadSize);
+	size_t from = input[0] % (payloadSize + 1);
+	size_t to = from + input[1];
+	if (!values.empty()) {
+		Transform transform = (Transform)((mode >> 2) % 3);
+		frame.resize(
+		    Frame<int64_t>::maxCompressedSize(itemsCount, FUZZ_INDEX_INTERVAL, transform));
+		size_t length = Frame<int64_t>::compress(Scalar<int64_t>::compressTransformed,
+		                                         values.data(), itemsCount, frame.data(),
+		                                         frame.size(), false, FUZZ_INDEX_INTERVAL,
+		                                         transform);
+		frame.resize(length);
+		frame.shrink_to_fit();
+		if (mode & 2) {
+			frame[(mode >> 2) % frame.size()] ^= 0xA5;
+			values.clear();
+		}
+	}
+	fuzzFrame(frame, values, from, to);
+	return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+#include <fstream>
+#include <iterator>
+
+// replays inputs given as arguments, for compilers without libFuzzer
+int main(int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		std::ifstream file(argv[i], std::ios::binary);
+		std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)),
+		                           std::istreambuf_iterator<char>());
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+	}
+	return 0;
+}
+#endif
@@ -11,8 +11,17 @@ See LICENSE.md file
 #include <cstring>
 #include <vector>
 #include "../scalar.hpp"
+#include "../scalar32.hpp"
+#include "../parallel.hpp"
+#include "../batch.hpp"
+#include "../codec.hpp"
+#include "../helpers.hpp"
 #ifdef USE_AVX512
 #include "../avx512.hpp"
+#include "../avx512_32.hpp"
+#endif
+#ifdef USE_AVX2
+#include "../avx2.hpp"
 #endif
 #include <unistd.h>
 
@@ -26,20 +35,43 @@ using namespace middleout;
 
 #ifdef USE_AVX512
 #define ALG_CLASS Avx52
+#elif defined(USE_AVX2)
+#define ALG_CLASS Avx2
 #else
 #define ALG_CLASS Scalar
 #endif
 
+// safe decoding, checksums, aggregation, scans, downsampling, adaptive rows and precision
+// truncation have no AVX2 kernel
+#ifdef USE_AVX512
+#define ADAPTIVE_ALG_CLASS Avx52
+#else
+#define ADAPTIVE_ALG_CLASS Scalar
+#endif
+
+// 32bit values have no AVX2 kernel
+#ifdef USE_AVX512
+#define ALG32_CLASS Avx52x32
+#else
+#define ALG32_CLASS Scalar32
+#endif
+
 #define BENCHMARK_ARGS ->Arg(500000)->Arg(1000000)->Arg(200000000)
+// count, threads
+#define PARALLEL_BENCHMARK_ARGS                                                                \
+	->Args({200000000, 1})->Args({200000000, 2})->Args({200000000, 4})->Args({200000000, 8}) \
+	    ->UseRealTime()
 
 template <typename T>
 auto getCompressor() {
-	return &ALG_CLASS<T>::compress;
+	size_t (*compress)(std::vector<T>&, std::vector<char>&) = &ALG_CLASS<T>::compress;
+	return compress;
 }
 
 template <typename T>
 auto getDecompressor() {
-	return &ALG_CLASS<T>::decompress;
+	void (*decompress)(std::vector<char>&, size_t, std::vector<T>&) = &ALG_CLASS<T>::decompress;
+	return decompress;
 }
 
 template <typename T>
@@ -142,6 +174,33 @@ static void benchmarkDecompress(benchmark::State& state, std::vector<T>& data) {
 	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size() * sizeof(long)));
 }
 
+template <typename T>
+static void benchmarkCompressParallel(benchmark::State& state, std::vector<T>& data) {
+	std::vector<char> compressedData(Parallel<T>::maxCompressedSize(data.size(), 0));
+	size_t (*compress)(const T*, size_t, char*, size_t) = &ALG_CLASS<T>::compress;
+
+	while (state.KeepRunning()) {
+		Parallel<T>::compress(compress, data.data(), data.size(), compressedData.data(),
+		                      compressedData.size(), state.range(1), 0);
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size() * sizeof(long)));
+}
+
+template <typename T>
+static void benchmarkDecompressParallel(benchmark::State& state, std::vector<T>& data) {
+	std::vector<char> compressedData(Parallel<T>::maxCompressedSize(data.size(), 0));
+	Parallel<T>::compress(&Scalar<T>::compress, data.data(), data.size(), compressedData.data(),
+	                      compressedData.size(), 0, 0);
+	std::vector<T> outData(data.size());
+	void (*decompress)(const char*, size_t, T*) = &ALG_CLASS<T>::decompress;
+
+	while (state.KeepRunning()) {
+		Parallel<T>::decompress(decompress, compressedData.data(), data.size(), outData.data(),
+		                        state.range(1));
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size() * sizeof(long)));
+}
+
 static void BM_sequenceCompress(benchmark::State& state) {
 	auto data = generateSequece(0, state.range(0));
 	benchmarkCompress(state, *data);
@@ -170,6 +229,267 @@ static void BM_RandRepeatDecompress(benchmark::State& state) {
 }
 BENCHMARK(BM_RandRepeatDecompress) BENCHMARK_ARGS;
 
+static void BM_RandRepeatCompressParallel(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	benchmarkCompressParallel(state, *data);
+	delete data;
+}
+BENCHMARK(BM_RandRepeatCompressParallel) PARALLEL_BENCHMARK_ARGS;
+
+static void BM_RandRepeatDecompressParallel(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	benchmarkDecompressParallel(state, *data);
+	delete data;
+}
+BENCHMARK(BM_RandRepeatDecompressParallel) PARALLEL_BENCHMARK_ARGS;
+
+// periodic flush of a series: compressSimple allocates on every call, middleout::compressSimple
+// with scratch compresses into a buffer reused across calls
+#define FLUSH_BENCHMARK_ARGS ->Arg(1000)->Arg(100000)
+
+static void BM_flushCompressSimple(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(ALG_CLASS<double>::compressSimple(*data));
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_flushCompressSimple) FLUSH_BENCHMARK_ARGS;
+
+static void BM_flushCompressScratch(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	std::vector<char> scratch(Scalar<double>::maxCompressedSize(data->size()));
+
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(ALG_CLASS<double>::compress(data->data(), data->size(),
+		                                                     scratch.data(), scratch.size()));
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_flushCompressScratch) FLUSH_BENCHMARK_ARGS;
+
+// header-only codec inlined here, compare with BM_RandRepeat* of the scalar build (make bench)
+static void BM_codecCompress(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	std::vector<char> compressedData(Codec<double>::maxCompressedSize(data->size()));
+
+	while (state.KeepRunning()) {
+		Codec<double>::compress(data->data(), data->size(), compressedData.data(),
+		                        compressedData.size());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_codecCompress) BENCHMARK_ARGS;
+
+static void BM_codecDecompress(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	std::vector<char> compressedData(Codec<double>::maxCompressedSize(data->size()));
+	Codec<double>::compress(data->data(), data->size(), compressedData.data(),
+	                        compressedData.size());
+	std::vector<double> outData(data->size());
+
+	while (state.KeepRunning()) {
+		Codec<double>::decompress(compressedData.data(), data->size(), outData.data());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_codecDecompress) BENCHMARK_ARGS;
+
+// output sized by the compressed length, rows close to its end go through a temp buffer
+static void BM_codecCompressBounded(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	std::vector<char> compressedData(Codec<double>::maxCompressedSize(data->size()));
+	size_t capacity = Codec<double>::compress(data->data(), data->size(), compressedData.data(),
+	                                          compressedData.size());
+
+	while (state.KeepRunning()) {
+		Codec<double>::compressBounded(data->data(), data->size(), compressedData.data(), capacity);
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_codecCompressBounded) BENCHMARK_ARGS;
+
+// 8 segments of a large block are 8 far apart streams, run with several PREFETCH_DISTANCE builds
+// (e.g. make bench-avx512 PREFETCH_DISTANCE=0) to see the effect of software prefetching
+static void BM_prefetchCompress(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	benchmarkCompress(state, *data);
+	state.SetLabel("prefetch distance " + std::to_string(PREFETCH_DISTANCE));
+	delete data;
+}
+BENCHMARK(BM_prefetchCompress)->Arg(200000000);
+
+static void BM_prefetchDecompress(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	benchmarkDecompress(state, *data);
+	state.SetLabel("prefetch distance " + std::to_string(PREFETCH_DISTANCE));
+	delete data;
+}
+BENCHMARK(BM_prefetchDecompress)->Arg(200000000);
+
+// compare with BM_RandRepeatDecompress, output is written by non-temporal stores
+static void BM_RandRepeatDecompressNonTemporal(benchmark::State& state) {
+	auto data = generateSequeceRandomRepeat(0, state.range(0));
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	Scalar<double>::compress(*data, compressedData);
+	std::vector<double> outData(data->size());
+
+	while (state.KeepRunning()) {
+		ALG_CLASS<double>::decompressNonTemporal(compressedData.data(), data->size(),
+		                                         outData.data());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_RandRepeatDecompressNonTemporal) BENCHMARK_ARGS;
+
+// sensor like float metric, about half of values repeat the previous one
+static std::vector<float>* generateFloatWalk(size_t count) {
+	auto data = new std::vector<float>(count);
+
+	std::mt19937 mt(0);
+	std::normal_distribution<float> dist(0, 0.25);
+	(*data)[0] = 20.5;
+	for (size_t i = 1; i < count; i++) {
+		(*data)[i] = mt() % 2 ? (*data)[i - 1] : (*data)[i - 1] + dist(mt);
+	}
+
+	return data;
+}
+
+static void BM_float32Compress(benchmark::State& state) {
+	auto data = generateFloatWalk(state.range(0));
+	std::vector<char> compressedData(Scalar32<float>::maxCompressedSize(data->size()));
+	size_t (*compress)(std::vector<float>&, std::vector<char>&) = &ALG32_CLASS<float>::compress;
+
+	while (state.KeepRunning()) {
+		compress(*data, compressedData);
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(float)));
+	delete data;
+}
+BENCHMARK(BM_float32Compress) BENCHMARK_ARGS;
+
+static void BM_float32Decompress(benchmark::State& state) {
+	auto data = generateFloatWalk(state.range(0));
+	std::vector<char> compressedData(Scalar32<float>::maxCompressedSize(data->size()));
+	Scalar32<float>::compress(*data, compressedData);
+	std::vector<float> outData(data->size());
+	void (*decompress)(std::vector<char>&, size_t, std::vector<float>&) =
+	    &ALG32_CLASS<float>::decompress;
+
+	while (state.KeepRunning()) {
+		decompress(compressedData, data->size(), outData);
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(float)));
+	delete data;
+}
+BENCHMARK(BM_float32Decompress) BENCHMARK_ARGS;
+
+// same floats widened to double, bytes processed are of the float input
+static void BM_float32AsDoubleCompress(benchmark::State& state) {
+	auto data = generateFloatWalk(state.range(0));
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	std::vector<double> widened(data->size());
+
+	while (state.KeepRunning()) {
+		std::copy(data->begin(), data->end(), widened.begin());
+		getCompressor<double>()(widened, compressedData);
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(float)));
+	delete data;
+}
+BENCHMARK(BM_float32AsDoubleCompress) BENCHMARK_ARGS;
+
+// number of per minute series of 60 values (seconds)
+#define SHORT_SERIES_BENCHMARK_ARGS ->Arg(10000)->Arg(1000000)
+const size_t SHORT_SERIES_LENGTH = 60;
+
+// one array of all series, series i starts at SHORT_SERIES_LENGTH * i
+static std::vector<double>* generateShortSeries(size_t count) {
+	auto data = new std::vector<double>(count * SHORT_SERIES_LENGTH);
+
+	std::mt19937 mt(0);
+	for (size_t i = 0; i < data->size(); i++) {
+		bool seriesStart = i % SHORT_SERIES_LENGTH == 0;
+		(*data)[i] = seriesStart ? mt() % 1000 : (*data)[i - 1] + (mt() % 2 ? 0 : 0.25);
+	}
+
+	return data;
+}
+
+// every series compressed on its own
+static void BM_shortSeriesCompress(benchmark::State& state) {
+	auto data = generateShortSeries(state.range(0));
+	std::vector<char> compressedData(state.range(0) *
+	                                 Scalar<double>::maxCompressedSize(SHORT_SERIES_LENGTH));
+	size_t (*compress)(const double*, size_t, char*, size_t) = &ALG_CLASS<double>::compress;
+
+	while (state.KeepRunning()) {
+		size_t outputIndex = 0;
+		for (size_t i = 0; i < data->size(); i += SHORT_SERIES_LENGTH) {
+			outputIndex += compress(&(*data)[i], SHORT_SERIES_LENGTH, &compressedData[outputIndex],
+			                        compressedData.size() - outputIndex);
+		}
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_shortSeriesCompress) SHORT_SERIES_BENCHMARK_ARGS;
+
+static void BM_shortSeriesCompressBatch(benchmark::State& state) {
+	auto data = generateShortSeries(state.range(0));
+	std::vector<const double*> series;
+	std::vector<size_t> lengths(state.range(0), SHORT_SERIES_LENGTH);
+	for (size_t i = 0; i < data->size(); i += SHORT_SERIES_LENGTH) {
+		series.push_back(&(*data)[i]);
+	}
+	std::vector<char> compressedData(
+	    Batch<double>::maxCompressedSize(lengths.data(), lengths.size()));
+	std::vector<size_t> offsets(Batch<double>::getGroupsCount(lengths.size()));
+
+	while (state.KeepRunning()) {
+		Batch<double>::compress(&ALG_CLASS<double>::compress, series.data(), lengths.data(),
+		                        lengths.size(), compressedData.data(), compressedData.size(),
+		                        offsets.data());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_shortSeriesCompressBatch) SHORT_SERIES_BENCHMARK_ARGS;
+
+static void BM_shortSeriesDecompressBatch(benchmark::State& state) {
+	auto data = generateShortSeries(state.range(0));
+	std::vector<const double*> series;
+	std::vector<double*> outSeries;
+	std::vector<double> outData(data->size());
+	std::vector<size_t> lengths(state.range(0), SHORT_SERIES_LENGTH);
+	for (size_t i = 0; i < data->size(); i += SHORT_SERIES_LENGTH) {
+		series.push_back(&(*data)[i]);
+		outSeries.push_back(&outData[i]);
+	}
+	std::vector<char> compressedData(
+	    Batch<double>::maxCompressedSize(lengths.data(), lengths.size()));
+	std::vector<size_t> offsets(Batch<double>::getGroupsCount(lengths.size()));
+	Batch<double>::compress(&Scalar<double>::compress, series.data(), lengths.data(),
+	                        lengths.size(), compressedData.data(), compressedData.size(),
+	                        offsets.data());
+
+	while (state.KeepRunning()) {
+		Batch<double>::decompress(&ALG_CLASS<double>::decompress, compressedData.data(),
+		                          offsets.data(), lengths.data(), lengths.size(), outSeries.data());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_shortSeriesDecompressBatch) SHORT_SERIES_BENCHMARK_ARGS;
+
 static void BM_testRandomDistributionCompress(benchmark::State& state) {
 	auto data = generateRandom();
 	benchmarkCompress(state, *data);
@@ -282,4 +602,249 @@ BENCHMARK(BM_fileDataDecompressionC);
 MAKE_DECOMPRESSION_TEST(D, false, "data/redis_memory.data", 0)
 BENCHMARK(BM_fileDataDecompressionD);
 
+// segments of unlike characteristics and small noisy counts
+static const char* ADAPTIVE_FILES[] = {"data/redis_memory.data", "data/writes.data"};
+
+// adaptive inputs are the files above and a sparse counter (below)
+const int ADAPTIVE_SPARSE_COUNTER = 2;
+
+/*
+ Counter incremented in rare bursts, the same rows of all segments change, so the rows between
+ are stored by run-length tokens (no file above has unchanged rows)
+*/
+static std::vector<double>* readAdaptiveData(int input) {
+	if (input != ADAPTIVE_SPARSE_COUNTER) {
+		return readFileData(ADAPTIVE_FILES[input], false, 0);
+	}
+	auto data = new std::vector<double>();
+	long counter = 0;
+	for (long i = 0; i < 1 << 16; i++) {
+		if (i % 512 < 4) {
+			counter += i % 3 + 1;
+		}
+		data->push_back(reinterpret_cast<double&>(counter));
+	}
+	return data;
+}
+
+static std::string getAdaptiveLabel(int input) {
+	return input == ADAPTIVE_SPARSE_COUNTER ? "sparse counter" : ADAPTIVE_FILES[input];
+}
+
+// labelled with ratio of shared and adaptive rows
+static void BM_adaptiveCompress(benchmark::State& state) {
+	auto data = readAdaptiveData(state.range(0));
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	size_t shared = ALG_CLASS<double>::compress(*data, compressedData);
+
+	size_t adaptive = 0;
+	while (state.KeepRunning()) {
+		adaptive = ADAPTIVE_ALG_CLASS<double>::compressAdaptive(
+		    data->data(), data->size(), compressedData.data(), compressedData.size());
+	}
+	double ratio = (double)(data->size() * sizeof(double));
+	state.SetLabel(getAdaptiveLabel(state.range(0)) + " ratio " + std::to_string(ratio / shared) +
+	               " adaptive " + std::to_string(ratio / adaptive));
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_adaptiveCompress)->DenseRange(0, ADAPTIVE_SPARSE_COUNTER);
+
+static void BM_adaptiveDecompress(benchmark::State& state) {
+	auto data = readAdaptiveData(state.range(0));
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	ADAPTIVE_ALG_CLASS<double>::compressAdaptive(data->data(), data->size(), compressedData.data(),
+	                                             compressedData.size());
+	std::vector<double> outData(data->size());
+
+	while (state.KeepRunning()) {
+		ADAPTIVE_ALG_CLASS<double>::decompressAdaptive(compressedData.data(), data->size(),
+		                                               outData.data());
+	}
+	state.SetLabel(getAdaptiveLabel(state.range(0)));
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_adaptiveDecompress)->DenseRange(0, ADAPTIVE_SPARSE_COUNTER);
+
+// fast (0) and validating (1) decompression of the same data
+static void BM_safeDecompress(benchmark::State& state) {
+	auto data = readFileData(ADAPTIVE_FILES[state.range(0)], false, 0);
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	size_t length = Scalar<double>::compress(*data, compressedData);
+	std::vector<double> outData(data->size());
+
+	while (state.KeepRunning()) {
+		if (state.range(1)) {
+			ADAPTIVE_ALG_CLASS<double>::decompressSafe(compressedData.data(), length, data->size(),
+			                                           outData.data());
+		} else {
+			ADAPTIVE_ALG_CLASS<double>::decompress(compressedData.data(), data->size(),
+			                                       outData.data());
+		}
+	}
+	state.SetLabel(ADAPTIVE_FILES[state.range(0)]);
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_safeDecompress)->Ranges({{0, 1}, {0, 1}});
+
+// decompression of checksummed data, plain (0) or verifying the checksum (1)
+static void BM_verifiedDecompress(benchmark::State& state) {
+	auto data = readFileData(ADAPTIVE_FILES[state.range(0)], false, 0);
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	ADAPTIVE_ALG_CLASS<double>::compressChecksummed(data->data(), data->size(),
+	                                                compressedData.data(), compressedData.size());
+	std::vector<double> outData(data->size());
+
+	while (state.KeepRunning()) {
+		if (state.range(1)) {
+			ADAPTIVE_ALG_CLASS<double>::decompressVerified(compressedData.data(), data->size(),
+			                                               outData.data());
+		} else {
+			ADAPTIVE_ALG_CLASS<double>::decompress(compressedData.data(), data->size(),
+			                                       outData.data());
+		}
+	}
+	state.SetLabel(ADAPTIVE_FILES[state.range(0)]);
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_verifiedDecompress)->Ranges({{0, 1}, {0, 1}});
+
+// sum, min and max of decompressed data (0) or computed while decoding (1)
+static void BM_aggregate(benchmark::State& state) {
+	auto data = readFileData(ADAPTIVE_FILES[state.range(0)], false, 0);
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	size_t length = Scalar<double>::compress(*data, compressedData);
+	std::vector<double> outData(data->size());
+
+	Aggregates<double> aggregates;
+	while (state.KeepRunning()) {
+		if (state.range(1)) {
+			ADAPTIVE_ALG_CLASS<double>::decompressAggregates(compressedData.data(), data->size(),
+			                                                 &aggregates);
+		} else {
+			ADAPTIVE_ALG_CLASS<double>::decompress(compressedData.data(), data->size(),
+			                                       outData.data());
+			aggregates = {0, outData[0], outData[0], outData.size()};
+			for (double value : outData) {
+				aggregates.sum += value;
+				aggregates.min = std::min(aggregates.min, value);
+				aggregates.max = std::max(aggregates.max, value);
+			}
+		}
+		benchmark::DoNotOptimize(aggregates);
+	}
+	state.SetLabel(ADAPTIVE_FILES[state.range(0)] + std::string(" compressed ") +
+	               std::to_string(length));
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_aggregate)->Ranges({{0, 1}, {0, 1}});
+
+// values greater than the mean, marked in decompressed data (0) or while decoding (1)
+static void BM_scan(benchmark::State& state) {
+	auto data = readFileData(ADAPTIVE_FILES[state.range(0)], false, 0);
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	Scalar<double>::compress(*data, compressedData);
+	std::vector<double> outData(data->size());
+	std::vector<uint64_t> bitmap(scanBitmapWords(data->size()));
+	Aggregates<double> aggregates;
+	Scalar<double>::decompressAggregates(compressedData.data(), data->size(), &aggregates);
+	double threshold = aggregates.sum / aggregates.count;
+
+	size_t matching = 0;
+	while (state.KeepRunning()) {
+		if (state.range(1)) {
+			matching = ADAPTIVE_ALG_CLASS<double>::scan(compressedData.data(), data->size(),
+			                                            SCAN_GREATER, threshold, bitmap.data());
+		} else {
+			ADAPTIVE_ALG_CLASS<double>::decompress(compressedData.data(), data->size(),
+			                                       outData.data());
+			std::fill(bitmap.begin(), bitmap.end(), 0);
+			matching = 0;
+			for (size_t i = 0; i < outData.size(); i++) {
+				bool match = outData[i] > threshold;
+				bitmap[i / 64] |= (uint64_t)match << (i % 64);
+				matching += match;
+			}
+		}
+		benchmark::DoNotOptimize(matching);
+	}
+	state.SetLabel(ADAPTIVE_FILES[state.range(0)] + std::string(" matching ") +
+	               std::to_string(matching));
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_scan)->Ranges({{0, 1}, {0, 1}});
+
+// buckets of 60 values from decompressed data (0) or computed while decoding (1)
+static void BM_buckets(benchmark::State& state) {
+	auto data = readFileData(ADAPTIVE_FILES[state.range(0)], false, 0);
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	Scalar<double>::compress(*data, compressedData);
+	std::vector<double> outData(data->size());
+	const size_t width = 60;
+	std::vector<Bucket<double>> buckets(getBucketsCount(data->size(), width));
+
+	while (state.KeepRunning()) {
+		if (state.range(1)) {
+			ADAPTIVE_ALG_CLASS<double>::decompressBuckets(compressedData.data(), data->size(),
+			                                              width, buckets.data());
+		} else {
+			ADAPTIVE_ALG_CLASS<double>::decompress(compressedData.data(), data->size(),
+			                                       outData.data());
+			for (size_t i = 0; i < outData.size(); i++) {
+				Bucket<double>& bucket = buckets[i / width];
+				if (i % width == 0) {
+					bucket = {outData[i], outData[i], outData[i], outData[i], 0, 0};
+				}
+				bucket.last = outData[i];
+				bucket.min = std::min(bucket.min, outData[i]);
+				bucket.max = std::max(bucket.max, outData[i]);
+				bucket.sum += outData[i];
+				bucket.count++;
+			}
+		}
+		benchmark::DoNotOptimize(buckets.data());
+	}
+	state.SetLabel(ADAPTIVE_FILES[state.range(0)]);
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_buckets)->Ranges({{0, 1}, {0, 1}});
+
+// relative error bounds of lossy compression
+static const double LOSSY_ERRORS[] = {1e-3, 1e-6, 1e-9};
+static const char* LOSSY_LABELS[] = {"1e-3", "1e-6", "1e-9"};
+
+// truncation pass and compression (0) or truncation within compression (1), labelled with ratio of
+// lossless and lossy compression
+static void BM_lossyCompress(benchmark::State& state) {
+	auto data = readFileData("data/usages.data", true, 0);
+	ErrorBound bound = {ERROR_BOUND_RELATIVE, LOSSY_ERRORS[state.range(0)]};
+	std::vector<char> compressedData(Scalar<double>::maxCompressedSize(data->size()));
+	size_t lossless = ALG_CLASS<double>::compress(*data, compressedData);
+	std::vector<double> truncated(data->size());
+
+	size_t lossy = 0;
+	while (state.KeepRunning()) {
+		if (state.range(1)) {
+			lossy = ADAPTIVE_ALG_CLASS<double>::compressLossy(
+			    data->data(), data->size(), compressedData.data(), compressedData.size(), bound);
+			continue;
+		}
+		ADAPTIVE_ALG_CLASS<double>::truncatePrecision(data->data(), data->size(), truncated.data(),
+		                                              bound);
+		lossy = ADAPTIVE_ALG_CLASS<double>::compress(truncated, compressedData);
+	}
+	double ratio = (double)(data->size() * sizeof(double));
+	state.SetLabel(std::string("relative error ") + LOSSY_LABELS[state.range(0)] + " ratio " +
+	               std::to_string(ratio / lossless) + " lossy " + std::to_string(ratio / lossy));
+	state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data->size() * sizeof(double)));
+	delete data;
+}
+BENCHMARK(BM_lossyCompress)->Ranges({{0, 2}, {0, 1}});
+
 BENCHMARK_MAIN();
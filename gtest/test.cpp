@@ -16,18 +16,39 @@ See LICENSE.md file
 #include <iostream>
 #include <array>
 #include <fstream>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
 
+#include "../middleout.hpp"
 #include "../scalar.hpp"
-#ifdef USE_AVX512
+#include "../helpers.hpp"
+#include "../avx2.hpp"
+#include "../parallel.hpp"
+#include "../batch.hpp"
+#include "../frame.hpp"
+#include "../stream.hpp"
+#include "../codec.hpp"
+#include "../scalar32.hpp"
+#include "../avx512_32.hpp"
 #include "../avx512.hpp"
-#endif
 
 using namespace std;
 
 namespace middleout {
 
-template <typename T, typename U, typename V>
-void checkFunctions(vector<V>& dataIn, T& compress, U& decompress) {
+// Avx52 runs on CPUs with features the dispatcher requires for it, whatever the tests are built for
+static bool supportsAvx52() {
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd") &&
+	       __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") &&
+	       __builtin_cpu_supports("avx512vl");
+}
+
+template <typename V>
+void checkFunctions(vector<V>& dataIn,
+                    size_t (*compress)(vector<V>&, vector<char>&),
+                    void (*decompress)(vector<char>&, size_t, vector<V>&)) {
 	size_t count = dataIn.size();
 
 	vector<char> compressed(Scalar<V>::maxCompressedSize(count));
@@ -55,12 +76,21 @@ template <typename T>
 void compressDecompressCheck(vector<T>& dataIn) {
 	checkFunctions(dataIn, Scalar<T>::compress, Scalar<T>::decompress);
 
-#ifdef USE_AVX512
-	checkFunctions(dataIn, Avx52<T>::compress, Avx52<T>::decompress);
+	if (__builtin_cpu_supports("avx2")) {
+		checkFunctions(dataIn, Avx2<T>::compress, Avx2<T>::decompress);
 
-	// test implementation compatibility
-	checkFunctions(dataIn, Scalar<T>::compress, Avx52<T>::decompress);
-#endif
+		// test implementation compatibility
+		checkFunctions(dataIn, Scalar<T>::compress, Avx2<T>::decompress);
+		checkFunctions(dataIn, Avx2<T>::compress, Scalar<T>::decompress);
+	}
+
+	if (supportsAvx52()) {
+		checkFunctions(dataIn, Avx52<T>::compress, Avx52<T>::decompress);
+
+		// test implementation compatibility
+		checkFunctions(dataIn, Scalar<T>::compress, Avx52<T>::decompress);
+		checkFunctions(dataIn, Avx52<T>::compress, Scalar<T>::decompress);
+	}
 }
 
 vector<long>* generateSequece(long from, long to) {
@@ -384,17 +414,1821 @@ TEST(CompressionTest, testSimpleAPI) {
 		ASSERT_EQ((*dataIn)[i], dataOut[i]) << "data do not match";
 	}
 
-#ifdef USE_AVX512
-	compressed = Avx52<long>::compressSimple(*dataIn);
+	if (__builtin_cpu_supports("avx2")) {
+		compressed = Avx2<long>::compressSimple(*dataIn);
 
-	ASSERT_NE(compressed->size(), 0) << "Not compressed";
+		ASSERT_NE(compressed->size(), 0) << "Not compressed";
+
+		Avx2<long>::decompress(*compressed, count, dataOut);
+		for (size_t i = 0; i < count; i++) {
+			ASSERT_EQ((*dataIn)[i], dataOut[i]) << "data do not match";
+		}
+	}
+
+	if (supportsAvx52()) {
+		compressed = Avx52<long>::compressSimple(*dataIn);
+
+		ASSERT_NE(compressed->size(), 0) << "Not compressed";
+
+		Avx52<long>::decompress(*compressed, count, dataOut);
+		for (size_t i = 0; i < count; i++) {
+			ASSERT_EQ((*dataIn)[i], dataOut[i]) << "data do not match";
+		}
+	}
+	delete dataIn;
+}
+
+TEST(CompressionTest, testScratchCompressSimple) {
+	auto dataIn = generateSequece(0, 10000);
+	auto expected = compressSimple(*dataIn);
+
+	vector<char> scratch;
+	CompressedView compressed = compressSimple(dataIn->data(), dataIn->size(), scratch);
+	ASSERT_EQ(compressed.size, expected->size());
+	ASSERT_EQ(memcmp(compressed.data, expected->data(), compressed.size), 0) << "Output differs";
+
+	// shorter series reuse scratch
+	const char* scratchData = scratch.data();
+	for (size_t count : {1, 1000, 10000}) {
+		compressed = compressSimple(dataIn->data(), count, scratch);
+		ASSERT_EQ(scratch.data(), scratchData) << "Scratch reallocated";
+
+		vector<int64_t> dataOut(count);
+		decompress(compressed.data, count, dataOut.data());
+		ASSERT_TRUE(equal(dataOut.begin(), dataOut.end(), dataIn->begin())) << "data do not match";
+	}
+
+	// exact-size blocks of a fixed arena, null upstream throws if the arena is exceeded
+	vector<double> decimals(dataIn->begin(), dataIn->end());
+	vector<char> arena(10 * compressSimple(decimals)->size());
+	std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size(),
+	                                             std::pmr::null_memory_resource());
+	for (size_t i = 0; i < 10; i++) {
+		compressed = compressSimple(decimals.data(), decimals.size(), scratch, &resource);
+		ASSERT_GE(compressed.data, arena.data());
+		ASSERT_LE(compressed.data + compressed.size, arena.data() + arena.size());
+
+		vector<double> dataOut(decimals.size());
+		decompress(compressed.data, decimals.size(), dataOut.data());
+		ASSERT_TRUE(decimals == dataOut) << "data do not match";
+	}
+	ASSERT_EQ(scratch.data(), scratchData) << "Scratch reallocated";
+	delete dataIn;
+}
+
+TEST(CompressionTest, testDispatchedAPI) {
+	string kernel = kernelName();
+	ASSERT_TRUE(kernel == "scalar" || kernel == "avx2" || kernel == "avx512") << "Unknown kernel "
+	                                                                              << kernel;
+	if (supportsAvx52() && getenv("MIDDLEOUT_KERNEL") == NULL) {
+		ASSERT_EQ(kernel, "avx512") << "Fastest kernel not selected";
+	}
+
+	auto data = generateSequece(0, 10000);
+	size_t (*dispatchedCompress)(vector<int64_t>&, vector<char>&) = compress;
+	void (*dispatchedDecompress)(vector<char>&, size_t, vector<int64_t>&) = decompress;
+	checkFunctions(*data, dispatchedCompress, dispatchedDecompress);
+
+	// kernels share the format
+	checkFunctions(*data, Scalar<int64_t>::compress, dispatchedDecompress);
+	checkFunctions(*data, dispatchedCompress, Scalar<int64_t>::decompress);
+	delete data;
+}
+
+template <typename T>
+void checkRawFunctions(vector<T>& dataIn,
+                       size_t (*compress)(const T*, size_t, char*, size_t),
+                       void (*decompress)(const char*, size_t, T*)) {
+	size_t count = dataIn.size();
+	size_t capacity = Scalar<T>::maxCompressedSize(count);
+
+	// caller owned buffers, intentionally unaligned
+	unique_ptr<char[]> arena(new char[capacity + 1]);
+	char* output = arena.get() + 1;
+
+	ASSERT_EQ(compress(dataIn.data(), count, output, capacity - 1), 0) << "Capacity not checked";
+
+	size_t compressLength = compress(dataIn.data(), count, output, capacity);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	// raw and vector variants share the format
+	vector<char> compressed(Scalar<T>::maxCompressedSize(count));
+	Scalar<T>::compress(dataIn, compressed);
+	for (size_t i = 0; i < compressLength - 6; i++) {
+		ASSERT_EQ(compressed[i], output[i]) << "Output differs at: " << i;
+	}
+
+	unique_ptr<T[]> dataOut(new T[count]);
+	decompress(output, count, dataOut.get());
 
-	Avx52<long>::decompress(*compressed, count, dataOut);
 	for (size_t i = 0; i < count; i++) {
-		ASSERT_EQ((*dataIn)[i], dataOut[i]) << "data do not match";
+		ASSERT_EQ(dataIn[i], dataOut[i]) << "data do not match. Index: " << i;
+	}
+}
+
+TEST(CompressionTest, testRawPointerAPI) {
+	for (size_t count : {1, 16, 17, 1000, 10007}) {
+		auto data = generateSequece(0, count);
+		checkRawFunctions(*data, Scalar<int64_t>::compress, Scalar<int64_t>::decompress);
+
+		if (__builtin_cpu_supports("avx2")) {
+			checkRawFunctions(*data, Avx2<int64_t>::compress, Avx2<int64_t>::decompress);
+		}
+		if (supportsAvx52()) {
+			checkRawFunctions(*data, Avx52<int64_t>::compress, Avx52<int64_t>::decompress);
+		}
+		size_t (*dispatchedCompress)(const int64_t*, size_t, char*, size_t) = compress;
+		void (*dispatchedDecompress)(const char*, size_t, int64_t*) = decompress;
+		checkRawFunctions(*data, dispatchedCompress, dispatchedDecompress);
+		delete data;
+	}
+}
+
+template <typename T>
+void checkParallel(vector<T>& dataIn, size_t threads, size_t chunkSize) {
+	size_t count = dataIn.size();
+	size_t capacity = Parallel<T>::maxCompressedSize(count, chunkSize);
+	vector<char> compressed(capacity);
+
+	ASSERT_EQ(Parallel<T>::compress(Scalar<T>::compress, dataIn.data(), count, compressed.data(),
+	                                capacity - 1, threads, chunkSize),
+	          0)
+	    << "Capacity not checked";
+
+	size_t compressLength = Parallel<T>::compress(Scalar<T>::compress, dataIn.data(), count,
+	                                              compressed.data(), capacity, threads, chunkSize);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	// output does not depend on number of threads
+	vector<char> singleThreaded(capacity);
+	ASSERT_EQ(compressLength, Parallel<T>::compress(Scalar<T>::compress, dataIn.data(), count,
+	                                                singleThreaded.data(), capacity, 1, chunkSize));
+	ASSERT_TRUE(equal(compressed.begin(), compressed.begin() + compressLength,
+	                  singleThreaded.begin()))
+	    << "Output depends on threads count";
+
+	vector<char> compressedExactLength(compressed.begin(), compressed.begin() + compressLength);
+	vector<T> dataOut(count);
+	Parallel<T>::decompress(Scalar<T>::decompress, compressedExactLength.data(), count,
+	                        dataOut.data(), threads);
+
+	for (size_t i = 0; i < count; i++) {
+		ASSERT_EQ(dataIn[i], dataOut[i]) << "data do not match. Index: " << i;
+	}
+}
+
+TEST(CompressionTest, testParallel) {
+	auto data = generateSequece(0, 100000);
+
+	for (size_t threads : {1, 3, 8}) {
+		for (size_t chunkSize : {1, 16, 17, 1000, 99999, 100000, 1000000}) {
+			checkParallel(*data, threads, chunkSize);
+		}
+	}
+	delete data;
+
+	vector<long> empty;
+	checkParallel(empty, 4, 1000);
+
+	auto decimals = generateSequeceDecimal(0, 1000 * 1000, 0.1);
+	checkParallel(*decimals, 4, 4096);
+	delete decimals;
+}
+
+TEST(CompressionTest, testDispatchedParallelAPI) {
+	auto data = generateSequece(0, 3 * 1000 * 1000);
+
+	vector<char> compressed(maxCompressedSizeParallel(data->size()));
+	size_t compressLength = compressParallel(*data, compressed);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	vector<long> dataOut(data->size());
+	decompressParallel(compressed, data->size(), dataOut);
+	ASSERT_TRUE(*data == dataOut) << "data do not match";
+
+	delete data;
+}
+
+template <typename T>
+void checkBatch(vector<vector<T>>& seriesIn) {
+	size_t count = seriesIn.size();
+	vector<const T*> series;
+	vector<size_t> lengths;
+	for (auto& values : seriesIn) {
+		series.push_back(values.data());
+		lengths.push_back(values.size());
+	}
+
+	size_t capacity = Batch<T>::maxCompressedSize(lengths.data(), count);
+	vector<char> compressed(capacity);
+	vector<size_t> offsets(Batch<T>::getGroupsCount(count));
+
+	if (count > 0) {
+		ASSERT_EQ(Batch<T>::compress(Scalar<T>::compress, series.data(), lengths.data(), count,
+		                             compressed.data(), capacity - 1, offsets.data()),
+		          0)
+		    << "Capacity not checked";
+	}
+
+	size_t compressLength =
+	    Batch<T>::compress(Scalar<T>::compress, series.data(), lengths.data(), count,
+	                       compressed.data(), capacity, offsets.data());
+	ASSERT_LE(compressLength, capacity);
+
+	// hard copy, guaranteed vector boundary
+	vector<char> compressedExactLength(compressed.begin(),
+	                                   compressed.begin() + min(compressLength + 1, capacity));
+	vector<vector<T>> seriesOut;
+	vector<T*> outputs;
+	for (size_t i = 0; i < count; i++) {
+		seriesOut.emplace_back(lengths[i]);
+	}
+	for (auto& values : seriesOut) {
+		outputs.push_back(values.data());
+	}
+	Batch<T>::decompress(Scalar<T>::decompress, compressedExactLength.data(), offsets.data(),
+	                     lengths.data(), count, outputs.data());
+	ASSERT_TRUE(seriesIn == seriesOut) << "data do not match";
+}
+
+TEST(CompressionTest, testBatch) {
+	// per minute series of various lengths, incl. empty and shorter than a vector
+	std::mt19937 mt(0);
+	for (size_t count : {0, 1, 7, 8, 9, 100}) {
+		vector<vector<long>> series(count);
+		for (size_t i = 0; i < count; i++) {
+			size_t length = i % 5 == 0 ? i % 3 : 60 + mt() % 10;
+			long value = mt() % 1000;
+			for (size_t j = 0; j < length; j++) {
+				value += mt() % 3;
+				series[i].push_back(value);
+			}
+		}
+		checkBatch(series);
+	}
+
+	vector<vector<double>> decimals;
+	for (size_t i = 0; i < 20; i++) {
+		auto values = generateSequeceDecimal(0, 1 + i * 10, 0.1);
+		decimals.push_back(*values);
+		delete values;
+	}
+	checkBatch(decimals);
+}
+
+TEST(CompressionTest, testDispatchedBatchAPI) {
+	size_t count = 1000;
+	vector<vector<long>> series(count);
+	vector<const int64_t*> inputs;
+	vector<size_t> lengths;
+	for (size_t i = 0; i < count; i++) {
+		for (long j = 0; j < 60; j++) {
+			series[i].push_back(i + j / 4);
+		}
+		inputs.push_back(series[i].data());
+		lengths.push_back(series[i].size());
+	}
+
+	vector<char> compressed(maxCompressedSizeBatch(lengths.data(), count));
+	vector<size_t> offsets(batchGroupsCount(count));
+	size_t compressLength = compressBatch(inputs.data(), lengths.data(), count, compressed.data(),
+	                                      compressed.size(), offsets.data());
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	// header and trailer are shared by 8 series, far less than one per series
+	size_t separateLength = 0;
+	for (auto& values : series) {
+		vector<char> separate(maxCompressedSize(values.size()));
+		separateLength += compress(values, separate);
+	}
+	ASSERT_LT(compressLength, separateLength / 2);
+
+	vector<vector<long>> seriesOut(count, vector<long>(60));
+	vector<int64_t*> outputs;
+	for (auto& values : seriesOut) {
+		outputs.push_back(values.data());
+	}
+	decompressBatch(compressed.data(), offsets.data(), lengths.data(), count, outputs.data());
+	ASSERT_TRUE(series == seriesOut) << "data do not match";
+}
+
+// frame by the plain or the transformed compress of Scalar
+template <typename T>
+size_t compressFrame(vector<T>& data,
+                     char* output,
+                     size_t capacity,
+                     bool checksum,
+                     size_t indexInterval,
+                     Transform transform) {
+	if (transform == TRANSFORM_NONE) {
+		return Frame<T>::compress(Scalar<T>::compress, data.data(), data.size(), output, capacity,
+		                          checksum, indexInterval);
+	}
+	return Frame<T>::compress(Scalar<T>::compressTransformed, data.data(), data.size(), output,
+	                          capacity, checksum, indexInterval, transform);
+}
+
+template <typename T>
+bool decompressFrame(const char* input, size_t inputSize, T* data, size_t capacity) {
+	return Frame<T>::decompress(Scalar<T>::decompressSafeTransformed, input, inputSize, data,
+	                            capacity);
+}
+
+template <typename T>
+void checkFrame(vector<T>& dataIn,
+                bool checksum,
+                size_t indexInterval = 0,
+                Transform transform = TRANSFORM_NONE) {
+	size_t count = dataIn.size();
+	size_t capacity = Frame<T>::maxCompressedSize(count, indexInterval, transform);
+	vector<char> compressed(capacity);
+
+	ASSERT_EQ(compressFrame(dataIn, compressed.data(), capacity - 1, checksum, indexInterval,
+	                        transform),
+	          0)
+	    << "Capacity not checked";
+
+	size_t compressLength = compressFrame(dataIn, compressed.data(), capacity, checksum,
+	                                      indexInterval, transform);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	FrameInfo info;
+	ASSERT_TRUE(Frame<T>::readInfo(compressed.data(), compressLength, &info)) << "Invalid header";
+	ASSERT_EQ(info.itemsCount, count);
+	ASSERT_EQ(info.headerSize + info.indexSize + info.payloadSize, compressLength);
+	ASSERT_EQ((info.flags & FRAME_CHECKSUM) != 0, checksum);
+	ASSERT_EQ(info.transform, transform);
+	ASSERT_FALSE(Frame<T>::readInfo(compressed.data(), compressLength - 1, &info))
+	    << "Truncated frame accepted";
+
+	vector<T> dataOut(count);
+	if (count > 0) {
+		ASSERT_FALSE(decompressFrame(compressed.data(), compressLength, dataOut.data(), count - 1))
+		    << "Capacity not checked";
+	}
+	ASSERT_TRUE(decompressFrame(compressed.data(), compressLength, dataOut.data(), count));
+	for (size_t i = 0; i < count; i++) {
+		ASSERT_EQ(dataIn[i], dataOut[i]) << "data do not match. Index: " << i;
+	}
+	// transform would not be reverted
+	ASSERT_EQ(Frame<T>::decompress(Scalar<T>::decompressSafe, compressed.data(), compressLength,
+	                               dataOut.data(), count),
+	          transform == TRANSFORM_NONE);
+
+	if (checksum && count > 0) {
+		// flip a bit of the first payload byte
+		compressed[info.headerSize + info.indexSize] ^= 1;
+		ASSERT_FALSE(decompressFrame(compressed.data(), compressLength, dataOut.data(), count))
+		    << "Corrupted payload accepted";
+	}
+}
+
+TEST(CompressionTest, testFrame) {
+	for (size_t count : {0, 1, 16, 17, 1000, 10007}) {
+		auto data = generateSequece(0, count);
+		checkFrame(*data, false);
+		checkFrame(*data, true);
+		delete data;
+	}
+
+	auto decimals = generateSequeceDecimal(0, 1000, 0.1);
+	checkFrame(*decimals, true);
+	delete decimals;
+
+	// rows of corrupted payload (no checksum) do not fit it, nothing is read behind the frame
+	auto sequence = generateSequece(0, 1000);
+	vector<char> buffer(Frame<int64_t>::maxCompressedSize(sequence->size(), 0, TRANSFORM_NONE));
+	size_t length = Frame<int64_t>::compress(Scalar<int64_t>::compress, sequence->data(),
+	                                         sequence->size(), buffer.data(), buffer.size(), false,
+	                                         0);
+	vector<char> corrupted(buffer.begin(), buffer.begin() + length);
+	FrameInfo frameInfo;
+	ASSERT_TRUE(Frame<int64_t>::readInfo(corrupted.data(), length, &frameInfo));
+	size_t rowsStart = frameInfo.headerSize + 8 * sizeof(int64_t);
+	std::fill(corrupted.begin() + rowsStart, corrupted.end() - 7, 0);
+	vector<int64_t> dataOut(sequence->size());
+	ASSERT_FALSE(Frame<int64_t>::decompress(Scalar<int64_t>::decompressSafe, corrupted.data(),
+	                                        length, dataOut.data(), dataOut.size()));
+	DecodeStatus (*dispatched)(const char*, size_t, size_t, int64_t*) = decompressSafe;
+	StreamDecoder<int64_t> decoder(dispatched);
+	decoder.feed(corrupted.data(), corrupted.size());
+	ASSERT_FALSE(decoder.next(dataOut));
+	ASSERT_TRUE(decoder.failed());
+	delete sequence;
+
+	vector<char> garbage(100, 'M');
+	FrameInfo info;
+	ASSERT_FALSE(Frame<double>::readInfo(garbage.data(), garbage.size(), &info));
+}
+
+template <typename T>
+void checkRandomAccess(vector<T>& dataIn,
+                       size_t indexInterval,
+                       Transform transform = TRANSFORM_NONE) {
+	size_t count = dataIn.size();
+	vector<char> compressed(Frame<T>::maxCompressedSize(count, indexInterval, transform));
+	size_t compressLength = compressFrame(dataIn, compressed.data(), compressed.size(), false,
+	                                      indexInterval, transform);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	vector<size_t> bounds = {0, 1, count / 3, count / 2, count - count / 8, count - 1, count};
+	for (size_t blockStart = 0; blockStart <= count; blockStart += max<size_t>(1, count / 8)) {
+		// segment boundaries
+		bounds.push_back(blockStart);
+		bounds.push_back(blockStart + 1);
+	}
+
+	for (size_t from : bounds) {
+		for (size_t to : bounds) {
+			if (from > to || to > count) {
+				continue;
+			}
+			vector<T> dataOut(to - from);
+			ASSERT_TRUE(Frame<T>::decompressRange(compressed.data(), compressLength, from, to,
+			                                      dataOut.data()));
+			for (size_t i = from; i < to; i++) {
+				ASSERT_EQ(dataIn[i], dataOut[i - from]) << "data do not match. Index: " << i
+				                                        << " range: " << from << " - " << to;
+			}
+		}
+	}
+
+	T value;
+	ASSERT_FALSE(Frame<T>::decompressRange(compressed.data(), compressLength, count, count + 1,
+	                                       &value))
+	    << "Range not checked";
+}
+
+TEST(CompressionTest, testRandomAccess) {
+	for (size_t count : {1, 16, 17, 1000, 10007, 100003}) {
+		auto data = generateSequece(0, count);
+		for (size_t indexInterval : {0, 1, 7, 1024}) {
+			checkRandomAccess(*data, indexInterval);
+		}
+		checkFrame(*data, true, 7);
+		delete data;
+	}
+
+	auto decimals = generateSequeceDecimal(0, 1000, 0.1);
+	checkRandomAccess(*decimals, 16);
+	delete decimals;
+
+	// corrupted index (no checksum) is rejected, nothing is read behind the frame
+	auto sequence = generateSequece(0, 100000);
+	vector<char> compressed(
+	    Frame<int64_t>::maxCompressedSize(sequence->size(), FRAME_INDEX_INTERVAL, TRANSFORM_NONE));
+	size_t length = Frame<int64_t>::compress(Scalar<int64_t>::compress, sequence->data(),
+	                                         sequence->size(), compressed.data(), compressed.size(),
+	                                         false, FRAME_INDEX_INTERVAL);
+	compressed.resize(length);
+	FrameInfo info;
+	ASSERT_TRUE(Frame<int64_t>::readInfo(compressed.data(), length, &info));
+	int64_t value;
+	for (uint64_t offset : {(uint64_t)1 << 40, (uint64_t)0, (uint64_t)info.payloadSize}) {
+		vector<char> corrupted(compressed);
+		memcpy(&corrupted[info.headerSize], &offset, sizeof(offset));
+		ASSERT_FALSE(get(corrupted.data(), length, 1500, &value)) << "Offset " << offset;
+		// rows in front of the first checkpoint are still decoded
+		ASSERT_TRUE(get(corrupted.data(), length, 1000, &value));
+		ASSERT_EQ(value, (*sequence)[1000]);
+	}
+
+	// rows of corrupted payload do not fit it
+	size_t payloadStart = info.headerSize + info.indexSize;
+	vector<char> corrupted(compressed);
+	std::fill(corrupted.begin() + payloadStart + 8 * sizeof(int64_t), corrupted.end() - 7, 0x07);
+	size_t failed = 0;
+	for (size_t index = 0; index < sequence->size(); index += 997) {
+		failed += !get(corrupted.data(), length, index, &value);
+	}
+	ASSERT_GT(failed, 0);
+	delete sequence;
+}
+
+TEST(CompressionTest, testDispatchedFrameAPI) {
+	auto data = generateSequece(0, 100000);
+
+	vector<char> compressed(maxFramedSize(data->size(), FRAME_INDEX_INTERVAL));
+	size_t compressLength = compressFramed(*data, compressed, true, FRAME_INDEX_INTERVAL);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+	compressed.resize(compressLength);
+
+	// output is sized by the header
+	vector<long> dataOut;
+	ASSERT_TRUE(decompress(compressed, dataOut));
+	ASSERT_TRUE(*data == dataOut) << "data do not match";
+
+	// element type is checked
+	vector<double> otherType;
+	ASSERT_FALSE(decompress(compressed, otherType));
+	ASSERT_TRUE(otherType.empty());
+
+	FrameInfo info;
+	ASSERT_TRUE(readFrameInfo(compressed.data(), compressed.size(), &info));
+	ASSERT_EQ(info.type, FRAME_TYPE_INT64);
+	ASSERT_EQ(info.itemsCount, data->size());
+
+	// last values of a series
+	vector<long> tail;
+	ASSERT_TRUE(decompressRange(compressed, data->size() - 100, data->size(), tail));
+	ASSERT_TRUE(equal(tail.begin(), tail.end(), data->end() - 100)) << "data do not match";
+
+	long value;
+	ASSERT_TRUE(get(compressed.data(), compressed.size(), 12345, &value));
+	ASSERT_EQ(value, (*data)[12345]);
+
+	// frame of a kernel decompresses with any other kernel
+	vector<long> rawOut(data->size());
+	ASSERT_TRUE(Frame<int64_t>::decompress(Scalar<int64_t>::decompressSafe, compressed.data(),
+	                                       compressed.size(), rawOut.data(), rawOut.size()));
+	ASSERT_TRUE(*data == rawOut) << "data do not match";
+
+	delete data;
+}
+
+template <typename T>
+void checkStream(vector<T>& dataIn, size_t frameSize, size_t feedSize) {
+	vector<char> stream;
+	size_t framesCount = 0;
+	{
+		StreamEncoder<T> encoder(Scalar<T>::compress,
+		                         [&](const char* frame, size_t length) {
+			                         stream.insert(stream.end(), frame, frame + length);
+			                         framesCount++;
+		                         },
+		                         frameSize, true);
+		for (size_t i = 0; i < dataIn.size(); i++) {
+			encoder.append(dataIn[i]);
+			ASSERT_LT(encoder.pending(), frameSize) << "Frame not flushed";
+		}
+		// rest is flushed by destructor
+	}
+	ASSERT_EQ(framesCount, (dataIn.size() + frameSize - 1) / frameSize);
+
+	StreamDecoder<T> decoder(Scalar<T>::decompressSafe);
+	vector<T> dataOut;
+	vector<T> values;
+	for (size_t fed = 0; fed < stream.size(); fed += feedSize) {
+		decoder.feed(&stream[fed], min(feedSize, stream.size() - fed));
+		while (decoder.next(values)) {
+			ASSERT_LE(values.size(), frameSize);
+			dataOut.insert(dataOut.end(), values.begin(), values.end());
+		}
+		ASSERT_FALSE(decoder.failed()) << "Stream corrupted";
+	}
+	ASSERT_EQ(decoder.buffered(), 0);
+	ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+}
+
+TEST(CompressionTest, testStream) {
+	auto data = generateSequece(0, 10007);
+	for (size_t frameSize : {(size_t)1, (size_t)17, (size_t)1000, STREAM_FRAME_SIZE}) {
+		for (size_t feedSize : {1, 7, 4096, 1000000}) {
+			checkStream(*data, frameSize, feedSize);
+		}
+	}
+
+	// bulk append equals appends of single values
+	vector<char> bulk;
+	{
+		auto sink = [&](const char* frame, size_t length) {
+			bulk.insert(bulk.end(), frame, frame + length);
+		};
+		StreamEncoder<int64_t> encoder(Scalar<int64_t>::compress, sink, 1000);
+		encoder.append(data->data(), 2500);
+		encoder.append(data->data() + 2500, data->size() - 2500);
+		ASSERT_EQ(encoder.pending(), data->size() % 1000);
+		encoder.flush();
+		ASSERT_EQ(encoder.pending(), 0);
+	}
+
+	StreamDecoder<int64_t> decoder(Scalar<int64_t>::decompressSafe);
+	decoder.feed(bulk.data(), bulk.size());
+	vector<int64_t> values;
+	size_t decompressed = 0;
+	while (decoder.next(values)) {
+		ASSERT_TRUE(equal(values.begin(), values.end(), data->begin() + decompressed));
+		decompressed += values.size();
+	}
+	ASSERT_EQ(decompressed, data->size());
+
+	// garbage behind frames
+	decoder.feed("garbage", 7);
+	ASSERT_FALSE(decoder.next(values));
+	ASSERT_TRUE(decoder.failed());
+
+	delete data;
+
+	auto decimals = generateSequeceDecimal(0, 1000, 0.1);
+	checkStream(*decimals, 333, 100);
+	delete decimals;
+}
+
+template <typename V>
+void checkFunctions32(vector<V>& dataIn,
+                      size_t (*compress)(vector<V>&, vector<char>&),
+                      void (*decompress)(vector<char>&, size_t, vector<V>&)) {
+	size_t count = dataIn.size();
+
+	vector<char> compressed(Scalar32<V>::maxCompressedSize(count));
+	size_t compressLength = compress(dataIn, compressed);
+
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	// hard copy, guaranteed vector boundary
+	vector<char> compressedExactLength(compressed.begin(), compressed.begin() + compressLength);
+
+	vector<V> dataOut(count);
+	decompress(compressedExactLength, count, dataOut);
+
+	for (size_t i = 0; i < count; i++) {
+		// bitwise, NaNs must be preserved too
+		ASSERT_EQ(memcmp(&dataIn[i], &dataOut[i], sizeof(V)), 0) << "data do not match. Index: "
+		                                                          << i;
+	}
+}
+
+template <typename T>
+void compressDecompressCheck32(vector<T>& dataIn) {
+	checkFunctions32(dataIn, Scalar32<T>::compress, Scalar32<T>::decompress);
+
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd")) {
+		checkFunctions32(dataIn, Avx52x32<T>::compress, Avx52x32<T>::decompress);
+
+		// test implementation compatibility
+		checkFunctions32(dataIn, Scalar32<T>::compress, Avx52x32<T>::decompress);
+		checkFunctions32(dataIn, Avx52x32<T>::compress, Scalar32<T>::decompress);
+
+		vector<char> scalarOutput(Scalar32<T>::maxCompressedSize(dataIn.size()));
+		vector<char> avx512Output(scalarOutput.size());
+		size_t length = Scalar32<T>::compress(dataIn, scalarOutput);
+		ASSERT_EQ(length, Avx52x32<T>::compress(dataIn, avx512Output));
+		ASSERT_TRUE(
+		    equal(scalarOutput.begin(), scalarOutput.begin() + length, avx512Output.begin()))
+		    << "Implementations differ";
+	}
+}
+
+TEST(CompressionTest, test32Bit) {
+	std::mt19937 mt(32);
+
+	for (size_t count : {1, 31, 32, 33, 47, 48, 1000, 10007, 100000}) {
+		vector<int32_t> sequence(count);
+		vector<uint32_t> steps(count);
+		vector<float> walk(count);
+		vector<float> noise(count);
+
+		std::normal_distribution<float> normal(0, 1);
+		for (size_t i = 0; i < count; i++) {
+			sequence[i] = -1000 + (int32_t)i;
+			// changes of all byte lengths and offsets
+			steps[i] = (uint32_t)(i / 7) << (8 * (i % 4));
+			// sensor like metric with repeated values
+			walk[i] = i == 0 ? 20.5f : (i % 3 ? walk[i - 1] : walk[i - 1] + 0.25f * normal(mt));
+			noise[i] = normal(mt);
+		}
+
+		compressDecompressCheck32(sequence);
+		compressDecompressCheck32(steps);
+		compressDecompressCheck32(walk);
+		compressDecompressCheck32(noise);
+	}
+
+	vector<float> special = {0.0f, -0.0f, numeric_limits<float>::infinity(),
+	                         -numeric_limits<float>::infinity(), numeric_limits<float>::quiet_NaN(),
+	                         numeric_limits<float>::denorm_min(), numeric_limits<float>::max()};
+	vector<float> specials(1000);
+	for (size_t i = 0; i < specials.size(); i++) {
+		specials[i] = special[(i * i) % special.size()];
+	}
+	compressDecompressCheck32(specials);
+
+	vector<float> constant(10000, 1.5f);
+	compressDecompressCheck32(constant);
+
+	// 16 segments compress as well as 8 segments of the same values in double
+	vector<char> compressed(Scalar32<float>::maxCompressedSize(constant.size()));
+	ASSERT_LT(Scalar32<float>::compress(constant, compressed), constant.size() / 4);
+}
+
+TEST(CompressionTest, testDispatched32BitAPI) {
+	vector<float> data(10000);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = 0.5f * (i / 4);
+	}
+
+	vector<char> compressed(maxCompressedSize32(data.size()));
+	size_t compressLength = compress(data, compressed);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	vector<float> dataOut(data.size());
+	decompress(compressed, data.size(), dataOut);
+	ASSERT_TRUE(data == dataOut) << "data do not match";
+
+	// kernels share the format
+	vector<float> scalarOut(data.size());
+	Scalar32<float>::decompress(compressed, data.size(), scalarOut);
+	ASSERT_TRUE(data == scalarOut) << "data do not match";
+
+	vector<int32_t> ints(1000, 7);
+	auto compressedInts = compressSimple(ints);
+	vector<int32_t> intsOut(ints.size());
+	decompress(compressedInts->data(), ints.size(), intsOut.data());
+	ASSERT_TRUE(ints == intsOut) << "data do not match";
+}
+
+// timestamps of a regular interval with jitter and rare gaps
+vector<int64_t>* generateTimestamps(size_t count) {
+	auto data = new vector<int64_t>(count);
+
+	std::mt19937 mt(0);
+	int64_t timestamp = 1500000000000;
+	for (size_t i = 0; i < count; i++) {
+		timestamp += 1000;
+		if (mt() % 8 == 0) {
+			timestamp += (int64_t)(mt() % 21) - 10;
+		}
+		if (mt() % 1000 == 0) {
+			timestamp += 60000;
+		}
+		(*data)[i] = timestamp;
+	}
+
+	return data;
+}
+
+/*
+ Transformed rows of every kernel are reverted by the decoders of all of them
+*/
+template <typename T>
+void checkTransformed(vector<T>& dataIn, Transform transform) {
+	size_t count = dataIn.size();
+	vector<char> compressed(maxCompressedSize(count));
+	size_t compressLength =
+	    compress(dataIn.data(), count, compressed.data(), compressed.size(), transform);
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+	ASSERT_EQ(compress(dataIn.data(), count, compressed.data(), compressed.size() - 1, transform),
+	          0)
+	    << "Capacity not checked";
+
+	vector<T> dataOut(count);
+	vector<char> kernelOutput(compressed.size());
+	size_t kernelLength = Scalar<T>::compressTransformed(dataIn.data(), count, kernelOutput.data(),
+	                                                     kernelOutput.size(), transform);
+	ASSERT_EQ(decompressSafe(kernelOutput.data(), kernelLength, count, dataOut.data(), transform),
+	          DECODE_OK);
+	ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+	if (supportsAvx52()) {
+		kernelLength = Avx52<T>::compressTransformed(dataIn.data(), count, kernelOutput.data(),
+		                                             kernelOutput.size(), transform);
+		ASSERT_EQ(Scalar<T>::decompressSafeTransformed(kernelOutput.data(), kernelLength, count,
+		                                               dataOut.data(), transform),
+		          DECODE_OK);
+		ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+	}
+
+	decompress(compressed.data(), count, dataOut.data(), transform);
+	ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+	std::fill(dataOut.begin(), dataOut.end(), 0);
+	ASSERT_EQ(decompressSafe(compressed.data(), compressLength, count, dataOut.data(), transform),
+	          DECODE_OK);
+	ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+	std::fill(dataOut.begin(), dataOut.end(), 0);
+	Scalar<T>::decompressTransformed(compressed.data(), count, dataOut.data(), transform);
+	ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+	if (supportsAvx52()) {
+		std::fill(dataOut.begin(), dataOut.end(), 0);
+		Avx52<T>::decompressTransformed(compressed.data(), count, dataOut.data(), transform);
+		ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+		std::fill(dataOut.begin(), dataOut.end(), 0);
+		ASSERT_EQ(Avx52<T>::decompressSafeTransformed(compressed.data(), compressLength, count,
+		                                              dataOut.data(), transform),
+		          DECODE_OK);
+		ASSERT_TRUE(dataIn == dataOut) << "data do not match";
+	}
+
+	if (count > 16) {
+		ASSERT_NE(decompressSafe(compressed.data(), compressLength - 1, count, dataOut.data(),
+		                         transform),
+		          DECODE_OK);
+		// transformed values are not checksummed
+		size_t checksummedLength = Scalar<T>::compressChecksummed(
+		    dataIn.data(), count, kernelOutput.data(), kernelOutput.size());
+		ASSERT_EQ(Scalar<T>::decompressSafeTransformed(kernelOutput.data(), checksummedLength,
+		                                               count, dataOut.data(), transform),
+		          DECODE_MALFORMED);
 	}
+}
+
+TEST(CompressionTest, testDeltaTransform) {
+	auto extremes = new vector<int64_t>(1000);
+	std::mt19937_64 mt(0);
+	for (size_t i = 0; i < extremes->size(); i++) {
+		// differences overflow
+		(*extremes)[i] = i % 3 == 0 ? numeric_limits<int64_t>::min()
+		                            : i % 3 == 1 ? numeric_limits<int64_t>::max() : (int64_t)mt();
+	}
+
+	for (auto data : {generateTimestamps(1), generateTimestamps(17), generateTimestamps(18),
+	                  generateTimestamps(1000), generateTimestamps(10007), extremes}) {
+		vector<uint64_t> unsignedData(data->begin(), data->end());
+		for (Transform transform : {TRANSFORM_DELTA, TRANSFORM_DELTA_OF_DELTA}) {
+			checkTransformed(*data, transform);
+			checkTransformed(unsignedData, transform);
+
+			checkFrame(*data, true, 0, transform);
+			checkFrame(*data, true, 7, transform);
+			checkFrame(unsignedData, false, 7, transform);
+			checkRandomAccess(*data, 7, transform);
+			checkRandomAccess(unsignedData, 1, transform);
+		}
+		delete data;
+	}
+
+	// timestamps compress far better transformed
+	auto timestamps = generateTimestamps(100000);
+	size_t sizes[3];
+	for (Transform transform : {TRANSFORM_NONE, TRANSFORM_DELTA, TRANSFORM_DELTA_OF_DELTA}) {
+		vector<char> compressed(maxFramedSize(timestamps->size(), 0, transform));
+		sizes[transform] = compressFramed(*timestamps, compressed, false, 0, transform);
+		compressed.resize(sizes[transform]);
+
+		vector<int64_t> dataOut;
+		ASSERT_TRUE(decompress(compressed, dataOut));
+		ASSERT_TRUE(*timestamps == dataOut) << "data do not match";
+	}
+	ASSERT_LT(sizes[TRANSFORM_DELTA], sizes[TRANSFORM_NONE] / 2);
+	ASSERT_LT(sizes[TRANSFORM_DELTA_OF_DELTA], sizes[TRANSFORM_NONE] / 2);
+
+	// unsigned framed API
+	vector<uint64_t> unsignedTimestamps(timestamps->begin(), timestamps->end());
+	vector<char> framed(maxFramedSize(unsignedTimestamps.size(), FRAME_INDEX_INTERVAL,
+	                                  TRANSFORM_DELTA_OF_DELTA));
+	framed.resize(compressFramed(unsignedTimestamps, framed, true, FRAME_INDEX_INTERVAL,
+	                             TRANSFORM_DELTA_OF_DELTA));
+	vector<uint64_t> unsignedOut;
+	ASSERT_TRUE(decompress(framed, unsignedOut));
+	ASSERT_TRUE(unsignedTimestamps == unsignedOut) << "data do not match";
+	vector<int64_t> otherType;
+	ASSERT_FALSE(decompress(framed, otherType));
+	ASSERT_TRUE(decompressFramed(framed.data(), framed.size(), unsignedOut.data(),
+	                             unsignedOut.size()));
+	ASSERT_TRUE(decompressRange(framed, 50000, 50100, unsignedOut));
+	ASSERT_TRUE(equal(unsignedOut.begin(), unsignedOut.end(), unsignedTimestamps.begin() + 50000));
+	uint64_t unsignedValue;
+	ASSERT_TRUE(get(framed.data(), framed.size(), 77777, &unsignedValue));
+	ASSERT_EQ(unsignedValue, unsignedTimestamps[77777]);
+
+	// transform is recorded in stream frames
+	vector<char> stream;
+	{
+		auto sink = [&](const char* frame, size_t length) {
+			stream.insert(stream.end(), frame, frame + length);
+		};
+		StreamEncoder<int64_t> encoder(compress, sink, 1000, true, TRANSFORM_DELTA_OF_DELTA);
+		encoder.append(timestamps->data(), timestamps->size());
+	}
+	StreamDecoder<int64_t> decoder(decompressSafe, decompressSafe);
+	decoder.feed(stream.data(), stream.size());
+	vector<int64_t> values;
+	vector<int64_t> streamOut;
+	while (decoder.next(values)) {
+		streamOut.insert(streamOut.end(), values.begin(), values.end());
+	}
+	ASSERT_TRUE(*timestamps == streamOut) << "data do not match";
+	delete timestamps;
+
+	// transformed frames need the transformed decompress
+	StreamDecoder<int64_t> plainDecoder(Scalar<int64_t>::decompressSafe);
+	plainDecoder.feed(stream.data(), stream.size());
+	ASSERT_FALSE(plainDecoder.next(values));
+	ASSERT_TRUE(plainDecoder.failed());
+
+	// doubles are not transformed
+	vector<double> decimals(1000, 0.5);
+	vector<char> compressed(Frame<double>::maxCompressedSize(1000, 0, TRANSFORM_DELTA));
+	ASSERT_EQ(Frame<double>::compress(Scalar<double>::compressTransformed, decimals.data(), 1000,
+	                                  compressed.data(), compressed.size(), false, 0,
+	                                  TRANSFORM_DELTA),
+	          0);
+#ifndef NDEBUG
+	auto discard = [](const char*, size_t) {};
+	ASSERT_DEATH(StreamEncoder<double>(Scalar<double>::compressTransformed, discard, 1000, false,
+	                                   TRANSFORM_DELTA),
+	             "");
 #endif
-	delete dataIn;
+}
+
+template <typename C, typename T>
+void checkCodec(vector<T>& dataIn, void (*decompress)(const char*, size_t, T*)) {
+	size_t count = dataIn.size();
+	vector<char> compressed(C::maxCompressedSize(count) + 1);
+
+	ASSERT_EQ(C::compress(dataIn.data(), count, compressed.data(), compressed.size() - 2), 0)
+	    << "Capacity not checked";
+	size_t compressLength = C::compress(dataIn.data(), count, compressed.data(), compressed.size());
+	ASSERT_NE(compressLength, 0) << "Not compressed";
+
+	// hard copy, guaranteed vector boundary
+	vector<char> compressedExactLength(compressed.begin(), compressed.begin() + compressLength + 1);
+
+	vector<T> dataOut(count);
+	decompress(compressedExactLength.data(), count, dataOut.data());
+	// bitwise, NaNs included
+	ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0) << "data do not match";
+}
+
+TEST(CompressionTest, testCodec) {
+	// geometry is known at compile time
+	static_assert(Codec<double>::maxCompressedSize(1000) > 8 * 1000, "Not constexpr");
+
+	std::mt19937 mt(14);
+	std::normal_distribution<double> normal(0, 1);
+
+	for (size_t count : {1, 16, 17, 32, 33, 1000, 10007}) {
+		vector<int64_t> steps(count);
+		vector<double> noise(count);
+		vector<float> noise32(count);
+		for (size_t i = 0; i < count; i++) {
+			// changes of all byte lengths and offsets
+			steps[i] = (int64_t)(i / 7) << (8 * (i % 8));
+			noise[i] = i % 3 || i == 0 ? normal(mt) : noise[i - 1];
+			noise32[i] = (float)noise[i];
+		}
+
+		// format of compiled kernels
+		ASSERT_EQ(Codec<int64_t>::maxCompressedSize(count),
+		          Scalar<int64_t>::maxCompressedSize(count));
+		ASSERT_EQ(Codec<float>::maxCompressedSize(count),
+		          Scalar32<float>::maxCompressedSize(count));
+		auto timestamps = generateTimestamps(count);
+		checkRawFunctions(*timestamps, Codec<int64_t>::compress, Codec<int64_t>::decompress);
+		checkRawFunctions(*timestamps, Codec<int64_t>::compress, Scalar<int64_t>::decompress);
+		checkRawFunctions(*timestamps, Scalar<int64_t>::compress, Codec<int64_t>::decompress);
+		delete timestamps;
+
+		checkCodec<Codec<int64_t>>(steps, Scalar<int64_t>::decompress);
+		checkCodec<Codec<double>>(noise, Scalar<double>::decompress);
+		checkCodec<Codec<float>>(noise32, Scalar32<float>::decompress);
+
+		vector<char> scalarOutput(Scalar32<float>::maxCompressedSize(count));
+		vector<char> codecOutput(Codec<float>::maxCompressedSize(count));
+		size_t length = Scalar32<float>::compress(noise32, scalarOutput);
+		ASSERT_EQ(length, Codec<float>::compress(noise32.data(), count, codecOutput.data(),
+		                                         codecOutput.size()));
+		ASSERT_TRUE(equal(scalarOutput.begin(), scalarOutput.begin() + length, codecOutput.begin()))
+		    << "Implementations differ";
+
+		// geometries of the codec only
+		checkCodec<Codec<int64_t, 16>>(steps, Codec<int64_t, 16>::decompress);
+		checkCodec<Codec<double, 16>>(noise, Codec<double, 16>::decompress);
+		checkCodec<Codec<float, 8>>(noise32, Codec<float, 8>::decompress);
+	}
+}
+
+template <typename T>
+void checkBounded(vector<T>& dataIn, size_t bound) {
+	size_t count = dataIn.size();
+	vector<char> reference(maxCompressedSize(count));
+	size_t length = compress(dataIn.data(), count, reference.data(), reference.size());
+	ASSERT_LE(length, bound) << "Bound exceeded";
+
+	const char canary = 0x55;
+	for (size_t shortage : {0, 1, 7, 8, 9, 70, 71, 200}) {
+		for (size_t capacity : {bound, length - std::min(length, shortage)}) {
+			// everything past capacity must stay intact
+			vector<char> output(capacity + 128, canary);
+			size_t result = compressBounded(dataIn.data(), count, output.data(), capacity);
+			ASSERT_TRUE(all_of(output.begin() + capacity, output.end(),
+			                   [&](char c) { return c == canary; }))
+			    << "Written past capacity " << capacity;
+
+			if (capacity < length) {
+				ASSERT_EQ(result, 0) << "Does not fit to " << capacity;
+				continue;
+			}
+			ASSERT_EQ(result, length);
+			ASSERT_TRUE(equal(reference.begin(), reference.begin() + length, output.begin()))
+			    << "Implementations differ";
+
+			vector<char> compressedExactLength(output.begin(), output.begin() + length + 1);
+			vector<T> dataOut(count);
+			decompress(compressedExactLength.data(), count, dataOut.data());
+			ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0)
+			    << "data do not match";
+		}
+	}
+}
+
+TEST(CompressionTest, testCompressBounded) {
+	std::mt19937 mt(16);
+	std::uniform_int_distribution<int64_t> uniform;
+
+	for (size_t count : {1, 16, 17, 33, 1000, 10007}) {
+		vector<int64_t> worstCase(count);
+		vector<int64_t> random(count);
+		vector<double> decimals(count);
+		vector<float> decimals32(count);
+		for (size_t i = 0; i < count; i++) {
+			// first and last byte change in every value, all rows are stored in full
+			worstCase[i] = i % 2 ? 0x0100000000000001 : 0;
+			random[i] = uniform(mt);
+			decimals[i] = (i % 100) / 10.0;
+			decimals32[i] = (float)decimals[i];
+		}
+
+		ASSERT_EQ(compress(worstCase.data(), count, nullptr, 0), 0);
+		vector<char> compressed(maxCompressedSize(count));
+		ASSERT_EQ(compress(worstCase.data(), count, compressed.data(), compressed.size()),
+		          compressBound(count))
+		    << "Bound is not exact";
+		ASSERT_LE(compressBound(count), maxCompressedSize(count));
+		ASSERT_LE(compressBound32(count), maxCompressedSize32(count));
+
+		auto timestamps = generateTimestamps(count);
+		checkBounded(*timestamps, compressBound(count));
+		delete timestamps;
+		checkBounded(worstCase, compressBound(count));
+		checkBounded(random, compressBound(count));
+		checkBounded(decimals, compressBound(count));
+		checkBounded(decimals32, compressBound32(count));
+	}
+}
+
+template <typename T>
+void checkAdaptive(vector<T>& dataIn,
+                   size_t (*compress)(const T*, size_t, char*, size_t),
+                   void (*decompress)(const char*, size_t, T*)) {
+	size_t count = dataIn.size();
+	vector<char> compressed(Scalar<T>::maxCompressedSize(count));
+	ASSERT_EQ(compress(dataIn.data(), count, compressed.data(), compressed.size() - 1), 0)
+	    << "Capacity not checked";
+	size_t compressLength = compress(dataIn.data(), count, compressed.data(), compressed.size());
+
+	// same output of all kernels
+	vector<char> reference(compressed.size());
+	ASSERT_EQ(compressLength, Scalar<T>::compressAdaptive(dataIn.data(), count, reference.data(),
+	                                                      reference.size()));
+	ASSERT_TRUE(equal(reference.begin(), reference.begin() + compressLength, compressed.begin()))
+	    << "Implementations differ";
+
+	// hard copy, guaranteed vector boundary
+	vector<char> compressedExactLength(compressed.begin(), compressed.begin() + compressLength + 1);
+	vector<T> dataOut(count);
+	decompress(compressedExactLength.data(), count, dataOut.data());
+	for (size_t i = 0; i < count; i++) {
+		ASSERT_EQ(dataIn[i], dataOut[i]) << "data do not match. Index: " << i;
+	}
+
+	// validating decoder, exactly sized copies
+	vector<char> exact(compressed.begin(), compressed.begin() + compressLength);
+	vector<T> safeOut(count);
+	ASSERT_EQ(Scalar<T>::decompressAdaptiveSafe(exact.data(), exact.size(), count, safeOut.data()),
+	          DECODE_OK);
+	ASSERT_EQ(memcmp(dataIn.data(), safeOut.data(), sizeof(T) * count), 0) << "data do not match";
+	for (size_t cut = 1; cut <= std::min(compressLength, (size_t)100); cut++) {
+		vector<char> truncated(exact.begin(), exact.end() - cut);
+		ASSERT_NE(Scalar<T>::decompressAdaptiveSafe(truncated.data(), truncated.size(), count,
+		                                            safeOut.data()),
+		          DECODE_OK)
+		    << "truncated by " << cut;
+	}
+}
+
+TEST(CompressionTest, testAdaptive) {
+	std::mt19937 mt(17);
+	std::uniform_int_distribution<int64_t> uniform;
+	std::normal_distribution<double> normal(0, 0.01);
+
+	for (size_t count : {1, 16, 17, 33, 1000, 10007}) {
+		vector<int64_t> mixed(count);
+		vector<int64_t> random(count);
+		vector<double> decimals(count);
+		vector<double> walk(count);
+		vector<int64_t> constant(count, 42);
+		vector<int64_t> sparse(count);
+		for (size_t i = 0; i < count; i++) {
+			// flat counters in the first segments, noise of all lengths in the others
+			mixed[i] = i < count / 2 ? i / 3 : uniform(mt) >> (8 * (i % 8));
+			random[i] = uniform(mt);
+			decimals[i] = (i % 100) / 10.0;
+			// slowly changing doubles: same leading bytes, noisy low mantissa bytes
+			walk[i] = (i ? walk[i - 1] : 100.0) + normal(mt);
+			// runs of unchanged rows of all lengths
+			sparse[i] = i % 97 == 0 || i % 89 == 0 ? i : 0;
+		}
+		auto timestamps = generateTimestamps(count);
+
+		for (auto data : {&mixed, &random, timestamps, &constant, &sparse}) {
+			checkAdaptive(*data, Scalar<int64_t>::compressAdaptive,
+			              Scalar<int64_t>::decompressAdaptive);
+			if (supportsAvx52()) {
+				checkAdaptive(*data, Avx52<int64_t>::compressAdaptive,
+				              Avx52<int64_t>::decompressAdaptive);
+				checkAdaptive(*data, Scalar<int64_t>::compressAdaptive,
+				              Avx52<int64_t>::decompressAdaptive);
+			}
+			size_t (*compressDispatched)(const int64_t*, size_t, char*, size_t) = compressAdaptive;
+			void (*decompressDispatched)(const char*, size_t, int64_t*) = decompressAdaptive;
+			checkAdaptive(*data, compressDispatched, decompressDispatched);
+		}
+		delete timestamps;
+
+		size_t (*compressDoubles)(const double*, size_t, char*, size_t) = compressAdaptive;
+		void (*decompressDoubles)(const char*, size_t, double*) = decompressAdaptive;
+		for (auto data : {&decimals, &walk}) {
+			checkAdaptive(*data, compressDoubles, decompressDoubles);
+			if (supportsAvx52()) {
+				checkAdaptive(*data, Avx52<double>::compressAdaptive,
+				              Avx52<double>::decompressAdaptive);
+			}
+		}
+
+		if (count > 1000) {
+			// single noisy segments do not inflate the others
+			vector<char> compressed(maxCompressedSize(count));
+			size_t shared = compress(mixed.data(), count, compressed.data(), compressed.size());
+			size_t adaptive =
+			    compressAdaptive(mixed.data(), count, compressed.data(), compressed.size());
+			ASSERT_LT(adaptive, shared * 0.9);
+
+			// no offsets of leading-aligned values
+			shared = compress(walk.data(), count, compressed.data(), compressed.size());
+			adaptive = compressAdaptive(walk.data(), count, compressed.data(), compressed.size());
+			ASSERT_LT(adaptive, shared * 0.97);
+
+			// reference values, run-length token and the trailer
+			adaptive =
+			    compressAdaptive(constant.data(), count, compressed.data(), compressed.size());
+			ASSERT_LE(adaptive, 8 * 8 + 2 + 2 + 8 * (count % 8) + 7);
+
+			// run passing the end of the block (2 bytes varint), varint not terminated
+			vector<char> passing(compressed.begin(), compressed.begin() + adaptive);
+			passing[8 * 8 + 3] = 0x7F;
+			vector<char> unterminated(passing);
+			memset(&unterminated[8 * 8 + 2], 0xFF, 10);
+			vector<int64_t> dataOut(count);
+			DecodeStatus (*dispatched)(const char*, size_t, size_t, int64_t*) =
+			    decompressAdaptiveSafe;
+			for (auto corrupted : {&passing, &unterminated}) {
+				ASSERT_EQ(Scalar<int64_t>::decompressAdaptiveSafe(corrupted->data(), adaptive,
+				                                                  count, dataOut.data()),
+				          DECODE_MALFORMED);
+				ASSERT_EQ(dispatched(corrupted->data(), adaptive, count, dataOut.data()),
+				          DECODE_MALFORMED);
+			}
+		}
+	}
+
+	// single leading-aligned row of 2 bytes values below 6 leading zero bytes
+	vector<int64_t> leading(17, 0x1100);
+	for (size_t j = 0; j < 8; j++) {
+		leading[2 * j + 1] ^= 0x0101 * (j + 1);
+	}
+	vector<char> compressed(Scalar<int64_t>::maxCompressedSize(leading.size()));
+	size_t length = Scalar<int64_t>::compressAdaptive(leading.data(), leading.size(),
+	                                                  compressed.data(), compressed.size());
+	compressed.resize(length);
+	ASSERT_EQ((uint8_t)compressed[8 * 8 + 1], ADAPTIVE_LEADING | 1 << 2 | 6 << 5);
+
+	// 7 leading zero bytes and 2 bytes values, the values are dropped by all decoders
+	compressed[8 * 8 + 1] = (char)(ADAPTIVE_LEADING | 1 << 2 | 7 << 5);
+	vector<int64_t> dataOut(leading.size());
+	ASSERT_EQ(Scalar<int64_t>::decompressAdaptiveSafe(compressed.data(), length, leading.size(),
+	                                                  dataOut.data()),
+	          DECODE_MALFORMED);
+	DecodeStatus (*dispatched)(const char*, size_t, size_t, int64_t*) = decompressAdaptiveSafe;
+	ASSERT_EQ(dispatched(compressed.data(), length, leading.size(), dataOut.data()),
+	          DECODE_MALFORMED);
+	compressed.resize(length + ADAPTIVE_READ_AHEAD);
+	Scalar<int64_t>::decompressAdaptive(compressed.data(), leading.size(), dataOut.data());
+	ASSERT_TRUE(dataOut == vector<int64_t>(leading.size(), 0x1100));
+	if (supportsAvx52()) {
+		Avx52<int64_t>::decompressAdaptive(compressed.data(), leading.size(), dataOut.data());
+		ASSERT_TRUE(dataOut == vector<int64_t>(leading.size(), 0x1100));
+	}
+}
+
+template <typename T>
+void checkSafe(vector<T>& dataIn,
+               DecodeStatus (*decompressSafe)(const char*, size_t, size_t, T*),
+               std::mt19937& mt) {
+	size_t count = dataIn.size();
+	vector<char> buffer(Scalar<T>::maxCompressedSize(count));
+	size_t length = Scalar<T>::compress(dataIn.data(), count, buffer.data(), buffer.size());
+	vector<T> dataOut(count);
+
+	// exactly sized copies, sanitizer catches any read out of them
+	vector<char> compressed(buffer.begin(), buffer.begin() + length);
+	ASSERT_EQ(decompressSafe(compressed.data(), length, count, dataOut.data()), DECODE_OK);
+	ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0) << "data do not match";
+
+	for (size_t cut = 1; cut <= std::min(length, (size_t)200); cut++) {
+		vector<char> truncated(buffer.begin(), buffer.begin() + length - cut);
+		ASSERT_NE(decompressSafe(truncated.data(), truncated.size(), count, dataOut.data()),
+		          DECODE_OK)
+		    << "Cut: " << cut;
+	}
+	vector<char> longer(buffer.begin(), buffer.begin() + length + 1);
+	ASSERT_EQ(decompressSafe(longer.data(), longer.size(), count, dataOut.data()),
+	          DECODE_MALFORMED);
+	// more values than compressed
+	vector<T> moreOut(count + 8);
+	ASSERT_NE(decompressSafe(compressed.data(), length, count + 8, moreOut.data()), DECODE_OK);
+
+	// corrupted bytes may go unnoticed (values are not verified) but are never read out of bounds
+	std::uniform_int_distribution<size_t> position(0, length - 1);
+	for (size_t k = 0; k < 200; k++) {
+		vector<char> corrupted(compressed);
+		for (size_t flips = 0; flips <= k % 4; flips++) {
+			corrupted[position(mt)] ^= 1 << (mt() % 8);
+		}
+		decompressSafe(corrupted.data(), length, count, dataOut.data());
+	}
+}
+
+TEST(CompressionTest, testSafeDecompress) {
+	std::mt19937 mt(21);
+	vector<int64_t> constant(1003, 42);
+	for (auto data : {generateTimestamps(5), generateTimestamps(16), generateTimestamps(17),
+	                  generateTimestamps(100), generateTimestamps(1000), generateTimestamps(10007),
+	                  &constant}) {
+		checkSafe(*data, Scalar<int64_t>::decompressSafe, mt);
+		if (supportsAvx52()) {
+			checkSafe(*data, Avx52<int64_t>::decompressSafe, mt);
+		}
+		DecodeStatus (*dispatched)(const char*, size_t, size_t, int64_t*) = decompressSafe;
+		checkSafe(*data, dispatched, mt);
+
+		if (data != &constant) {
+			delete data;
+		}
+	}
+
+	// full rows of 8 bytes values
+	vector<double> random(1000);
+	std::uniform_real_distribution<double> uniform(-1e9, 1e9);
+	for (auto& value : random) {
+		value = uniform(mt);
+	}
+	checkSafe(random, Scalar<double>::decompressSafe, mt);
+	if (supportsAvx52()) {
+		checkSafe(random, Avx52<double>::decompressSafe, mt);
+	}
+
+	vector<int64_t> dataOut(1000);
+	vector<char> garbage(1000, (char)0x55);
+	ASSERT_EQ(Scalar<int64_t>::decompressSafe(garbage.data(), 10, 1000, dataOut.data()),
+	          DECODE_TRUNCATED);
+	ASSERT_EQ(Scalar<int64_t>::decompressSafe(garbage.data(), garbage.size(), 1000, dataOut.data()),
+	          DECODE_MALFORMED);
+}
+
+template <typename T>
+void checkChecksum(vector<T>& dataIn,
+                   size_t (*compressChecksummed)(const T*, size_t, char*, size_t),
+                   DecodeStatus (*decompressVerified)(const char*, size_t, T*),
+                   std::mt19937& mt) {
+	size_t count = dataIn.size();
+	vector<char> plain(Scalar<T>::maxCompressedSize(count));
+	size_t plainLength = Scalar<T>::compress(dataIn.data(), count, plain.data(), plain.size());
+	vector<char> buffer(Scalar<T>::maxCompressedSize(count));
+	size_t length = compressChecksummed(dataIn.data(), count, buffer.data(), buffer.size());
+	// checksum takes trailer padding
+	ASSERT_EQ(length, plainLength);
+	vector<char> compressed(buffer.begin(), buffer.begin() + length);
+
+	// same checksum by every kernel (rows may differ in unused header bits)
+	vector<char> scalar(Scalar<T>::maxCompressedSize(count));
+	Scalar<T>::compressChecksummed(dataIn.data(), count, scalar.data(), scalar.size());
+	ASSERT_EQ(memcmp(&scalar[length - 7], &compressed[length - 7], 7), 0);
+
+	vector<T> dataOut(count);
+	Scalar<T>::decompress(compressed.data(), count, dataOut.data());
+	ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0) << "data do not match";
+	std::fill(dataOut.begin(), dataOut.end(), 0);
+	ASSERT_EQ(decompressVerified(compressed.data(), count, dataOut.data()), DECODE_OK);
+	ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0) << "data do not match";
+	ASSERT_EQ(Scalar<T>::decompressSafe(compressed.data(), length, count, dataOut.data()),
+	          DECODE_OK);
+	ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0) << "data do not match";
+	if (supportsAvx52()) {
+		ASSERT_EQ(Avx52<T>::decompressSafe(compressed.data(), length, count, dataOut.data()),
+		          DECODE_OK);
+		ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0)
+		    << "data do not match";
+	}
+
+	if (count <= 16) {
+		// stored uncompressed
+		return;
+	}
+	ASSERT_EQ(decompressVerified(plain.data(), count, dataOut.data()), DECODE_MALFORMED);
+
+	// reference values, uncompressed rest and the checksum itself
+	vector<size_t> positions = {0, 63, length - 7 + 1, length - 7 + 4};
+	if (count % 8 != 0) {
+		positions.push_back(length - 7 - sizeof(T) * (count % 8));
+	}
+	for (size_t position : positions) {
+		vector<char> corrupted(compressed);
+		corrupted[position] ^= 1 << (mt() % 8);
+		ASSERT_EQ(decompressVerified(corrupted.data(), count, dataOut.data()),
+		          DECODE_CHECKSUM_MISMATCH)
+		    << "Position: " << position;
+		ASSERT_EQ(Scalar<T>::decompressSafe(corrupted.data(), length, count, dataOut.data()),
+		          DECODE_CHECKSUM_MISMATCH)
+		    << "Position: " << position;
+	}
+
+	// any corruption of rows is either rejected or changes no value
+	std::uniform_int_distribution<size_t> position(0, length - 1);
+	for (size_t k = 0; k < 100; k++) {
+		vector<char> corrupted(compressed);
+		corrupted[position(mt)] ^= 1 << (mt() % 8);
+		if (Scalar<T>::decompressSafe(corrupted.data(), length, count, dataOut.data()) ==
+		    DECODE_OK) {
+			ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0);
+		}
+		if (supportsAvx52()) {
+			if (Avx52<T>::decompressSafe(corrupted.data(), length, count, dataOut.data()) ==
+			    DECODE_OK) {
+				ASSERT_EQ(memcmp(dataIn.data(), dataOut.data(), sizeof(T) * count), 0);
+			}
+		}
+	}
+}
+
+TEST(CompressionTest, testChecksum) {
+	std::mt19937 mt(34);
+	vector<int64_t> constant(1003, 42);
+	for (auto data : {generateTimestamps(16), generateTimestamps(17), generateTimestamps(100),
+	                  generateTimestamps(1000), generateTimestamps(10007), &constant}) {
+		checkChecksum(*data, Scalar<int64_t>::compressChecksummed,
+		              Scalar<int64_t>::decompressVerified, mt);
+		if (supportsAvx52()) {
+			checkChecksum(*data, Avx52<int64_t>::compressChecksummed,
+			              Avx52<int64_t>::decompressVerified, mt);
+		}
+		size_t (*compressDispatched)(const int64_t*, size_t, char*, size_t) = compressChecksummed;
+		DecodeStatus (*decompressDispatched)(const char*, size_t, int64_t*) = decompressVerified;
+		checkChecksum(*data, compressDispatched, decompressDispatched, mt);
+
+		if (data != &constant) {
+			delete data;
+		}
+	}
+
+	vector<double> random(1001);
+	std::uniform_real_distribution<double> uniform(-1e9, 1e9);
+	for (auto& value : random) {
+		value = uniform(mt);
+	}
+	size_t (*compressDoubles)(const double*, size_t, char*, size_t) = compressChecksummed;
+	DecodeStatus (*decompressDoubles)(const char*, size_t, double*) = decompressVerified;
+	checkChecksum(random, compressDoubles, decompressDoubles, mt);
+}
+
+template <typename T>
+void checkAggregates(vector<T>& dataIn,
+                     void (*decompressAggregates)(const char*, size_t, Aggregates<T>*)) {
+	size_t count = dataIn.size();
+	vector<char> compressed(Scalar<T>::maxCompressedSize(count));
+	Scalar<T>::compress(dataIn.data(), count, compressed.data(), compressed.size());
+
+	// integers wrap around
+	auto add = [](T a, T b) {
+		return std::is_floating_point<T>::value ? a + b : (T)((uint64_t)a + (uint64_t)b);
+	};
+	// segments are summed separately, then the rest
+	size_t blockSize = count > 16 ? count / 8 : 0;
+	vector<T> sums(8, 0);
+	for (size_t i = 0; i < blockSize * 8; i++) {
+		sums[i / blockSize] = add(sums[i / blockSize], dataIn[i]);
+	}
+	Aggregates<T> expected = {0, numeric_limits<T>::max(), numeric_limits<T>::lowest(), count};
+	if (numeric_limits<T>::has_infinity) {
+		expected.min = numeric_limits<T>::infinity();
+		expected.max = -numeric_limits<T>::infinity();
+	}
+	sums.insert(sums.end(), dataIn.begin() + blockSize * 8, dataIn.end());
+	for (T sum : sums) {
+		expected.sum = add(expected.sum, sum);
+	}
+	for (T value : dataIn) {
+		expected.min = value < expected.min ? value : expected.min;
+		expected.max = value > expected.max ? value : expected.max;
+	}
+
+	Aggregates<T> aggregates;
+	decompressAggregates(compressed.data(), count, &aggregates);
+	ASSERT_EQ(memcmp(&aggregates.sum, &expected.sum, sizeof(T)), 0) << "sum of " << count;
+	ASSERT_EQ(aggregates.min, expected.min) << "min of " << count;
+	ASSERT_EQ(aggregates.max, expected.max) << "max of " << count;
+	ASSERT_EQ(aggregates.count, count);
+}
+
+TEST(CompressionTest, testAggregates) {
+	vector<int64_t> constant(1003, 42);
+	vector<int64_t> extremes(1000);
+	std::mt19937_64 mt(23);
+	for (auto& value : extremes) {
+		// sums overflow
+		value = mt();
+	}
+	for (auto data : {generateTimestamps(5), generateTimestamps(16), generateTimestamps(17),
+	                  generateTimestamps(100), generateTimestamps(1000), generateTimestamps(10007),
+	                  &constant, &extremes}) {
+		checkAggregates(*data, Scalar<int64_t>::decompressAggregates);
+		if (supportsAvx52()) {
+			checkAggregates(*data, Avx52<int64_t>::decompressAggregates);
+		}
+		void (*dispatched)(const char*, size_t, Aggregates<int64_t>*) = decompressAggregates;
+		checkAggregates(*data, dispatched);
+
+		if (data != &constant && data != &extremes) {
+			delete data;
+		}
+	}
+
+	// steps (unchanged rows), NaNs and infinities
+	std::uniform_real_distribution<double> uniform(-1e9, 1e9);
+	for (size_t count : {10, 17, 1000, 10007}) {
+		vector<double> values(count);
+		for (size_t i = 0; i < count; i++) {
+			values[i] = i % 100 < 50 ? uniform(mt) : values[i - 1];
+		}
+		values[count / 2] = std::nan("");
+		checkAggregates(values, Scalar<double>::decompressAggregates);
+		if (supportsAvx52()) {
+			checkAggregates(values, Avx52<double>::decompressAggregates);
+		}
+		void (*dispatched)(const char*, size_t, Aggregates<double>*) = decompressAggregates;
+		checkAggregates(values, dispatched);
+
+		values[count - 1] = -numeric_limits<double>::infinity();
+		checkAggregates(values, dispatched);
+		std::fill(values.begin(), values.end(), std::nan(""));
+		checkAggregates(values, dispatched);
+	}
+}
+
+template <typename T>
+void checkScan(vector<T>& dataIn,
+               size_t (*scan)(const char*, size_t, ScanPredicate, T, uint64_t*),
+               T threshold) {
+	size_t count = dataIn.size();
+	vector<char> compressed(Scalar<T>::maxCompressedSize(count));
+	Scalar<T>::compress(dataIn.data(), count, compressed.data(), compressed.size());
+
+	for (ScanPredicate predicate : {SCAN_LESS, SCAN_LESS_EQUAL, SCAN_GREATER, SCAN_GREATER_EQUAL,
+	                                SCAN_EQUAL, SCAN_NOT_EQUAL}) {
+		vector<uint64_t> expected(scanBitmapWords(count), 0);
+		size_t expectedCount = 0;
+		for (size_t i = 0; i < count; i++) {
+			T value = dataIn[i];
+			bool match = predicate == SCAN_LESS            ? value < threshold
+			             : predicate == SCAN_LESS_EQUAL    ? value <= threshold
+			             : predicate == SCAN_GREATER       ? value > threshold
+			             : predicate == SCAN_GREATER_EQUAL ? value >= threshold
+			             : predicate == SCAN_EQUAL         ? value == threshold
+			                                               : value != threshold;
+			if (match) {
+				expected[i / 64] |= (uint64_t)1 << (i % 64);
+				expectedCount++;
+			}
+		}
+
+		// bitmap is overwritten
+		vector<uint64_t> bitmap(scanBitmapWords(count), ~(uint64_t)0);
+		ASSERT_EQ(scan(compressed.data(), count, predicate, threshold, bitmap.data()),
+		          expectedCount)
+		    << "predicate " << predicate << " count " << count;
+		for (size_t i = 0; i < bitmap.size(); i++) {
+			ASSERT_EQ(bitmap[i], expected[i]) << "word " << i << " predicate " << predicate;
+		}
+	}
+}
+
+TEST(CompressionTest, testScan) {
+	vector<int64_t> constant(1003, 42);
+	for (auto data : {generateTimestamps(5), generateTimestamps(16), generateTimestamps(17),
+	                  generateTimestamps(100), generateTimestamps(1000), generateTimestamps(10007),
+	                  &constant}) {
+		for (int64_t threshold : {(*data)[data->size() / 3], (int64_t)42, (int64_t)-1}) {
+			checkScan(*data, Scalar<int64_t>::scan, threshold);
+			if (supportsAvx52()) {
+				checkScan(*data, Avx52<int64_t>::scan, threshold);
+			}
+			size_t (*dispatched)(const char*, size_t, ScanPredicate, int64_t, uint64_t*) = scan;
+			checkScan(*data, dispatched, threshold);
+		}
+
+		if (data != &constant) {
+			delete data;
+		}
+	}
+
+	// steps (unchanged rows) and NaNs
+	std::mt19937 mt(24);
+	std::uniform_real_distribution<double> uniform(-1e3, 1e3);
+	for (size_t count : {10, 17, 64, 1000, 10007}) {
+		vector<double> values(count);
+		for (size_t i = 0; i < count; i++) {
+			values[i] = i % 100 < 50 ? std::round(uniform(mt)) : values[i - 1];
+		}
+		values[count / 2] = std::nan("");
+		for (double threshold : {values[count / 3], 0.0, std::nan("")}) {
+			checkScan(values, Scalar<double>::scan, threshold);
+			if (supportsAvx52()) {
+				checkScan(values, Avx52<double>::scan, threshold);
+			}
+			size_t (*dispatched)(const char*, size_t, ScanPredicate, double, uint64_t*) = scan;
+			checkScan(values, dispatched, threshold);
+		}
+	}
+}
+
+template <typename T>
+void checkBuckets(vector<T>& dataIn,
+                  size_t (*decompressBuckets)(const char*, size_t, size_t, Bucket<T>*),
+                  size_t width) {
+	size_t count = dataIn.size();
+	vector<char> compressed(Scalar<T>::maxCompressedSize(count));
+	Scalar<T>::compress(dataIn.data(), count, compressed.data(), compressed.size());
+
+	auto add = [](T a, T b) {
+		return std::is_floating_point<T>::value ? a + b : (T)((uint64_t)a + (uint64_t)b);
+	};
+	Bucket<T> empty = {0, 0, numeric_limits<T>::max(), numeric_limits<T>::lowest(), 0, 0};
+	if (numeric_limits<T>::has_infinity) {
+		empty.min = numeric_limits<T>::infinity();
+		empty.max = -numeric_limits<T>::infinity();
+	}
+	auto append = [&](Bucket<T>& bucket, const Bucket<T>& next) {
+		if (bucket.count == 0) {
+			bucket = next;
+			return;
+		}
+		bucket.last = next.last;
+		bucket.min = next.min < bucket.min ? next.min : bucket.min;
+		bucket.max = next.max > bucket.max ? next.max : bucket.max;
+		bucket.sum = add(bucket.sum, next.sum);
+		bucket.count += next.count;
+	};
+
+	// pieces of buckets end with segments, values of the rest are single pieces
+	size_t blockSize = count > 16 ? count / 8 : 0;
+	vector<Bucket<T>> expected((count + width - 1) / width, empty);
+	Bucket<T> piece = empty;
+	for (size_t i = 0; i < count; i++) {
+		bool starts = i % width == 0 || i >= blockSize * 8 || i % blockSize == 0;
+		if (starts && piece.count != 0) {
+			append(expected[(i - 1) / width], piece);
+			piece = empty;
+		}
+		T value = dataIn[i];
+		Bucket<T> single = {value, value, value < empty.min ? value : empty.min,
+		                    value > empty.max ? value : empty.max, value, 1};
+		append(piece, single);
+	}
+	append(expected[(count - 1) / width], piece);
+
+	vector<Bucket<T>> buckets(expected.size() + 1);
+	ASSERT_EQ(decompressBuckets(compressed.data(), count, width, buckets.data()), expected.size());
+	for (size_t i = 0; i < expected.size(); i++) {
+		ASSERT_EQ(memcmp(&buckets[i], &expected[i], sizeof(Bucket<T>)), 0)
+		    << "bucket " << i << " of " << count << " values by " << width;
+	}
+	ASSERT_EQ(decompressBuckets(compressed.data(), count, 0, buckets.data()), 0);
+}
+
+TEST(CompressionTest, testBuckets) {
+	vector<int64_t> constant(1003, 42);
+	for (auto data : {generateTimestamps(5), generateTimestamps(16), generateTimestamps(17),
+	                  generateTimestamps(100), generateTimestamps(1000), generateTimestamps(10007),
+	                  &constant}) {
+		for (size_t width : {1, 3, 8, 60, 1000, 20000}) {
+			checkBuckets(*data, Scalar<int64_t>::decompressBuckets, width);
+			if (supportsAvx52()) {
+				checkBuckets(*data, Avx52<int64_t>::decompressBuckets, width);
+			}
+			size_t (*dispatched)(const char*, size_t, size_t, Bucket<int64_t>*) =
+			    decompressBuckets;
+			checkBuckets(*data, dispatched, width);
+		}
+
+		if (data != &constant) {
+			delete data;
+		}
+	}
+
+	// steps (unchanged rows) and NaNs
+	std::mt19937 mt(25);
+	std::uniform_real_distribution<double> uniform(-1e9, 1e9);
+	for (size_t count : {10, 17, 1000, 10007}) {
+		vector<double> values(count);
+		for (size_t i = 0; i < count; i++) {
+			values[i] = i % 100 < 50 ? uniform(mt) : values[i - 1];
+		}
+		values[count / 2] = std::nan("");
+		for (size_t width : {1, 7, 100, 1251}) {
+			checkBuckets(values, Scalar<double>::decompressBuckets, width);
+			if (supportsAvx52()) {
+				checkBuckets(values, Avx52<double>::decompressBuckets, width);
+			}
+			size_t (*dispatched)(const char*, size_t, size_t, Bucket<double>*) = decompressBuckets;
+			checkBuckets(values, dispatched, width);
+		}
+	}
+}
+
+void checkTruncated(const vector<double>& dataIn, const vector<double>& dataOut, ErrorBound bound) {
+	for (size_t i = 0; i < dataIn.size(); i++) {
+		if (!std::isfinite(dataIn[i])) {
+			ASSERT_EQ(memcmp(&dataIn[i], &dataOut[i], sizeof(double)), 0) << "Index: " << i;
+			continue;
+		}
+		double limit = bound.mode == ERROR_BOUND_ABSOLUTE ? bound.error
+		                                                  : bound.error * std::abs(dataIn[i]);
+		ASSERT_LE(std::abs(dataIn[i] - dataOut[i]), limit) << "Index: " << i;
+		// truncated towards zero
+		ASSERT_LE(std::abs(dataOut[i]), std::abs(dataIn[i])) << "Index: " << i;
+		ASSERT_EQ(std::signbit(dataIn[i]), std::signbit(dataOut[i])) << "Index: " << i;
+	}
+}
+
+/*
+ Values truncated while compressed are compressed to the same output as truncated ones (by compress
+ of the same kernel)
+*/
+void checkLossy(const double* data,
+                size_t count,
+                const vector<double>& truncated,
+                ErrorBound bound,
+                size_t (*compress)(const double*, size_t, char*, size_t),
+                size_t (*compressLossy)(const double*, size_t, char*, size_t, ErrorBound)) {
+	vector<char> expected(Scalar<double>::maxCompressedSize(count));
+	size_t expectedLength = compress(truncated.data(), count, expected.data(), expected.size());
+	vector<char> compressed(expected.size());
+	ASSERT_EQ(compressLossy(data, count, compressed.data(), compressed.size() - 1, bound), 0)
+	    << "Capacity not checked";
+	ASSERT_EQ(compressLossy(data, count, compressed.data(), compressed.size(), bound),
+	          expectedLength);
+	ASSERT_EQ(memcmp(compressed.data(), expected.data(), expectedLength), 0) << "Output differs";
+}
+
+TEST(CompressionTest, testLossy) {
+	std::mt19937 mt(13);
+	std::normal_distribution<double> normal(0, 1);
+	// odd count, vectorized truncation handles the tail
+	const size_t count = 10007;
+	vector<double> walk(count);
+	vector<double> specials(count);
+	const double special[] = {0.0,
+	                          -0.0,
+	                          std::numeric_limits<double>::quiet_NaN(),
+	                          std::numeric_limits<double>::infinity(),
+	                          -std::numeric_limits<double>::infinity(),
+	                          std::numeric_limits<double>::denorm_min(),
+	                          -1e-310,
+	                          std::numeric_limits<double>::min(),
+	                          std::numeric_limits<double>::max(),
+	                          -1e300};
+	for (size_t i = 0; i < count; i++) {
+		walk[i] = (i ? walk[i - 1] : 100.0) + normal(mt);
+		specials[i] = i % 3 == 0 ? special[i / 3 % 10] : normal(mt) * std::pow(10.0, i % 40 - 20);
+	}
+
+	const ErrorBound bounds[] = {{ERROR_BOUND_ABSOLUTE, 1e-3}, {ERROR_BOUND_ABSOLUTE, 0.7},
+	                             {ERROR_BOUND_ABSOLUTE, 1e5},  {ERROR_BOUND_RELATIVE, 1e-6},
+	                             {ERROR_BOUND_RELATIVE, 0.01}, {ERROR_BOUND_RELATIVE, 10}};
+	for (auto data : {&walk, &specials}) {
+		for (ErrorBound bound : bounds) {
+			vector<double> truncated(count);
+			Scalar<double>::truncatePrecision(data->data(), count, truncated.data(), bound);
+			checkTruncated(*data, truncated, bound);
+
+			// idempotent, in place
+			vector<double> again(truncated);
+			Scalar<double>::truncatePrecision(again.data(), count, again.data(), bound);
+			ASSERT_EQ(memcmp(again.data(), truncated.data(), sizeof(double) * count), 0);
+			if (supportsAvx52()) {
+				vector<double> vectorized(count);
+				Avx52<double>::truncatePrecision(data->data(), count, vectorized.data(), bound);
+				ASSERT_EQ(memcmp(vectorized.data(), truncated.data(), sizeof(double) * count), 0);
+			}
+
+			// uncompressed, one block, full data
+			for (size_t length : {(size_t)5, (size_t)37, count}) {
+				vector<double> prefix(truncated.begin(), truncated.begin() + length);
+				checkLossy(data->data(), length, prefix, bound, Scalar<double>::compress,
+				           Scalar<double>::compressLossy);
+				if (supportsAvx52()) {
+					checkLossy(data->data(), length, prefix, bound, Avx52<double>::compress,
+					           Avx52<double>::compressLossy);
+				}
+			}
+
+			vector<char> compressed(maxCompressedSize(count));
+			ASSERT_GT(compressLossy(data->data(), count, compressed.data(), compressed.size(),
+			                        bound),
+			          0);
+			vector<double> dataOut(count);
+			decompress(compressed.data(), count, dataOut.data());
+			ASSERT_EQ(memcmp(dataOut.data(), truncated.data(), sizeof(double) * count), 0);
+
+			// bound is recorded in the frame
+			vector<char> framed(maxFramedSize(count, 7));
+			size_t length =
+			    compressFramed(data->data(), count, framed.data(), framed.size(), bound, true, 7);
+			FrameInfo info;
+			ASSERT_TRUE(readFrameInfo(framed.data(), length, &info));
+			ASSERT_EQ(info.errorBound.mode, bound.mode);
+			ASSERT_EQ(info.errorBound.error, bound.error);
+			std::fill(dataOut.begin(), dataOut.end(), 0);
+			ASSERT_TRUE(decompressFramed(framed.data(), length, dataOut.data(), count));
+			ASSERT_EQ(memcmp(dataOut.data(), truncated.data(), sizeof(double) * count), 0);
+
+			vector<double> range(100);
+			ASSERT_TRUE(Frame<double>::decompressRange(framed.data(), length, 5000, 5100,
+			                                           range.data()));
+			ASSERT_EQ(memcmp(range.data(), &truncated[5000], sizeof(double) * 100), 0);
+		}
+	}
+
+	// noise below the bound is not stored
+	vector<char> compressed(maxCompressedSize(count));
+	size_t lossless = compress(walk.data(), count, compressed.data(), compressed.size());
+	size_t lossy = compressLossy(walk.data(), count, compressed.data(), compressed.size(),
+	                             {ERROR_BOUND_ABSOLUTE, 1e-3});
+	ASSERT_LT(lossy, lossless * 0.6);
+
+	// lossless frame has no bound
+	vector<char> framed(maxFramedSize(count));
+	size_t length = compressFramed(walk.data(), count, framed.data(), framed.size());
+	FrameInfo info;
+	ASSERT_TRUE(readFrameInfo(framed.data(), length, &info));
+	ASSERT_EQ(info.errorBound.mode, ERROR_BOUND_NONE);
+
+	for (ErrorBound invalid : {ErrorBound{ERROR_BOUND_ABSOLUTE, 0},
+	                           ErrorBound{ERROR_BOUND_RELATIVE, -1},
+	                           ErrorBound{ERROR_BOUND_RELATIVE, std::nan("")},
+	                           ErrorBound{ERROR_BOUND_ABSOLUTE, INFINITY}}) {
+		ASSERT_EQ(compressLossy(walk.data(), count, compressed.data(), compressed.size(), invalid),
+		          0);
+		ASSERT_EQ(compressFramed(walk.data(), count, framed.data(), framed.size(), invalid), 0);
+	}
+
+	// integers are not truncated
+	vector<int64_t> integers(1000, 42);
+	vector<char> integersFramed(Frame<int64_t>::maxCompressedSize(1000, 0, TRANSFORM_NONE));
+	ASSERT_EQ(Frame<int64_t>::compress(Scalar<int64_t>::compressLossy, integers.data(), 1000,
+	                                   integersFramed.data(), integersFramed.size(), false, 0,
+	                                   {ERROR_BOUND_ABSOLUTE, 1}),
+	          0);
+}
+
+template <typename T>
+void checkNonTemporal(vector<T>& dataIn, void (*decompress)(const char*, size_t, T*)) {
+	size_t count = dataIn.size();
+	vector<char> compressed(Scalar<T>::maxCompressedSize(count) + 1);
+	Scalar<T>::compress(dataIn, compressed);
+
+	// output starting at every value of a cache line, aligned and unaligned stores
+	vector<T> arena(count + 16);
+	size_t aligned = (64 - reinterpret_cast<uintptr_t>(arena.data()) % 64) % 64 / sizeof(T);
+	for (size_t shift = 0; shift < 8; shift++) {
+		T* dataOut = arena.data() + aligned + shift;
+		decompress(compressed.data(), count, dataOut);
+
+		for (size_t i = 0; i < count; i++) {
+			ASSERT_EQ(dataIn[i], dataOut[i]) << "data do not match. Index: " << i << " Shift: "
+			                                 << shift;
+		}
+	}
+}
+
+TEST(CompressionTest, testNonTemporal) {
+	vector<int64_t> constant(4099, 42);
+	// 4096 values: segments share alignment of the first one
+	for (auto data : {generateTimestamps(17), generateTimestamps(1000), generateTimestamps(4096),
+	                  generateTimestamps(10007), &constant}) {
+		checkNonTemporal(*data, Scalar<int64_t>::decompressNonTemporal);
+
+		if (__builtin_cpu_supports("avx2")) {
+			checkNonTemporal(*data, Avx2<int64_t>::decompressNonTemporal);
+		}
+		if (supportsAvx52()) {
+			checkNonTemporal(*data, Avx52<int64_t>::decompressNonTemporal);
+		}
+		void (*dispatched)(const char*, size_t, int64_t*) = decompressNonTemporal;
+		checkNonTemporal(*data, dispatched);
+
+		if (data != &constant) {
+			delete data;
+		}
+	}
 }
 
 TEST(CompressionTest, testSignChangeAltering) {
@@ -431,10 +2265,15 @@ TEST(CompressionTest, testVersionByte) {
 	auto compressed = Scalar<long>::compressSimple(*data);
 	ASSERT_EQ(compressed->at(compressed->size() - 7), 0x7E) << "Missing data header";
 
-#ifdef USE_AVX512
-	compressed = Avx52<long>::compressSimple(*data);
-	ASSERT_EQ(compressed->at(compressed->size() - 7), 0x7E) << "Missing data header";
-#endif
+	if (__builtin_cpu_supports("avx2")) {
+		compressed = Avx2<long>::compressSimple(*data);
+		ASSERT_EQ(compressed->at(compressed->size() - 7), 0x7E) << "Missing data header";
+	}
+
+	if (supportsAvx52()) {
+		compressed = Avx52<long>::compressSimple(*data);
+		ASSERT_EQ(compressed->at(compressed->size() - 7), 0x7E) << "Missing data header";
+	}
 	delete data;
 }
 
@@ -10,8 +10,12 @@ See LICENSE.md file
 #include <vector>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <immintrin.h>
 #include <iostream>
+#include "delta.hpp"
+#include "status.hpp"
 
 #ifndef HELPERS_H
 #define HELPERS_H
@@ -22,38 +26,56 @@ namespace middleout {
 const size_t VECTOR_SIZE = 8;
 const size_t MIN_DATA_SIZE_COMPRESSION_TRESHOLD = 2 * VECTOR_SIZE;
 
+// AVX512 vector of floats (32bit format)
+const size_t VECTOR_SIZE_32 = 16;
+const size_t MIN_DATA_SIZE_COMPRESSION_TRESHOLD_32 = 2 * VECTOR_SIZE_32;
+
+// version byte and zeroed padding behind the compressed data
+const uint8_t FORMAT_VERSION = 0x7E;  //== 0b01111110
+const size_t TRAILER_SIZE = 7;
+// version byte followed by checksum of the values (see CHECKSUM below) and zeroed padding
+const uint8_t FORMAT_VERSION_CHECKSUM = 0x7F;
+
 //
 // INLINE FUNCTIONS
 //
+// Everything here has internal linkage: each kernel is compiled for its own target (see Makefile)
+// and must not share out-of-line copies of these helpers with the others.
+//
 
 /*
  floors number to base of 8
 */
-inline int floor8(int x) {
+static inline int floor8(int x) {
 	return x & ~7;
 }
 
 /*
  ceils number to base of 8
 */
-inline int ceil8(int x) {
+static inline int ceil8(int x) {
 	return (x + 7) & ~7;
 }
 
-inline uint64_t clearTopBits(uint64_t data, uint64_t bitsCount) {
+static inline uint64_t clearTopBits(uint64_t data, uint64_t bitsCount) {
 	uint64_t clearBase = ~0;
 	return data & (clearBase >> bitsCount);
 }
 
-inline int getBytesLengthOfOffsets(int offsetsCount) {
+static inline int getBytesLengthOfOffsets(int offsetsCount) {
 	// * 3 = bits per one offset
 	// + 7 = round up to bytes
 	// >>  = get number of bytes
 	return (offsetsCount * 3 + 7) >> 3;
 }
 
+static inline int getBytesLengthOfOffsets32(int offsetsCount) {
+	// * 2 = bits per one offset of 32bit value
+	return (offsetsCount * 2 + 7) >> 3;
+}
+
 #ifdef USE_AVX512
-inline __m512i clearTopBits(__m512i toClear, uint64_t bitsCount) {
+static inline __m512i clearTopBits(__m512i toClear, uint64_t bitsCount) {
 	// uint64_t clearBase = ~0;
 	// return data & (clearBase >> bitsCount);
 
@@ -62,31 +84,739 @@ inline __m512i clearTopBits(__m512i toClear, uint64_t bitsCount) {
 }
 #endif
 
+/*
+ Writes format version byte and zeroed padding which allows read-ahead on decompression.
+ Returns length of compressed data.
+*/
+static inline size_t writeTrailer(char* output, size_t outputIndex) {
+	// write compress algorithm version and datatype constant
+	output[outputIndex++] = FORMAT_VERSION;
+
+	// to avoid access to invalid memory on decompression
+	memset(&output[outputIndex], 0, TRAILER_SIZE - 1);
+	return outputIndex + TRAILER_SIZE - 1;
+}
+
+/*
+ Same as writeTrailer, checksum takes first 4 bytes of the padding
+*/
+static inline size_t writeChecksumTrailer(char* output, size_t outputIndex, uint32_t checksum) {
+	output[outputIndex] = FORMAT_VERSION_CHECKSUM;
+	memcpy(&output[outputIndex + 1], &checksum, sizeof(checksum));
+	memset(&output[outputIndex + 1 + sizeof(checksum)], 0, TRAILER_SIZE - 1 - sizeof(checksum));
+	return outputIndex + TRAILER_SIZE;
+}
+
 template <typename T>
-void fillStart(std::vector<T>& data, std::vector<char>& output, size_t blockSize) {
-	T* outAsLong = reinterpret_cast<T*>(output.data());
+static void fillStart(const T* data, char* output, size_t blockSize) {
+	T* outAsLong = reinterpret_cast<T*>(output);
 	for (size_t i = 0; i < VECTOR_SIZE; i++) {
 		outAsLong[i] = data[blockSize * i];
 	}
 }
 
 template <typename T>
-size_t doNotCompressTheData(std::vector<T>& data, std::vector<char>& output) {
-	auto asLong = reinterpret_cast<T*>(output.data());
-	for (size_t i = 0; i < data.size(); i++) {
+static size_t doNotCompressTheData(const T* data, size_t count, char* output) {
+	auto asLong = reinterpret_cast<T*>(output);
+	for (size_t i = 0; i < count; i++) {
 		asLong[i] = data[i];
 	}
-	return sizeof(T) * data.size();
+	return sizeof(T) * count;
 }
 
 template <typename T>
-void doNotDecompressTheData(std::vector<char>& input, size_t inputElements, std::vector<T>& data) {
-	auto asLong = reinterpret_cast<T*>(input.data());
+static void doNotDecompressTheData(const char* input, size_t inputElements, T* data) {
+	auto asLong = reinterpret_cast<const T*>(input);
 	for (size_t i = 0; i < inputElements; i++) {
 		data[i] = asLong[i];
 	}
 }
 
+//
+// ROW ACCESS
+//
+// Row i of compressed data holds values i, blockSize + i, ..., 7 * blockSize + i xored with
+// row i - 1. Row 0 are the reference values.
+//
+
+/*
+ Returns length of compressed row starting at input
+*/
+static inline size_t getRowLength(const char* input) {
+	uint8_t sameMask = input[0];
+	if (sameMask == 0b11111111) {
+		return 1;
+	}
+
+	uint8_t maxLength = (input[1] & 0b111) + 1;
+	int notSameCount = VECTOR_SIZE - __builtin_popcount(sameMask);
+	// +1 because first 3 bits are maxLength
+	return 1 + getBytesLengthOfOffsets(notSameCount + 1) + notSameCount * maxLength;
+}
+
+/*
+ Decompresses row starting at input, values hold previous row and are overwritten by this one.
+ Returns length of compressed row.
+*/
+static inline size_t decompressRow(const char* input, uint64_t* values) {
+	uint8_t sameMask = input[0];
+	if (sameMask == 0b11111111) {
+		return 1;
+	}
+
+	uint32_t compresedOffsetsAndMaxLength;
+	memcpy(&compresedOffsetsAndMaxLength, &input[1], sizeof(uint32_t));
+	uint8_t maxLength = (compresedOffsetsAndMaxLength & 0b111) + 1;
+	uint64_t clearTopBitMask = ~((uint64_t)0) >> (64 - 8 * maxLength);
+
+	int notSameCount = VECTOR_SIZE - __builtin_popcount(sameMask);
+	size_t inputIndex = 1 + getBytesLengthOfOffsets(notSameCount + 1);
+	int offsetsShift = 3;  // skip 3 bits for maxLength
+
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		if (sameMask & (1 << j)) {
+			continue;
+		}
+		uint64_t toXor;
+		memcpy(&toXor, &input[inputIndex], sizeof(uint64_t));
+		int shiftBits = ((compresedOffsetsAndMaxLength >> offsetsShift) & 0b111) * 8;
+		values[j] ^= (toXor & clearTopBitMask) << shiftBits;
+
+		offsetsShift += 3;
+		inputIndex += maxLength;
+	}
+	return inputIndex;
+}
+
+//
+// CHECKSUM
+//
+// Optional checksum of the values (compressChecksummed) is computed by the compression and
+// decompression loops from the rows they hold anyway, so it costs no extra pass over memory. Lane j
+// of the accumulators hashes segment j: value XORed by a per row key is split to 32bit halves whose
+// product is added together with the value to the rotated accumulator. The dependency chain holds
+// rotation and additions only, the rotation keeps a flipped bit repeated in following rows (XOR
+// chain) from cancelling out in the sum. Lanes, the uncompressed rest and count are mixed to 32
+// bits at the end. Data stored uncompressed (at most MIN_DATA_SIZE_COMPRESSION_TRESHOLD values)
+// have no trailer and no checksum.
+//
+
+const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+const int HASH_ROTATION = 23;
+
+struct RowHash {
+	uint64_t accumulators[VECTOR_SIZE];
+	uint64_t keys[VECTOR_SIZE];
+};
+
+static inline void initRowHash(RowHash* hash) {
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		hash->accumulators[j] = 0;
+		hash->keys[j] = HASH_PRIME_2 * (j + 1);
+	}
+}
+
+static inline void hashRow(RowHash* hash, const uint64_t* row) {
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		uint64_t keyed = row[j] ^ hash->keys[j];
+		uint64_t accumulator = hash->accumulators[j];
+		accumulator = (accumulator << HASH_ROTATION) | (accumulator >> (64 - HASH_ROTATION));
+		hash->accumulators[j] = accumulator + (keyed & 0xFFFFFFFF) * (keyed >> 32) + row[j];
+		hash->keys[j] += HASH_PRIME_1;
+	}
+}
+
+static inline uint64_t mixHash(uint64_t hash, uint64_t value) {
+	hash = (hash ^ value) * HASH_PRIME_1;
+	return hash ^ (hash >> 29);
+}
+
+/*
+ 32 bit checksum of count values hashed by rows to accumulators, rest holds values behind rows
+*/
+template <typename T>
+static inline uint32_t finishRowHash(const uint64_t* accumulators, const T* rest, size_t count) {
+	uint64_t hash = count * HASH_PRIME_2;
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		hash = mixHash(hash, accumulators[j]);
+	}
+	for (size_t i = 0; i < count % VECTOR_SIZE; i++) {
+		uint64_t value;
+		memcpy(&value, &rest[i], sizeof(value));
+		hash = mixHash(hash, value);
+	}
+
+	// final avalanche
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME_2;
+	hash ^= hash >> 29;
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+/*
+ Checks checksum of count decompressed values stored in trailer at input
+*/
+template <typename T>
+static inline DecodeStatus verifyChecksum(const char* input,
+                                          const uint64_t* accumulators,
+                                          const T* data,
+                                          size_t count) {
+	if ((uint8_t)input[0] != FORMAT_VERSION_CHECKSUM) {
+		// compressed without checksum
+		return DECODE_MALFORMED;
+	}
+	uint32_t stored;
+	memcpy(&stored, &input[1], sizeof(stored));
+	size_t blockSize = count / VECTOR_SIZE;
+	if (stored != finishRowHash(accumulators, &data[blockSize * VECTOR_SIZE], count)) {
+		return DECODE_CHECKSUM_MISMATCH;
+	}
+	return DECODE_OK;
+}
+
+//
+// SAFE DECODING
+//
+// Input of decompressSafe may be truncated or corrupted. Rows are decoded by the fast decoders
+// while the longest row fits in front of the uncompressed rest (their read-ahead then ends within
+// the rest and the trailer), the last rows are checked one by one and decoded from a padded copy.
+//
+
+// sameMask, offsets of 8 values and 8 values of 8 bytes
+const size_t MAX_ROW_LENGTH = 1 + 4 + VECTOR_SIZE * sizeof(uint64_t);
+// unaligned reads of the decoders end at most this many bytes behind the row
+const size_t ROW_READ_AHEAD = 7;
+
+/*
+ Shortest compressed data which can hold count 64bit values, shorter one would be read out of
+ bounds
+*/
+static inline size_t getMinCompressedSize(size_t count) {
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return sizeof(uint64_t) * count;
+	}
+	// reference values + sameMask of each row + uncompressed rest + trailer
+	return sizeof(uint64_t) * (VECTOR_SIZE + count % VECTOR_SIZE) + (count / VECTOR_SIZE - 1) +
+	       TRAILER_SIZE;
+}
+
+/*
+ End of rows of compressed data of exactly inputSize bytes, uncompressed rest and the trailer
+ follow them. Input must be at least getMinCompressedSize(count) long.
+*/
+static inline size_t getRowsEnd(size_t inputSize, size_t count) {
+	return inputSize - sizeof(uint64_t) * (count % VECTOR_SIZE) - TRAILER_SIZE;
+}
+
+/*
+ Returns length of row starting at input, 0 if the row is longer than size
+*/
+static inline size_t getCheckedRowLength(const char* input, size_t size) {
+	if (size == 0) {
+		return 0;
+	}
+	if ((uint8_t)input[0] == 0b11111111) {
+		return 1;
+	}
+	if (size < 2) {
+		return 0;
+	}
+	size_t length = getRowLength(input);
+	return length <= size ? length : 0;
+}
+
+/*
+ Copies row starting at input to padded, so that it can be decoded with read-ahead. Returns
+ length of the row, 0 if the row is longer than size.
+*/
+static inline size_t padRow(const char* input, size_t size, char* padded) {
+	size_t length = getCheckedRowLength(input, size);
+	memcpy(padded, input, length);
+	memset(&padded[length], 0, MAX_ROW_LENGTH + ROW_READ_AHEAD - length);
+	return length;
+}
+
+/*
+ Tells whether compressed data of exactly inputSize bytes hold checksum, which is verified by
+ decompressSafe
+*/
+static inline bool hasChecksum(const char* input, size_t inputSize) {
+	return (uint8_t)input[inputSize - TRAILER_SIZE] == FORMAT_VERSION_CHECKSUM;
+}
+
+/*
+ Checks that rows end at rowsEnd and are followed by the trailer, copies uncompressed rest of
+ values to data. Checksum is verified if accumulators are given.
+*/
+template <typename T>
+static inline DecodeStatus decompressSafeRest(const char* input,
+                                              size_t inputIndex,
+                                              size_t inputSize,
+                                              size_t itemsCount,
+                                              T* data,
+                                              const uint64_t* accumulators) {
+	size_t rowsEnd = getRowsEnd(inputSize, itemsCount);
+	uint8_t version = accumulators != NULL ? FORMAT_VERSION_CHECKSUM : FORMAT_VERSION;
+	if (inputIndex != rowsEnd || (uint8_t)input[inputSize - TRAILER_SIZE] != version) {
+		return DECODE_MALFORMED;
+	}
+	size_t blockSize = itemsCount / VECTOR_SIZE;
+	memcpy(&data[blockSize * VECTOR_SIZE], &input[rowsEnd],
+	       sizeof(T) * (itemsCount - blockSize * VECTOR_SIZE));
+	if (accumulators != NULL) {
+		return verifyChecksum(&input[inputSize - TRAILER_SIZE], accumulators, data, itemsCount);
+	}
+	return DECODE_OK;
+}
+
+/*
+ Checks input size of values stored uncompressed
+*/
+template <typename T>
+static inline DecodeStatus decompressSafeUncompressed(const char* input,
+                                                      size_t inputSize,
+                                                      size_t itemsCount,
+                                                      T* data) {
+	if (inputSize != sizeof(T) * itemsCount) {
+		return inputSize < sizeof(T) * itemsCount ? DECODE_TRUNCATED : DECODE_MALFORMED;
+	}
+	memcpy(data, input, inputSize);
+	return DECODE_OK;
+}
+
+//
+// VARINTS
+//
+
+static inline size_t getVarintLength(uint64_t value) {
+	size_t length = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		length++;
+	}
+	return length;
+}
+
+/*
+ Writes LEB128 varint of exactly length bytes (zero-padded if value is shorter)
+*/
+static inline void writeVarint(char* output, uint64_t value, size_t length) {
+	for (size_t i = 0; i < length - 1; i++) {
+		output[i] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	output[length - 1] = value & 0x7F;
+}
+
+/*
+ Returns number of bytes read, 0 if varint is not terminated within size bytes
+*/
+static inline size_t readVarint(const char* input, size_t size, uint64_t* value) {
+	uint64_t result = 0;
+	for (size_t i = 0; i < size && i < 10; i++) {
+		uint8_t byte = input[i];
+		result |= (uint64_t)(byte & 0x7F) << (7 * i);
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+//
+// ADAPTIVE ROWS
+//
+// Rows of compressAdaptive are stored by the smallest of three encodings, selected by the lowest
+// header bits:
+//
+//   xx1: 3 bits length - 1 and 3 bits offset (length - 1 | offset << 3) of each stored value
+//   x00: 3 bits max length - 1, 3 bits offset of each stored value (trailing-aligned)
+//   x10: 3 bits max length - 1, 3 bits leading zero bytes shared by all stored values
+//        (leading-aligned, one byte header)
+//
+// Stored values follow the header, each by its own length or by max length. Unchanged rows store
+// sameMask 0xFF only, runs of 2 and more unchanged rows store 0xFF 0xFF and varint of the number
+// of rows following the two (run-length token). Leading-aligned values are stored by bytes max
+// length .. 1 below the shared leading zero bytes, so slowly changing doubles (long common run of
+// leading zero bytes, noisy low mantissa bytes) need no offsets. Each value is then shifted by the
+// same offset, 8 - leading zero bytes - max length.
+//
+
+const int ADAPTIVE_LANES = 1;
+const int ADAPTIVE_LEADING = 2;
+
+static inline int getBytesLengthOfSharedHeader(int notSameCount) {
+	// 2 mode bits, 3 bits of max length, 3 bits per offset
+	return (5 + notSameCount * 3 + 7) >> 3;
+}
+
+static inline int getBytesLengthOfLanesHeader(int notSameCount) {
+	// mode bit, 6 bits per length and offset
+	return (1 + notSameCount * 6 + 7) >> 3;
+}
+
+// 2 mode bits, 3 bits of max length, 3 bits of leading zero bytes
+const int ADAPTIVE_LEADING_HEADER_SIZE = 1;
+
+// sameMask, lanes header of 8 values and 8 values of 8 bytes (run-length token is shorter)
+const size_t MAX_ADAPTIVE_ROW_LENGTH = 1 + 7 + VECTOR_SIZE * sizeof(uint64_t);
+// unaligned reads of decompressAdaptiveRow end at most this many bytes behind the row
+const size_t ADAPTIVE_READ_AHEAD = 8;
+
+/*
+ Shortest compressed adaptive rows which can hold count 64bit values, a run of unchanged rows
+ takes a single byte up to the whole block
+*/
+static inline size_t getMinAdaptiveSize(size_t count) {
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return sizeof(uint64_t) * count;
+	}
+	// reference values + at least one row + uncompressed rest + trailer
+	return sizeof(uint64_t) * (VECTOR_SIZE + count % VECTOR_SIZE) + 1 + TRAILER_SIZE;
+}
+
+/*
+ Writes unchanged rows (a row or run-length token), returns length of written data
+*/
+static inline size_t writeUnchangedRows(char* output, size_t rows) {
+	if (rows < 2) {
+		memset(output, 0b11111111, rows);
+		return rows;
+	}
+	output[0] = output[1] = 0b11111111;
+	size_t length = getVarintLength(rows - 2);
+	writeVarint(&output[2], rows - 2, length);
+	return 2 + length;
+}
+
+/*
+ Reads unchanged rows starting at input (sameMask 0xFF), rowsLeft is the number of rows from this
+ one to the end of the block. Returns length of read data, rows receives the number of rows.
+ Returns 0 if the run-length token is corrupted (varint not terminated or the run passes the end
+ of the block), rows then cover the rest of the block, so decoders trusting the input stay in it.
+*/
+static inline size_t readUnchangedRows(const char* input, size_t rowsLeft, size_t* rows) {
+	// the last row is followed by rest of values, not by a row
+	if (rowsLeft < 2 || (uint8_t)input[1] != 0b11111111) {
+		*rows = 1;
+		return 1;
+	}
+	uint64_t following = 0;
+	size_t length = readVarint(&input[2], 10, &following);
+	if (length == 0 || following > rowsLeft - 2) {
+		*rows = rowsLeft;
+		return 0;
+	}
+	*rows = 2 + following;
+	return 2 + length;
+}
+
+/*
+ Compresses curr row xored with prev one, picks the smallest encoding. Unchanged rows are counted
+ to unchangedRows and written before the next changed row (caller writes the rest after the last
+ row). Returns length of written data, writes up to 7 bytes past it.
+*/
+static inline size_t compressAdaptiveRow(const uint64_t* prev,
+                                         const uint64_t* curr,
+                                         char* output,
+                                         size_t* unchangedRows) {
+	uint8_t sameMask = 0;
+	int maxLength = 0;
+	int lengthsSum = 0;
+	int notSameCount = 0;
+	// zero bytes shared by all stored values
+	int minLeftOffset = 8;
+	int minRightOffset = 8;
+	// mode bits and max length are added once the encoding is known
+	uint64_t sharedHeader = 0;
+	uint64_t lanesHeader = ADAPTIVE_LANES;
+
+	// stored values and their offsets and lengths, in order of storing
+	uint64_t xoredValues[VECTOR_SIZE];
+	int rightOffsets[VECTOR_SIZE];
+	int lengths[VECTOR_SIZE];
+
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		uint64_t xored = prev[j] ^ curr[j];
+		if (xored == 0) {
+			sameMask |= 1 << j;
+			continue;
+		}
+
+		int leftOffsetBytes = __builtin_clzll(xored) >> 3;
+		int rightOffsetBytes = __builtin_ctzll(xored) >> 3;
+		int length = 8 - leftOffsetBytes - rightOffsetBytes;
+
+		sharedHeader |= (uint64_t)rightOffsetBytes << (5 + 3 * notSameCount);
+		lanesHeader |= (uint64_t)((length - 1) | rightOffsetBytes << 3) << (1 + 6 * notSameCount);
+		xoredValues[notSameCount] = xored;
+		rightOffsets[notSameCount] = rightOffsetBytes;
+		lengths[notSameCount] = length;
+
+		maxLength = std::max(length, maxLength);
+		minLeftOffset = std::min(leftOffsetBytes, minLeftOffset);
+		minRightOffset = std::min(rightOffsetBytes, minRightOffset);
+		lengthsSum += length;
+		notSameCount++;
+	}
+
+	if (notSameCount == 0) {
+		(*unchangedRows)++;
+		return 0;
+	}
+
+	size_t outputIndex = writeUnchangedRows(output, *unchangedRows);
+	*unchangedRows = 0;
+	output[outputIndex++] = sameMask;
+
+	int leadingLength = 8 - minLeftOffset - minRightOffset;
+	int sharedSize = getBytesLengthOfSharedHeader(notSameCount) + notSameCount * maxLength;
+	int leadingSize = ADAPTIVE_LEADING_HEADER_SIZE + notSameCount * leadingLength;
+	int lanesSize = getBytesLengthOfLanesHeader(notSameCount) + lengthsSum;
+
+	if (lanesSize < std::min(sharedSize, leadingSize)) {
+		memcpy(&output[outputIndex], &lanesHeader, sizeof(uint64_t));
+		outputIndex += getBytesLengthOfLanesHeader(notSameCount);
+		for (int k = 0; k < notSameCount; k++) {
+			uint64_t shifted = xoredValues[k] >> (8 * rightOffsets[k]);
+			memcpy(&output[outputIndex], &shifted, sizeof(uint64_t));
+			outputIndex += lengths[k];
+		}
+	} else if (leadingSize < sharedSize) {
+		output[outputIndex] = ADAPTIVE_LEADING | (leadingLength - 1) << 2 | minLeftOffset << 5;
+		outputIndex += ADAPTIVE_LEADING_HEADER_SIZE;
+		for (int k = 0; k < notSameCount; k++) {
+			uint64_t shifted = xoredValues[k] >> (8 * minRightOffset);
+			memcpy(&output[outputIndex], &shifted, sizeof(uint64_t));
+			outputIndex += leadingLength;
+		}
+	} else {
+		sharedHeader |= (uint64_t)(maxLength - 1) << 2;
+		memcpy(&output[outputIndex], &sharedHeader, sizeof(uint64_t));
+		outputIndex += getBytesLengthOfSharedHeader(notSameCount);
+		for (int k = 0; k < notSameCount; k++) {
+			uint64_t shifted = xoredValues[k] >> (8 * rightOffsets[k]);
+			memcpy(&output[outputIndex], &shifted, sizeof(uint64_t));
+			outputIndex += maxLength;
+		}
+	}
+	return outputIndex;
+}
+
+/*
+ Returns true if adaptive row starting at input is leading-aligned and its leading zero bytes and
+ max length sum over 8 bytes, which no encoder writes
+*/
+static inline bool isCorruptedLeadingRow(const char* input) {
+	uint8_t sameMask = input[0];
+	uint8_t header = input[1];
+	if (sameMask == 0b11111111 || (header & ADAPTIVE_LANES) || !(header & ADAPTIVE_LEADING)) {
+		return false;
+	}
+	int maxLength = ((header >> 2) & 0b111) + 1;
+	return ((header >> 5) & 0b111) + maxLength > 8;
+}
+
+/*
+ Decompresses adaptive row starting at input, values hold previous row and are overwritten by this
+ one. rowsLeft is the number of rows from this one to the end of the block, rows receives the
+ number of decompressed rows (more than one for a run of unchanged rows). Returns length of read
+ data, reads up to 8 bytes past it. Returns 0 if run-length token is corrupted (see
+ readUnchangedRows), values of a corrupted leading-aligned row are dropped.
+*/
+static inline size_t decompressAdaptiveRow(const char* input,
+                                           uint64_t* values,
+                                           size_t rowsLeft,
+                                           size_t* rows) {
+	uint8_t sameMask = input[0];
+	if (sameMask == 0b11111111) {
+		return readUnchangedRows(input, rowsLeft, rows);
+	}
+	*rows = 1;
+
+	uint64_t header;
+	memcpy(&header, &input[1], sizeof(uint64_t));
+	int notSameCount = VECTOR_SIZE - __builtin_popcount(sameMask);
+	size_t inputIndex = 1;
+
+	if (header & ADAPTIVE_LANES) {
+		inputIndex += getBytesLengthOfLanesHeader(notSameCount);
+		header >>= 1;
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			if (sameMask & (1 << j)) {
+				continue;
+			}
+			int length = (header & 0b111) + 1;
+			int shiftBits = ((header >> 3) & 0b111) * 8;
+			uint64_t toXor;
+			memcpy(&toXor, &input[inputIndex], sizeof(uint64_t));
+			values[j] ^= clearTopBits(toXor, 64 - 8 * length) << shiftBits;
+
+			header >>= 6;
+			inputIndex += length;
+		}
+		return inputIndex;
+	}
+
+	int maxLength = ((header >> 2) & 0b111) + 1;
+	uint64_t clearTopBitMask = ~((uint64_t)0) >> (64 - 8 * maxLength);
+
+	// both alignments by one loop: offsets of each value (trailing-aligned) or none and the shared
+	// shift (leading-aligned)
+	bool leading = header & ADAPTIVE_LEADING;
+	int commonShiftBits = leading ? (8 - ((header >> 5) & 0b111) - maxLength) * 8 : 0;
+	if (commonShiftBits < 0) {
+		// corrupted header (see isCorruptedLeadingRow), values are shifted out as by Avx52
+		clearTopBitMask = 0;
+		commonShiftBits = 0;
+	}
+	uint64_t offsets = leading ? 0 : header >> 5;
+	inputIndex +=
+	    leading ? ADAPTIVE_LEADING_HEADER_SIZE : getBytesLengthOfSharedHeader(notSameCount);
+
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		if (sameMask & (1 << j)) {
+			continue;
+		}
+		int shiftBits = commonShiftBits + (offsets & 0b111) * 8;
+		uint64_t toXor;
+		memcpy(&toXor, &input[inputIndex], sizeof(uint64_t));
+		values[j] ^= (toXor & clearTopBitMask) << shiftBits;
+
+		offsets >>= 3;
+		inputIndex += maxLength;
+	}
+	return inputIndex;
+}
+
+//
+// PREFETCH
+//
+// Rows are read (written on decompression) from 8 distant segments at once, more streams than
+// hardware prefetchers of some CPUs track. Segments are prefetched PREFETCH_DISTANCE rows ahead,
+// build with -D PREFETCH_DISTANCE=0 to disable it.
+//
+
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE 256
+#endif
+
+const int PREFETCH_READ = 0;
+const int PREFETCH_WRITE = 1;
+
+/*
+ Prefetches row i + PREFETCH_DISTANCE of all segments. One call per 8 rows (a cache line of each
+ segment) is enough.
+*/
+template <int rw, typename T>
+static inline void prefetchRows(const T* data, size_t blockSize, size_t i) {
+	if (PREFETCH_DISTANCE == 0 || i + PREFETCH_DISTANCE >= blockSize) {
+		return;
+	}
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		__builtin_prefetch(&data[blockSize * j + i + PREFETCH_DISTANCE], rw, 3);
+	}
+}
+
+//
+// NON-TEMPORAL STORES
+//
+// Values stored non-temporally bypass caches, so decompressing a large series for a writer does
+// not evict data of other processes from the last level cache. Kernels must not read such values
+// back (keep the previous row in registers) and have to end by _mm_sfence.
+//
+
+static inline void streamValue(void* address, uint64_t value) {
+	_mm_stream_si64(reinterpret_cast<long long*>(address), value);
+}
+
+/*
+ Collects row i to tile. Tile is streamed once it holds a whole cache line of the first segment (of
+ all segments if blockSize is a multiple of 8) or the last row: values of a segment streamed one
+ after another fill write-combining buffers, values streamed one by one to 8 far apart segments
+ would be written to memory as partial lines.
+*/
+template <typename T>
+static inline void streamRow(T* data,
+                             size_t blockSize,
+                             size_t i,
+                             const uint64_t* row,
+                             uint64_t tile[][VECTOR_SIZE],
+                             size_t* tileRows) {
+	memcpy(tile[(*tileRows)++], row, sizeof(uint64_t) * VECTOR_SIZE);
+
+	bool lineEnd = (reinterpret_cast<uintptr_t>(&data[i + 1]) & 63) == 0;
+	if (*tileRows < VECTOR_SIZE && !lineEnd && i + 1 < blockSize) {
+		return;
+	}
+
+	size_t first = i + 1 - *tileRows;
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		for (size_t k = 0; k < *tileRows; k++) {
+			streamValue(&data[blockSize * j + first + k], tile[k][j]);
+		}
+	}
+	*tileRows = 0;
+}
+
+//
+// DELTA TRANSFORM
+//
+
+/*
+ Maps signed differences to unsigned ones with few significant bits (0, -1, 1, -2, ... to 0, 1, 2,
+ 3, ...), so small negative differences do not flip all bits
+*/
+static inline uint64_t zigzagEncode(uint64_t x) {
+	return (x << 1) ^ (uint64_t)((int64_t)x >> 63);
+}
+
+static inline uint64_t zigzagDecode(uint64_t x) {
+	return (x >> 1) ^ (0 - (x & 1));
+}
+
+/*
+ Delta transform of one row (not row 0) of VECTOR_SIZE segments, row is overwritten by transformed
+ values. values hold the previous row and are overwritten by this one, deltas hold differences
+ between the previous two rows (delta of delta only, zero for row 0).
+*/
+static inline void encodeDeltaRow(uint64_t* row,
+                                  uint64_t* values,
+                                  uint64_t* deltas,
+                                  Transform transform) {
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		uint64_t delta = row[j] - values[j];
+		values[j] = row[j];
+		if (transform == TRANSFORM_DELTA) {
+			row[j] = zigzagEncode(delta);
+		} else {
+			row[j] = zigzagEncode(delta - deltas[j]);
+			deltas[j] = delta;
+		}
+	}
+}
+
+/*
+ Reverts encodeDeltaRow, values and deltas are the same state of the previous rows
+*/
+static inline void decodeDeltaRow(const uint64_t* row,
+                                  uint64_t* values,
+                                  uint64_t* deltas,
+                                  Transform transform) {
+	if (transform == TRANSFORM_DELTA) {
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			values[j] += zigzagDecode(row[j]);
+		}
+	} else {
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			deltas[j] += zigzagDecode(row[j]);
+			values[j] += deltas[j];
+		}
+	}
+}
+
 }  // end namespace middleout
 
 #endif /* HELPERS_H */
\ No newline at end of file
@@ -10,45 +10,846 @@ See LICENSE.md file
 #include <vector>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <memory>
+#include <type_traits>
 #include "middleout.hpp"
-
-#ifdef USE_AVX512
-#include "avx512.hpp"
-#define ALG_CLASS Avx52
-#else
 #include "scalar.hpp"
-#define ALG_CLASS Scalar
-#endif
+#include "avx2.hpp"
+#include "avx512.hpp"
+#include "scalar32.hpp"
+#include "avx512_32.hpp"
+#include "parallel.hpp"
+#include "batch.hpp"
+#include "frame.hpp"
+#include "delta.hpp"
+#include "codec.hpp"
 
 namespace middleout {
 
+//
+// KERNEL DISPATCH
+//
+// Every kernel is compiled for its own target (see Makefile), this translation unit is compiled
+// for the baseline x86-64 and must not call a kernel the CPU does not support.
+//
+
+enum KernelId { KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512 };
+
+template <typename T>
+struct Kernel {
+	std::unique_ptr<std::vector<char>> (*compressSimple)(std::vector<T>& data);
+	size_t (*compress)(const T* data, size_t count, char* output, size_t capacity);
+	void (*decompress)(const char* input, size_t itemsCount, T* data);
+	// 64bit kernels only
+	void (*decompressNonTemporal)(const char* input, size_t itemsCount, T* data);
+	DecodeStatus (*decompressSafe)(const char* input, size_t inputSize, size_t itemsCount, T* data);
+	size_t (*compressChecksummed)(const T* data, size_t count, char* output, size_t capacity);
+	DecodeStatus (*decompressVerified)(const char* input, size_t itemsCount, T* data);
+	void (*decompressAggregates)(const char* input, size_t itemsCount, Aggregates<T>* aggregates);
+	size_t (*scan)(const char* input,
+	               size_t itemsCount,
+	               ScanPredicate predicate,
+	               T threshold,
+	               uint64_t* bitmap);
+	size_t (*decompressBuckets)(const char* input,
+	                            size_t itemsCount,
+	                            size_t bucketWidth,
+	                            Bucket<T>* buckets);
+	size_t (*compressAdaptive)(const T* data, size_t count, char* output, size_t capacity);
+	void (*decompressAdaptive)(const char* input, size_t itemsCount, T* data);
+	DecodeStatus (*decompressAdaptiveSafe)(const char* input,
+	                                       size_t inputSize,
+	                                       size_t itemsCount,
+	                                       T* data);
+	void (*truncatePrecision)(const T* data, size_t count, T* output, ErrorBound bound);
+	size_t (*compressLossy)(const T* data,
+	                        size_t count,
+	                        char* output,
+	                        size_t capacity,
+	                        ErrorBound bound);
+	size_t (*compressTransformed)(const T* data,
+	                              size_t count,
+	                              char* output,
+	                              size_t capacity,
+	                              Transform transform);
+	void (*decompressTransformed)(const char* input,
+	                              size_t itemsCount,
+	                              T* data,
+	                              Transform transform);
+	DecodeStatus (*decompressSafeTransformed)(const char* input,
+	                                          size_t inputSize,
+	                                          size_t itemsCount,
+	                                          T* data,
+	                                          Transform transform);
+};
+
+template <typename T, template <typename> class ALG>
+Kernel<T> makeKernel() {
+	return {&ALG<T>::compressSimple, &ALG<T>::compress, &ALG<T>::decompress, NULL, NULL, NULL, NULL,
+	        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+}
+
+// kernels without safe decoding, checksums, aggregation, scans, downsampling, adaptive rows,
+// precision truncation and transforms use the FALLBACK_ALG ones
+template <typename T, template <typename> class ALG, template <typename> class FALLBACK_ALG = ALG>
+Kernel<T> makeKernel64() {
+	Kernel<T> kernel = makeKernel<T, ALG>();
+	kernel.decompressNonTemporal = &ALG<T>::decompressNonTemporal;
+	kernel.decompressSafe = &FALLBACK_ALG<T>::decompressSafe;
+	kernel.compressChecksummed = &FALLBACK_ALG<T>::compressChecksummed;
+	kernel.decompressVerified = &FALLBACK_ALG<T>::decompressVerified;
+	kernel.decompressAggregates = &FALLBACK_ALG<T>::decompressAggregates;
+	kernel.scan = &FALLBACK_ALG<T>::scan;
+	kernel.decompressBuckets = &FALLBACK_ALG<T>::decompressBuckets;
+	kernel.compressAdaptive = &FALLBACK_ALG<T>::compressAdaptive;
+	kernel.decompressAdaptive = &FALLBACK_ALG<T>::decompressAdaptive;
+	// rows are checked one by one, there is no vector variant
+	kernel.decompressAdaptiveSafe = &Scalar<T>::decompressAdaptiveSafe;
+	kernel.truncatePrecision = &FALLBACK_ALG<T>::truncatePrecision;
+	kernel.compressLossy = &FALLBACK_ALG<T>::compressLossy;
+	kernel.compressTransformed = &FALLBACK_ALG<T>::compressTransformed;
+	kernel.decompressTransformed = &FALLBACK_ALG<T>::decompressTransformed;
+	kernel.decompressSafeTransformed = &FALLBACK_ALG<T>::decompressSafeTransformed;
+	return kernel;
+}
+
+static bool cpuSupportsAvx2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+	       __builtin_cpu_supports("popcnt");
+}
+
+static bool cpuSupportsAvx512() {
+	__builtin_cpu_init();
+	// features used by Avx52 (lzcnt, mullo_epi64, permutex2var_epi16, 256bit expand)
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd") &&
+	       __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") &&
+	       __builtin_cpu_supports("avx512vl");
+}
+
+/*
+ Picks the fastest kernel supported by CPU. MIDDLEOUT_KERNEL environment variable ("scalar", "avx2"
+ or "avx512") forces a kernel, a kernel not supported by CPU is never selected.
+*/
+static KernelId selectKernel() {
+	bool hasAvx2 = cpuSupportsAvx2();
+	bool hasAvx512 = cpuSupportsAvx512();
+
+	const char* forced = getenv("MIDDLEOUT_KERNEL");
+	if (forced != NULL) {
+		if (strcmp(forced, "scalar") == 0) {
+			return KERNEL_SCALAR;
+		}
+		if (strcmp(forced, "avx2") == 0 && hasAvx2) {
+			return KERNEL_AVX2;
+		}
+		if (strcmp(forced, "avx512") == 0 && hasAvx512) {
+			return KERNEL_AVX512;
+		}
+	}
+
+	if (hasAvx512) {
+		return KERNEL_AVX512;
+	}
+	return hasAvx2 ? KERNEL_AVX2 : KERNEL_SCALAR;
+}
+
+// CPU is probed only once, function statics are safe to use from other static initializers
+static KernelId activeKernel() {
+	static const KernelId id = selectKernel();
+	return id;
+}
+
+// 64bit values
+template <typename T>
+static Kernel<T> bindKernel(std::integral_constant<size_t, 8>) {
+	switch (activeKernel()) {
+		case KERNEL_AVX512:
+			return makeKernel64<T, Avx52>();
+		case KERNEL_AVX2:
+			return makeKernel64<T, Avx2, Scalar>();
+		default:
+			return makeKernel64<T, Scalar>();
+	}
+}
+
+// 32bit values, AVX2 CPUs use the scalar kernel
+template <typename T>
+static Kernel<T> bindKernel(std::integral_constant<size_t, 4>) {
+	switch (activeKernel()) {
+		case KERNEL_AVX512:
+			return makeKernel<T, Avx52x32>();
+		default:
+			return makeKernel<T, Scalar32>();
+	}
+}
+
+template <typename T>
+static const Kernel<T>& kernel() {
+	static const Kernel<T> bound = bindKernel<T>(std::integral_constant<size_t, sizeof(T)>());
+	return bound;
+}
+
+const char* kernelName() {
+	switch (activeKernel()) {
+		case KERNEL_AVX512:
+			return "avx512";
+		case KERNEL_AVX2:
+			return "avx2";
+		default:
+			return "scalar";
+	}
+}
+
+// output size from which decompress stores non-temporally, such output does not fit common LLCs
+const size_t NON_TEMPORAL_THRESHOLD = 64 * 1024 * 1024;
+
+template <typename T>
+static void decompressDispatched(const char* input, size_t itemsCount, T* data) {
+	if (itemsCount * sizeof(T) >= NON_TEMPORAL_THRESHOLD) {
+		kernel<T>().decompressNonTemporal(input, itemsCount, data);
+	} else {
+		kernel<T>().decompress(input, itemsCount, data);
+	}
+}
+
+//
+// PUBLIC API
+//
+
 std::unique_ptr<std::vector<char>> compressSimple(std::vector<int64_t>& data) {
-	return ALG_CLASS<int64_t>::compressSimple(data);
+	return kernel<int64_t>().compressSimple(data);
 }
 
 std::unique_ptr<std::vector<char>> compressSimple(std::vector<double>& data) {
-	return ALG_CLASS<double>::compressSimple(data);
+	return kernel<double>().compressSimple(data);
 }
 
 size_t compress(std::vector<int64_t>& data, std::vector<char>& output) {
-	return ALG_CLASS<int64_t>::compress(data, output);
+	return kernel<int64_t>().compress(data.data(), data.size(), output.data(), output.size());
 }
 
 size_t compress(std::vector<double>& data, std::vector<char>& output) {
-	return ALG_CLASS<double>::compress(data, output);
+	return kernel<double>().compress(data.data(), data.size(), output.data(), output.size());
 }
 
 void decompress(std::vector<char>& input, size_t inputElements, std::vector<int64_t>& data) {
-	return ALG_CLASS<int64_t>::decompress(input, inputElements, data);
+	return decompressDispatched(input.data(), inputElements, data.data());
 }
 
 void decompress(std::vector<char>& input, size_t inputElements, std::vector<double>& data) {
-	return ALG_CLASS<double>::decompress(input, inputElements, data);
+	return decompressDispatched(input.data(), inputElements, data.data());
+}
+
+size_t compress(const int64_t* data, size_t count, char* output, size_t capacity) {
+	return kernel<int64_t>().compress(data, count, output, capacity);
+}
+
+size_t compress(const double* data, size_t count, char* output, size_t capacity) {
+	return kernel<double>().compress(data, count, output, capacity);
+}
+
+void decompress(const char* input, size_t inputElements, int64_t* data) {
+	return decompressDispatched(input, inputElements, data);
+}
+
+void decompress(const char* input, size_t inputElements, double* data) {
+	return decompressDispatched(input, inputElements, data);
+}
+
+void decompressNonTemporal(const char* input, size_t inputElements, int64_t* data) {
+	return kernel<int64_t>().decompressNonTemporal(input, inputElements, data);
+}
+
+void decompressNonTemporal(const char* input, size_t inputElements, double* data) {
+	return kernel<double>().decompressNonTemporal(input, inputElements, data);
+}
+
+DecodeStatus decompressSafe(const char* input, size_t inputSize, size_t itemsCount, int64_t* data) {
+	return kernel<int64_t>().decompressSafe(input, inputSize, itemsCount, data);
+}
+
+DecodeStatus decompressSafe(const char* input, size_t inputSize, size_t itemsCount, double* data) {
+	return kernel<double>().decompressSafe(input, inputSize, itemsCount, data);
+}
+
+size_t compressChecksummed(const int64_t* data, size_t count, char* output, size_t capacity) {
+	return kernel<int64_t>().compressChecksummed(data, count, output, capacity);
+}
+
+size_t compressChecksummed(const double* data, size_t count, char* output, size_t capacity) {
+	return kernel<double>().compressChecksummed(data, count, output, capacity);
+}
+
+DecodeStatus decompressVerified(const char* input, size_t itemsCount, int64_t* data) {
+	return kernel<int64_t>().decompressVerified(input, itemsCount, data);
+}
+
+DecodeStatus decompressVerified(const char* input, size_t itemsCount, double* data) {
+	return kernel<double>().decompressVerified(input, itemsCount, data);
+}
+
+void decompressAggregates(const char* input, size_t itemsCount, Aggregates<int64_t>* aggregates) {
+	kernel<int64_t>().decompressAggregates(input, itemsCount, aggregates);
+}
+
+void decompressAggregates(const char* input, size_t itemsCount, Aggregates<double>* aggregates) {
+	kernel<double>().decompressAggregates(input, itemsCount, aggregates);
+}
+
+size_t scan(const char* input,
+            size_t itemsCount,
+            ScanPredicate predicate,
+            int64_t threshold,
+            uint64_t* bitmap) {
+	return kernel<int64_t>().scan(input, itemsCount, predicate, threshold, bitmap);
+}
+
+size_t scan(const char* input,
+            size_t itemsCount,
+            ScanPredicate predicate,
+            double threshold,
+            uint64_t* bitmap) {
+	return kernel<double>().scan(input, itemsCount, predicate, threshold, bitmap);
+}
+
+size_t decompressBuckets(const char* input,
+                         size_t itemsCount,
+                         size_t bucketWidth,
+                         Bucket<int64_t>* buckets) {
+	return kernel<int64_t>().decompressBuckets(input, itemsCount, bucketWidth, buckets);
+}
+
+size_t decompressBuckets(const char* input,
+                         size_t itemsCount,
+                         size_t bucketWidth,
+                         Bucket<double>* buckets) {
+	return kernel<double>().decompressBuckets(input, itemsCount, bucketWidth, buckets);
+}
+
+size_t compressAdaptive(const int64_t* data, size_t count, char* output, size_t capacity) {
+	return kernel<int64_t>().compressAdaptive(data, count, output, capacity);
+}
+
+size_t compressAdaptive(const double* data, size_t count, char* output, size_t capacity) {
+	return kernel<double>().compressAdaptive(data, count, output, capacity);
+}
+
+void decompressAdaptive(const char* input, size_t inputElements, int64_t* data) {
+	return kernel<int64_t>().decompressAdaptive(input, inputElements, data);
+}
+
+void decompressAdaptive(const char* input, size_t inputElements, double* data) {
+	return kernel<double>().decompressAdaptive(input, inputElements, data);
+}
+
+DecodeStatus decompressAdaptiveSafe(const char* input,
+                                    size_t inputSize,
+                                    size_t itemsCount,
+                                    int64_t* data) {
+	return kernel<int64_t>().decompressAdaptiveSafe(input, inputSize, itemsCount, data);
+}
+
+DecodeStatus decompressAdaptiveSafe(const char* input,
+                                    size_t inputSize,
+                                    size_t itemsCount,
+                                    double* data) {
+	return kernel<double>().decompressAdaptiveSafe(input, inputSize, itemsCount, data);
+}
+
+void truncatePrecision(const double* data, size_t count, double* output, ErrorBound bound) {
+	kernel<double>().truncatePrecision(data, count, output, bound);
+}
+
+size_t compressLossy(const double* data,
+                     size_t count,
+                     char* output,
+                     size_t capacity,
+                     ErrorBound bound) {
+	return kernel<double>().compressLossy(data, count, output, capacity, bound);
+}
+
+template <typename T>
+static CompressedView compressToScratch(const T* data, size_t count, std::vector<char>& scratch) {
+	size_t capacity = maxCompressedSize(count);
+	if (scratch.size() < capacity) {
+		// never shrinks, steady state does not allocate
+		scratch.resize(capacity);
+	}
+	size_t size = kernel<T>().compress(data, count, scratch.data(), scratch.size());
+	return {scratch.data(), size};
+}
+
+CompressedView compressSimple(const int64_t* data, size_t count, std::vector<char>& scratch) {
+	return compressToScratch(data, count, scratch);
+}
+
+CompressedView compressSimple(const double* data, size_t count, std::vector<char>& scratch) {
+	return compressToScratch(data, count, scratch);
+}
+
+#if __cplusplus >= 201703L
+template <typename T>
+static CompressedView compressToResource(const T* data,
+                                         size_t count,
+                                         std::vector<char>& scratch,
+                                         std::pmr::memory_resource* resource) {
+	CompressedView compressed = compressToScratch(data, count, scratch);
+	// compressed data are much smaller than maxCompressedSize, copy is cheaper than reserving it
+	char* block = static_cast<char*>(resource->allocate(compressed.size, 1));
+	memcpy(block, compressed.data, compressed.size);
+	return {block, compressed.size};
+}
+
+CompressedView compressSimple(const int64_t* data,
+                              size_t count,
+                              std::vector<char>& scratch,
+                              std::pmr::memory_resource* resource) {
+	return compressToResource(data, count, scratch, resource);
+}
+
+CompressedView compressSimple(const double* data,
+                              size_t count,
+                              std::vector<char>& scratch,
+                              std::pmr::memory_resource* resource) {
+	return compressToResource(data, count, scratch, resource);
+}
+#endif
+
+size_t compress(const int64_t* data,
+                size_t count,
+                char* output,
+                size_t capacity,
+                Transform transform) {
+	return kernel<int64_t>().compressTransformed(data, count, output, capacity, transform);
+}
+
+size_t compress(const uint64_t* data,
+                size_t count,
+                char* output,
+                size_t capacity,
+                Transform transform) {
+	return kernel<uint64_t>().compressTransformed(data, count, output, capacity, transform);
+}
+
+void decompress(const char* input, size_t inputElements, int64_t* data, Transform transform) {
+	kernel<int64_t>().decompressTransformed(input, inputElements, data, transform);
+}
+
+void decompress(const char* input, size_t inputElements, uint64_t* data, Transform transform) {
+	kernel<uint64_t>().decompressTransformed(input, inputElements, data, transform);
+}
+
+DecodeStatus decompressSafe(const char* input,
+                            size_t inputSize,
+                            size_t inputElements,
+                            int64_t* data,
+                            Transform transform) {
+	return kernel<int64_t>().decompressSafeTransformed(input, inputSize, inputElements, data,
+	                                                   transform);
+}
+
+DecodeStatus decompressSafe(const char* input,
+                            size_t inputSize,
+                            size_t inputElements,
+                            uint64_t* data,
+                            Transform transform) {
+	return kernel<uint64_t>().decompressSafeTransformed(input, inputSize, inputElements, data,
+	                                                    transform);
+}
+
+std::unique_ptr<std::vector<char>> compressSimple(std::vector<int32_t>& data) {
+	return kernel<int32_t>().compressSimple(data);
+}
+
+std::unique_ptr<std::vector<char>> compressSimple(std::vector<float>& data) {
+	return kernel<float>().compressSimple(data);
+}
+
+size_t compress(std::vector<int32_t>& data, std::vector<char>& output) {
+	return kernel<int32_t>().compress(data.data(), data.size(), output.data(), output.size());
+}
+
+size_t compress(std::vector<float>& data, std::vector<char>& output) {
+	return kernel<float>().compress(data.data(), data.size(), output.data(), output.size());
+}
+
+void decompress(std::vector<char>& input, size_t inputElements, std::vector<int32_t>& data) {
+	return kernel<int32_t>().decompress(input.data(), inputElements, data.data());
+}
+
+void decompress(std::vector<char>& input, size_t inputElements, std::vector<float>& data) {
+	return kernel<float>().decompress(input.data(), inputElements, data.data());
+}
+
+size_t compress(const int32_t* data, size_t count, char* output, size_t capacity) {
+	return kernel<int32_t>().compress(data, count, output, capacity);
+}
+
+size_t compress(const float* data, size_t count, char* output, size_t capacity) {
+	return kernel<float>().compress(data, count, output, capacity);
+}
+
+void decompress(const char* input, size_t inputElements, int32_t* data) {
+	return kernel<int32_t>().decompress(input, inputElements, data);
+}
+
+void decompress(const char* input, size_t inputElements, float* data) {
+	return kernel<float>().decompress(input, inputElements, data);
+}
+
+size_t maxCompressedSizeParallel(size_t count, size_t chunkSize) {
+	return Parallel<double>::maxCompressedSize(count, chunkSize);
+}
+
+size_t compressParallel(std::vector<int64_t>& data,
+                        std::vector<char>& output,
+                        size_t threads,
+                        size_t chunkSize) {
+	return Parallel<int64_t>::compress(kernel<int64_t>().compress, data.data(), data.size(),
+	                                   output.data(), output.size(), threads, chunkSize);
+}
+
+size_t compressParallel(std::vector<double>& data,
+                        std::vector<char>& output,
+                        size_t threads,
+                        size_t chunkSize) {
+	return Parallel<double>::compress(kernel<double>().compress, data.data(), data.size(),
+	                                  output.data(), output.size(), threads, chunkSize);
+}
+
+size_t compressParallel(const int64_t* data,
+                        size_t count,
+                        char* output,
+                        size_t capacity,
+                        size_t threads,
+                        size_t chunkSize) {
+	return Parallel<int64_t>::compress(kernel<int64_t>().compress, data, count, output, capacity,
+	                                   threads, chunkSize);
+}
+
+size_t compressParallel(const double* data,
+                        size_t count,
+                        char* output,
+                        size_t capacity,
+                        size_t threads,
+                        size_t chunkSize) {
+	return Parallel<double>::compress(kernel<double>().compress, data, count, output, capacity,
+	                                  threads, chunkSize);
+}
+
+void decompressParallel(std::vector<char>& input,
+                        size_t itemsCount,
+                        std::vector<int64_t>& data,
+                        size_t threads) {
+	Parallel<int64_t>::decompress(kernel<int64_t>().decompress, input.data(), itemsCount,
+	                              data.data(), threads);
+}
+
+void decompressParallel(std::vector<char>& input,
+                        size_t itemsCount,
+                        std::vector<double>& data,
+                        size_t threads) {
+	Parallel<double>::decompress(kernel<double>().decompress, input.data(), itemsCount, data.data(),
+	                             threads);
+}
+
+void decompressParallel(const char* input, size_t itemsCount, int64_t* data, size_t threads) {
+	Parallel<int64_t>::decompress(kernel<int64_t>().decompress, input, itemsCount, data, threads);
+}
+
+void decompressParallel(const char* input, size_t itemsCount, double* data, size_t threads) {
+	Parallel<double>::decompress(kernel<double>().decompress, input, itemsCount, data, threads);
+}
+
+size_t batchGroupsCount(size_t count) {
+	return Batch<double>::getGroupsCount(count);
+}
+
+size_t maxCompressedSizeBatch(const size_t* lengths, size_t count) {
+	return Batch<double>::maxCompressedSize(lengths, count);
+}
+
+size_t compressBatch(const int64_t* const* series,
+                     const size_t* lengths,
+                     size_t count,
+                     char* output,
+                     size_t capacity,
+                     size_t* offsets) {
+	return Batch<int64_t>::compress(kernel<int64_t>().compress, series, lengths, count, output,
+	                                capacity, offsets);
+}
+
+size_t compressBatch(const double* const* series,
+                     const size_t* lengths,
+                     size_t count,
+                     char* output,
+                     size_t capacity,
+                     size_t* offsets) {
+	return Batch<double>::compress(kernel<double>().compress, series, lengths, count, output,
+	                               capacity, offsets);
+}
+
+void decompressBatch(const char* input,
+                     const size_t* offsets,
+                     const size_t* lengths,
+                     size_t count,
+                     int64_t* const* series) {
+	Batch<int64_t>::decompress(kernel<int64_t>().decompress, input, offsets, lengths, count,
+	                           series);
+}
+
+void decompressBatch(const char* input,
+                     const size_t* offsets,
+                     const size_t* lengths,
+                     size_t count,
+                     double* const* series) {
+	Batch<double>::decompress(kernel<double>().decompress, input, offsets, lengths, count, series);
 }
 
 size_t maxCompressedSize(size_t count) {
-	return ALG_CLASS<double>::maxCompressedSize(count);
+	// all kernels share the same format
+	return Scalar<double>::maxCompressedSize(count);
+}
+
+size_t maxCompressedSize32(size_t count) {
+	return Scalar32<float>::maxCompressedSize(count);
+}
+
+size_t compressBound(size_t count) {
+	return Codec<double>::compressBound(count);
+}
+
+size_t compressBound32(size_t count) {
+	return Codec<float>::compressBound(count);
+}
+
+/*
+ Kernels compress whole data at once (row layout depends on count) and check maxCompressedSize
+ upfront, they cannot hand the rows close to the end of output over, so smaller output is
+ compressed by the portable rows (see compressBounded in middleout.hpp for the cost)
+*/
+template <typename T>
+static size_t compressBoundedDispatched(const T* data,
+                                        size_t count,
+                                        char* output,
+                                        size_t capacity) {
+	if (capacity >= Codec<T>::maxCompressedSize(count)) {
+		// kernels' writes past the data fit
+		return kernel<T>().compress(data, count, output, capacity);
+	}
+	// same format, rows close to the end of output go through a temp buffer
+	return Codec<T>::compressBounded(data, count, output, capacity);
+}
+
+size_t compressBounded(const int64_t* data, size_t count, char* output, size_t capacity) {
+	return compressBoundedDispatched(data, count, output, capacity);
+}
+
+size_t compressBounded(const double* data, size_t count, char* output, size_t capacity) {
+	return compressBoundedDispatched(data, count, output, capacity);
+}
+
+size_t compressBounded(const int32_t* data, size_t count, char* output, size_t capacity) {
+	return compressBoundedDispatched(data, count, output, capacity);
+}
+
+size_t compressBounded(const float* data, size_t count, char* output, size_t capacity) {
+	return compressBoundedDispatched(data, count, output, capacity);
+}
+
+size_t maxFramedSize(size_t count, size_t indexInterval, Transform transform) {
+	return Frame<int64_t>::maxCompressedSize(count, indexInterval, transform);
+}
+
+size_t compressFramed(std::vector<int64_t>& data,
+                      std::vector<char>& output,
+                      bool checksum,
+                      size_t indexInterval,
+                      Transform transform) {
+	return Frame<int64_t>::compress(kernel<int64_t>().compressTransformed, data.data(),
+	                                data.size(), output.data(), output.size(), checksum,
+	                                indexInterval, transform);
+}
+
+size_t compressFramed(std::vector<uint64_t>& data,
+                      std::vector<char>& output,
+                      bool checksum,
+                      size_t indexInterval,
+                      Transform transform) {
+	return Frame<uint64_t>::compress(kernel<uint64_t>().compressTransformed, data.data(),
+	                                 data.size(), output.data(), output.size(), checksum,
+	                                 indexInterval, transform);
+}
+
+size_t compressFramed(std::vector<double>& data,
+                      std::vector<char>& output,
+                      bool checksum,
+                      size_t indexInterval) {
+	return Frame<double>::compress(kernel<double>().compress, data.data(), data.size(),
+	                               output.data(), output.size(), checksum, indexInterval);
+}
+
+size_t compressFramed(const int64_t* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      bool checksum,
+                      size_t indexInterval,
+                      Transform transform) {
+	return Frame<int64_t>::compress(kernel<int64_t>().compressTransformed, data, count, output,
+	                                capacity, checksum, indexInterval, transform);
+}
+
+size_t compressFramed(const uint64_t* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      bool checksum,
+                      size_t indexInterval,
+                      Transform transform) {
+	return Frame<uint64_t>::compress(kernel<uint64_t>().compressTransformed, data, count, output,
+	                                 capacity, checksum, indexInterval, transform);
+}
+
+size_t compressFramed(const double* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      bool checksum,
+                      size_t indexInterval) {
+	return Frame<double>::compress(kernel<double>().compress, data, count, output, capacity,
+	                               checksum, indexInterval);
+}
+
+size_t compressFramed(const double* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      ErrorBound bound,
+                      bool checksum,
+                      size_t indexInterval) {
+	return Frame<double>::compress(kernel<double>().compressLossy, data, count, output, capacity,
+	                               checksum, indexInterval, bound);
+}
+
+bool readFrameInfo(const char* input, size_t inputSize, FrameInfo* info) {
+	// header does not depend on element type
+	return Frame<double>::readInfo(input, inputSize, info);
+}
+
+/*
+ Integer frames may be transformed, doubles never are
+*/
+template <typename T>
+static bool decompressFramedDispatched(const char* input,
+                                       size_t inputSize,
+                                       T* data,
+                                       size_t capacity) {
+	if (std::is_floating_point<T>::value) {
+		return Frame<T>::decompress(kernel<T>().decompressSafe, input, inputSize, data, capacity);
+	}
+	return Frame<T>::decompress(kernel<T>().decompressSafeTransformed, input, inputSize, data,
+	                            capacity);
+}
+
+template <typename T>
+static bool decompressFramedVector(std::vector<char>& input, std::vector<T>& data) {
+	FrameInfo info;
+	if (!Frame<T>::readInfo(input.data(), input.size(), &info)) {
+		return false;
+	}
+
+	std::vector<T> decompressed(info.itemsCount);
+	if (!decompressFramedDispatched(input.data(), input.size(), decompressed.data(),
+	                                decompressed.size())) {
+		return false;
+	}
+	data.swap(decompressed);
+	return true;
+}
+
+bool decompress(std::vector<char>& input, std::vector<int64_t>& data) {
+	return decompressFramedVector(input, data);
+}
+
+bool decompress(std::vector<char>& input, std::vector<uint64_t>& data) {
+	return decompressFramedVector(input, data);
+}
+
+bool decompress(std::vector<char>& input, std::vector<double>& data) {
+	return decompressFramedVector(input, data);
+}
+
+bool decompressFramed(const char* input, size_t inputSize, int64_t* data, size_t capacity) {
+	return decompressFramedDispatched(input, inputSize, data, capacity);
+}
+
+bool decompressFramed(const char* input, size_t inputSize, uint64_t* data, size_t capacity) {
+	return decompressFramedDispatched(input, inputSize, data, capacity);
+}
+
+bool decompressFramed(const char* input, size_t inputSize, double* data, size_t capacity) {
+	return decompressFramedDispatched(input, inputSize, data, capacity);
+}
+
+template <typename T>
+static bool decompressRangeVector(std::vector<char>& input,
+                                  size_t from,
+                                  size_t to,
+                                  std::vector<T>& data) {
+	if (from > to) {
+		return false;
+	}
+	std::vector<T> decompressed(to - from);
+	if (!Frame<T>::decompressRange(input.data(), input.size(), from, to, decompressed.data())) {
+		return false;
+	}
+	data.swap(decompressed);
+	return true;
+}
+
+bool decompressRange(std::vector<char>& input,
+                     size_t from,
+                     size_t to,
+                     std::vector<int64_t>& data) {
+	return decompressRangeVector(input, from, to, data);
+}
+
+bool decompressRange(std::vector<char>& input,
+                     size_t from,
+                     size_t to,
+                     std::vector<uint64_t>& data) {
+	return decompressRangeVector(input, from, to, data);
+}
+
+bool decompressRange(std::vector<char>& input, size_t from, size_t to, std::vector<double>& data) {
+	return decompressRangeVector(input, from, to, data);
+}
+
+bool decompressRange(const char* input, size_t inputSize, size_t from, size_t to, int64_t* data) {
+	return Frame<int64_t>::decompressRange(input, inputSize, from, to, data);
+}
+
+bool decompressRange(const char* input, size_t inputSize, size_t from, size_t to, uint64_t* data) {
+	return Frame<uint64_t>::decompressRange(input, inputSize, from, to, data);
+}
+
+bool decompressRange(const char* input, size_t inputSize, size_t from, size_t to, double* data) {
+	return Frame<double>::decompressRange(input, inputSize, from, to, data);
+}
+
+bool get(const char* input, size_t inputSize, size_t index, int64_t* value) {
+	return Frame<int64_t>::decompressRange(input, inputSize, index, index + 1, value);
+}
+
+bool get(const char* input, size_t inputSize, size_t index, uint64_t* value) {
+	return Frame<uint64_t>::decompressRange(input, inputSize, index, index + 1, value);
+}
+
+bool get(const char* input, size_t inputSize, size_t index, double* value) {
+	return Frame<double>::decompressRange(input, inputSize, index, index + 1, value);
 }
 
 }  // end namespace middleout
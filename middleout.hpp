@@ -12,6 +12,15 @@ See LICENSE.md file
 #include <stdlib.h>
 #include <iostream>
 #include <memory>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+#include "frame.hpp"
+#include "stream.hpp"
+#include "delta.hpp"
+#include "aggregate.hpp"
+#include "precision.hpp"
+#include "status.hpp"
 
 #ifndef MIDDLEOUT_H_
 #define MIDDLEOUT_H_
@@ -30,8 +39,458 @@ void decompress(std::vector<char>& input, size_t itemsCount, std::vector<int64_t
 
 void decompress(std::vector<char>& input, size_t itemsCount, std::vector<double>& data);
 
+/*
+ Zero-copy variants working on caller owned memory. compress returns 0 (nothing written) if
+ capacity is less than maxCompressedSize(count).
+*/
+size_t compress(const int64_t* data, size_t count, char* output, size_t capacity);
+
+size_t compress(const double* data, size_t count, char* output, size_t capacity);
+
+void decompress(const char* input, size_t itemsCount, int64_t* data);
+
+void decompress(const char* input, size_t itemsCount, double* data);
+
+/*
+ Decompression writing data by non-temporal stores, which bypass caches: decompressing for a writer
+ (network, disk) does not evict other processes' data from the last level cache, but reading data
+ right after is slower. Decompress above does it for outputs of 64 MB and more.
+*/
+void decompressNonTemporal(const char* input, size_t itemsCount, int64_t* data);
+
+void decompressNonTemporal(const char* input, size_t itemsCount, double* data);
+
+/*
+ Validating variants for data which may be truncated or corrupted (read from disk or network).
+ inputSize is the exact compressed length, nothing is read outside of input. Returns DECODE_OK, or
+ an error code when the input cannot hold itemsCount values (data are clobbered then). Values
+ themselves are not verified (see checksum of frames).
+*/
+DecodeStatus decompressSafe(const char* input, size_t inputSize, size_t itemsCount, int64_t* data);
+
+DecodeStatus decompressSafe(const char* input, size_t inputSize, size_t itemsCount, double* data);
+
+/*
+ Integrity check of the values without an extra pass over data: compressChecksummed stores their
+ checksum in the trailer (output is read by decompress too), decompressVerified and decompressSafe
+ verify it while decoding. decompressVerified returns DECODE_CHECKSUM_MISMATCH or DECODE_MALFORMED
+ (no checksum stored), it trusts the input like decompress. At most 16 values are stored
+ uncompressed, without checksum.
+*/
+size_t compressChecksummed(const int64_t* data, size_t count, char* output, size_t capacity);
+
+size_t compressChecksummed(const double* data, size_t count, char* output, size_t capacity);
+
+DecodeStatus decompressVerified(const char* input, size_t itemsCount, int64_t* data);
+
+DecodeStatus decompressVerified(const char* input, size_t itemsCount, double* data);
+
+/*
+ Sum, min, max and count of compressed values (output of compress) computed while decoding, the
+ values are never stored, so only the compressed data are read from memory. Rows same as the
+ previous ones update sums only. See aggregate.hpp for sums of doubles and NaNs.
+*/
+void decompressAggregates(const char* input, size_t itemsCount, Aggregates<int64_t>* aggregates);
+
+void decompressAggregates(const char* input, size_t itemsCount, Aggregates<double>* aggregates);
+
+/*
+ Marks values of compressed data (output of compress) matching predicate, e.g. value > threshold,
+ in bitmap of scanBitmapWords(itemsCount) words (see aggregate.hpp). Values are compared while
+ decoding and never stored, rows same as the previous ones are not compared again. Returns number
+ of matching values.
+*/
+size_t scan(const char* input,
+            size_t itemsCount,
+            ScanPredicate predicate,
+            int64_t threshold,
+            uint64_t* bitmap);
+
+size_t scan(const char* input,
+            size_t itemsCount,
+            ScanPredicate predicate,
+            double threshold,
+            uint64_t* bitmap);
+
+/*
+ Downsampling of compressed data (output of compress) for charts: buckets of bucketWidth
+ consecutive values (the last one may be shorter) with their first, last, min, max, sum and count
+ (see aggregate.hpp), computed while decoding without storing the values. buckets must hold
+ getBucketsCount(itemsCount, bucketWidth) of them. Returns number of buckets, 0 if bucketWidth is
+ 0.
+*/
+size_t decompressBuckets(const char* input,
+                         size_t itemsCount,
+                         size_t bucketWidth,
+                         Bucket<int64_t>* buckets);
+
+size_t decompressBuckets(const char* input,
+                         size_t itemsCount,
+                         size_t bucketWidth,
+                         Bucket<double>* buckets);
+
+/*
+ Adaptive rows store each changed value by its own byte length whenever that is smaller than
+ storing all of them by the longest one, so a noisy segment does not inflate the others (mixed
+ series, e.g. gauges of unlike cardinality). A bit slower; output is sized by maxCompressedSize and
+ readable by decompressAdaptive only.
+*/
+size_t compressAdaptive(const int64_t* data, size_t count, char* output, size_t capacity);
+
+size_t compressAdaptive(const double* data, size_t count, char* output, size_t capacity);
+
+void decompressAdaptive(const char* input, size_t itemsCount, int64_t* data);
+
+void decompressAdaptive(const char* input, size_t itemsCount, double* data);
+
+/*
+ Validating decompressAdaptive (see decompressSafe), inputSize is the exact compressed length
+*/
+DecodeStatus decompressAdaptiveSafe(const char* input,
+                                    size_t inputSize,
+                                    size_t itemsCount,
+                                    int64_t* data);
+
+DecodeStatus decompressAdaptiveSafe(const char* input,
+                                    size_t inputSize,
+                                    size_t itemsCount,
+                                    double* data);
+
+/*
+ Lossy compression of doubles, low mantissa bits of every value are zeroed within bound (see
+ precision.hpp) as the values are loaded, before the XOR with the previous row (no copy of data).
+ Output is read by decompress, the bound is not stored (framed variant below records it). Returns 0
+ (nothing written) if bound is not valid or capacity is less than maxCompressedSize(count).
+*/
+size_t compressLossy(const double* data,
+                     size_t count,
+                     char* output,
+                     size_t capacity,
+                     ErrorBound bound);
+
+// truncation alone, output may be data
+void truncatePrecision(const double* data, size_t count, double* output, ErrorBound bound);
+
+/*
+ Compressed data in memory owned by someone else (scratch buffer or memory resource)
+*/
+struct CompressedView {
+	const char* data;
+	size_t size;
+};
+
+/*
+ Allocation-free compressSimple for periodic flushes. Data are compressed into scratch, which only
+ grows (to maxCompressedSize of the longest series), so scratch reused across calls allocates
+ nothing in steady state. View is valid till the next use of scratch.
+*/
+CompressedView compressSimple(const int64_t* data, size_t count, std::vector<char>& scratch);
+
+CompressedView compressSimple(const double* data, size_t count, std::vector<char>& scratch);
+
+#if __cplusplus >= 201703L
+/*
+ As above, compressed data are then copied to an exact-size block of resource (e.g. an arena
+ released after the flush, std::pmr::monotonic_buffer_resource), freed by
+ resource->deallocate(view.data, view.size, 1) unless the resource releases all at once.
+*/
+CompressedView compressSimple(const int64_t* data,
+                              size_t count,
+                              std::vector<char>& scratch,
+                              std::pmr::memory_resource* resource);
+
+CompressedView compressSimple(const double* data,
+                              size_t count,
+                              std::vector<char>& scratch,
+                              std::pmr::memory_resource* resource);
+#endif
+
+/*
+ Integers transformed (see delta.hpp) as the rows are compressed, e.g. TRANSFORM_DELTA_OF_DELTA
+ for timestamps. Transform is not stored, decompress must get the same one (framed variants store
+ it). Transformed output has no checksum, decompressSafe validates it like the plain one.
+*/
+size_t compress(const int64_t* data,
+                size_t count,
+                char* output,
+                size_t capacity,
+                Transform transform);
+
+size_t compress(const uint64_t* data,
+                size_t count,
+                char* output,
+                size_t capacity,
+                Transform transform);
+
+void decompress(const char* input, size_t itemsCount, int64_t* data, Transform transform);
+
+void decompress(const char* input, size_t itemsCount, uint64_t* data, Transform transform);
+
+DecodeStatus decompressSafe(const char* input,
+                            size_t inputSize,
+                            size_t itemsCount,
+                            int64_t* data,
+                            Transform transform);
+
+DecodeStatus decompressSafe(const char* input,
+                            size_t inputSize,
+                            size_t itemsCount,
+                            uint64_t* data,
+                            Transform transform);
+
+/*
+ 32bit values use their own format of 16 middle-out segments, sized by maxCompressedSize32
+*/
+std::unique_ptr<std::vector<char>> compressSimple(std::vector<int32_t>& data);
+
+std::unique_ptr<std::vector<char>> compressSimple(std::vector<float>& data);
+
+size_t compress(std::vector<int32_t>& data, std::vector<char>& output);
+
+size_t compress(std::vector<float>& data, std::vector<char>& output);
+
+void decompress(std::vector<char>& input, size_t itemsCount, std::vector<int32_t>& data);
+
+void decompress(std::vector<char>& input, size_t itemsCount, std::vector<float>& data);
+
+size_t compress(const int32_t* data, size_t count, char* output, size_t capacity);
+
+size_t compress(const float* data, size_t count, char* output, size_t capacity);
+
+void decompress(const char* input, size_t itemsCount, int32_t* data);
+
+void decompress(const char* input, size_t itemsCount, float* data);
+
+/*
+ Multi-threaded variants for large arrays. Data are compressed in independent chunks of chunkSize
+ values (0 = 1M values) on a pool of threads (0 = one per CPU core). Output can be decompressed
+ only by decompressParallel.
+*/
+size_t maxCompressedSizeParallel(size_t count, size_t chunkSize = 0);
+
+size_t compressParallel(std::vector<int64_t>& data,
+                        std::vector<char>& output,
+                        size_t threads = 0,
+                        size_t chunkSize = 0);
+
+size_t compressParallel(std::vector<double>& data,
+                        std::vector<char>& output,
+                        size_t threads = 0,
+                        size_t chunkSize = 0);
+
+size_t compressParallel(const int64_t* data,
+                        size_t count,
+                        char* output,
+                        size_t capacity,
+                        size_t threads = 0,
+                        size_t chunkSize = 0);
+
+size_t compressParallel(const double* data,
+                        size_t count,
+                        char* output,
+                        size_t capacity,
+                        size_t threads = 0,
+                        size_t chunkSize = 0);
+
+void decompressParallel(std::vector<char>& input,
+                        size_t itemsCount,
+                        std::vector<int64_t>& data,
+                        size_t threads = 0);
+
+void decompressParallel(std::vector<char>& input,
+                        size_t itemsCount,
+                        std::vector<double>& data,
+                        size_t threads = 0);
+
+void decompressParallel(const char* input, size_t itemsCount, int64_t* data, size_t threads = 0);
+
+void decompressParallel(const char* input, size_t itemsCount, double* data, size_t threads = 0);
+
+/*
+ Many short series in one call (see batch.hpp). Series are compressed in groups of 8, one series per
+ SIMD lane, so short series share reference values and fill the rows. offsets receive the start of
+ each of batchGroupsCount(count) groups; decompression needs them and the lengths. compressBatch
+ returns 0 (nothing written) if capacity is less than maxCompressedSizeBatch(lengths, count).
+*/
+size_t batchGroupsCount(size_t count);
+
+size_t maxCompressedSizeBatch(const size_t* lengths, size_t count);
+
+size_t compressBatch(const int64_t* const* series,
+                     const size_t* lengths,
+                     size_t count,
+                     char* output,
+                     size_t capacity,
+                     size_t* offsets);
+
+size_t compressBatch(const double* const* series,
+                     const size_t* lengths,
+                     size_t count,
+                     char* output,
+                     size_t capacity,
+                     size_t* offsets);
+
+void decompressBatch(const char* input,
+                     const size_t* offsets,
+                     const size_t* lengths,
+                     size_t count,
+                     int64_t* const* series);
+
+void decompressBatch(const char* input,
+                     const size_t* offsets,
+                     const size_t* lengths,
+                     size_t count,
+                     double* const* series);
+
 size_t maxCompressedSize(size_t count);
 
+size_t maxCompressedSize32(size_t count);
+
+/*
+ Exact worst case size of compressed data, maxCompressedSize adds room for kernels' writes past the
+ data. compressBounded never writes past capacity and returns 0 if the data do not fit (output is
+ clobbered then), so output can be sized by the expected ratio and recompressed on failure.
+ Capacity of compressBound (compressBound32 for 32bit values) always suffices. Output of at least
+ maxCompressedSize is compressed by the kernel, smaller one by portable rows of codec.hpp: about 3x
+ slower than the AVX-512 kernel (1.4 vs 4.4 GB/s), no slower than the scalar one.
+*/
+size_t compressBound(size_t count);
+
+size_t compressBound32(size_t count);
+
+size_t compressBounded(const int64_t* data, size_t count, char* output, size_t capacity);
+
+size_t compressBounded(const double* data, size_t count, char* output, size_t capacity);
+
+size_t compressBounded(const int32_t* data, size_t count, char* output, size_t capacity);
+
+size_t compressBounded(const float* data, size_t count, char* output, size_t capacity);
+
+/*
+ Self-describing variants. Frame header holds element type, number of values and optionally
+ checksum of compressed data, so decompression needs neither itemsCount nor a pre-sized output.
+ Frame with row index (a checkpoint every indexInterval rows, e.g. FRAME_INDEX_INTERVAL) supports
+ fast random access. Integers can be delta transformed, the transform is recorded in the header.
+ compressFramed returns 0 (nothing written) if output is smaller than maxFramedSize(count,
+ indexInterval, transform).
+*/
+size_t maxFramedSize(size_t count, size_t indexInterval = 0, Transform transform = TRANSFORM_NONE);
+
+size_t compressFramed(std::vector<int64_t>& data,
+                      std::vector<char>& output,
+                      bool checksum = false,
+                      size_t indexInterval = 0,
+                      Transform transform = TRANSFORM_NONE);
+
+size_t compressFramed(std::vector<uint64_t>& data,
+                      std::vector<char>& output,
+                      bool checksum = false,
+                      size_t indexInterval = 0,
+                      Transform transform = TRANSFORM_NONE);
+
+size_t compressFramed(std::vector<double>& data,
+                      std::vector<char>& output,
+                      bool checksum = false,
+                      size_t indexInterval = 0);
+
+size_t compressFramed(const int64_t* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      bool checksum = false,
+                      size_t indexInterval = 0,
+                      Transform transform = TRANSFORM_NONE);
+
+size_t compressFramed(const uint64_t* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      bool checksum = false,
+                      size_t indexInterval = 0,
+                      Transform transform = TRANSFORM_NONE);
+
+size_t compressFramed(const double* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      bool checksum = false,
+                      size_t indexInterval = 0);
+
+// lossy frame, the bound is recorded in the header (see FrameInfo::errorBound)
+size_t compressFramed(const double* data,
+                      size_t count,
+                      char* output,
+                      size_t capacity,
+                      ErrorBound bound,
+                      bool checksum = false,
+                      size_t indexInterval = 0);
+
+/*
+ Parses frame header, returns false if input does not start with a valid frame
+*/
+bool readFrameInfo(const char* input, size_t inputSize, FrameInfo* info);
+
+/*
+ Decompress frame, data are resized to number of values in frame. Returns false (data untouched)
+ if frame is malformed, holds other type or checksum does not match.
+*/
+bool decompress(std::vector<char>& input, std::vector<int64_t>& data);
+
+bool decompress(std::vector<char>& input, std::vector<uint64_t>& data);
+
+bool decompress(std::vector<char>& input, std::vector<double>& data);
+
+/*
+ Decompress frame to caller owned memory of capacity values
+*/
+bool decompressFramed(const char* input, size_t inputSize, int64_t* data, size_t capacity);
+
+bool decompressFramed(const char* input, size_t inputSize, uint64_t* data, size_t capacity);
+
+bool decompressFramed(const char* input, size_t inputSize, double* data, size_t capacity);
+
+/*
+ Random access to frame: decompress values from (inclusive) to to (exclusive) or a single value,
+ decoding only rows from the nearest index checkpoint. Returns false if frame is malformed, holds
+ other type or range is out of bounds. Checksum is not verified, it covers the whole frame: index
+ and rows read are bounds-checked, a corrupted frame may give wrong values but is never read past.
+*/
+bool decompressRange(std::vector<char>& input, size_t from, size_t to, std::vector<int64_t>& data);
+
+bool decompressRange(std::vector<char>& input,
+                     size_t from,
+                     size_t to,
+                     std::vector<uint64_t>& data);
+
+bool decompressRange(std::vector<char>& input, size_t from, size_t to, std::vector<double>& data);
+
+bool decompressRange(const char* input, size_t inputSize, size_t from, size_t to, int64_t* data);
+
+bool decompressRange(const char* input, size_t inputSize, size_t from, size_t to, uint64_t* data);
+
+bool decompressRange(const char* input, size_t inputSize, size_t from, size_t to, double* data);
+
+bool get(const char* input, size_t inputSize, size_t index, int64_t* value);
+
+bool get(const char* input, size_t inputSize, size_t index, uint64_t* value);
+
+bool get(const char* input, size_t inputSize, size_t index, double* value);
+
+/*
+ Streams of values arriving one by one are compressed by StreamEncoder (stream.hpp) to a sequence
+ of frames, e.g. with the functions above as the kernel:
+
+	StreamEncoder<double> encoder(compress, [&](const char* frame, size_t length) { ... });
+	StreamDecoder<double> decoder(decompressSafe);
+*/
+
+/*
+ Name of the kernel used by functions above ("scalar", "avx2" or "avx512"). Kernel is picked by
+ CPUID on first use, MIDDLEOUT_KERNEL environment variable can force a kernel supported by the CPU.
+ 32bit values have no AVX2 kernel, the scalar one is used instead.
+*/
+const char* kernelName();
+
 }  // end namespace middleout
 
 #endif  // MIDDLEOUT_H_
\ No newline at end of file
@@ -0,0 +1,163 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "parallel.hpp"
+#include "scalar.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace middleout {
+
+template class Parallel<double>;
+template class Parallel<int64_t>;
+template class Parallel<uint64_t>;
+
+static size_t getChunkSize(size_t chunkSize) {
+	return chunkSize == 0 ? PARALLEL_CHUNK_SIZE : chunkSize;
+}
+
+static size_t getChunksCount(size_t count, size_t chunkSize) {
+	return (count + chunkSize - 1) / chunkSize;
+}
+
+static size_t getTableSize(size_t chunksCount) {
+	// chunk size + end of every chunk
+	return sizeof(uint64_t) * (1 + chunksCount);
+}
+
+static size_t getPoolSize(size_t threads, size_t chunksCount) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	// no idle threads
+	return std::max<size_t>(1, std::min(threads, chunksCount));
+}
+
+/*
+ Runs worker on a pool of threads, calling thread is one of them
+*/
+template <typename F>
+static void runOnPool(size_t poolSize, F worker) {
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < poolSize; i++) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : pool) {
+		thread.join();
+	}
+}
+
+template <typename T>
+size_t Parallel<T>::maxCompressedSize(size_t count, size_t chunkSize) {
+	chunkSize = getChunkSize(chunkSize);
+
+	size_t fullChunks = count / chunkSize;
+	size_t rest = count % chunkSize;
+
+	// all kernels share the format, so the max size too
+	size_t size = getTableSize(getChunksCount(count, chunkSize)) +
+	              fullChunks * Scalar<T>::maxCompressedSize(chunkSize);
+	if (rest != 0) {
+		size += Scalar<T>::maxCompressedSize(rest);
+	}
+	return size;
+}
+
+template <typename T>
+size_t Parallel<T>::compress(CompressFunction compress,
+                             const T* data,
+                             size_t count,
+                             char* output,
+                             size_t capacity,
+                             size_t threads,
+                             size_t chunkSize) {
+	chunkSize = getChunkSize(chunkSize);
+	if (capacity < maxCompressedSize(count, chunkSize)) {
+		// output could overflow
+		return 0;
+	}
+
+	size_t chunksCount = getChunksCount(count, chunkSize);
+	uint64_t* table = reinterpret_cast<uint64_t*>(output);
+	table[0] = chunkSize;
+	uint64_t* chunkEnds = table + 1;
+	char* chunksOutput = output + getTableSize(chunksCount);
+
+	// chunks are handed out in order
+	std::atomic<size_t> nextChunk(0);
+
+	// and placed to output in order, right after the previous one is placed
+	std::mutex placementMutex;
+	std::condition_variable placementChanged;
+	size_t placedChunks = 0;
+	size_t placedEnd = 0;
+
+	size_t scratchSize = Scalar<T>::maxCompressedSize(std::min(count, chunkSize));
+
+	runOnPool(getPoolSize(threads, chunksCount), [&]() {
+		// compressed size is not known in advance, chunk is compressed aside and copied then
+		std::unique_ptr<char[]> scratch(new char[scratchSize]);
+
+		for (size_t chunk = nextChunk++; chunk < chunksCount; chunk = nextChunk++) {
+			size_t from = chunk * chunkSize;
+			size_t chunkCount = std::min(chunkSize, count - from);
+			size_t length = compress(data + from, chunkCount, scratch.get(), scratchSize);
+
+			size_t offset;
+			{
+				// previous chunk is held by another worker, it can't wait for this one
+				std::unique_lock<std::mutex> lock(placementMutex);
+				placementChanged.wait(lock, [&]() { return placedChunks == chunk; });
+				offset = placedEnd;
+				placedEnd += length;
+				placedChunks++;
+			}
+			placementChanged.notify_all();
+
+			memcpy(chunksOutput + offset, scratch.get(), length);
+			chunkEnds[chunk] = offset + length;
+		}
+	});
+
+	return getTableSize(chunksCount) + placedEnd;
+}
+
+template <typename T>
+void Parallel<T>::decompress(DecompressFunction decompress,
+                             const char* input,
+                             size_t itemsCount,
+                             T* data,
+                             size_t threads) {
+	const uint64_t* table = reinterpret_cast<const uint64_t*>(input);
+	size_t chunkSize = table[0];
+	const uint64_t* chunkEnds = table + 1;
+
+	size_t chunksCount = getChunksCount(itemsCount, chunkSize);
+	const char* chunksInput = input + getTableSize(chunksCount);
+
+	std::atomic<size_t> nextChunk(0);
+
+	runOnPool(getPoolSize(threads, chunksCount), [&]() {
+		for (size_t chunk = nextChunk++; chunk < chunksCount; chunk = nextChunk++) {
+			size_t from = chunk * chunkSize;
+			size_t start = chunk == 0 ? 0 : chunkEnds[chunk - 1];
+			decompress(chunksInput + start, std::min(chunkSize, itemsCount - from), data + from);
+		}
+	});
+}
+
+}  // end namespace middleout
@@ -0,0 +1,65 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+namespace middleout {
+
+// default number of values in one independently compressed chunk (8 MB of 64bit values)
+const size_t PARALLEL_CHUNK_SIZE = 1 << 20;
+
+/*
+
+Multi-threaded compression of large arrays.
+
+Input is split into chunks of chunkSize values (the last one holds the rest), every chunk is
+compressed by a kernel on its own, with its own reference values. Compressed chunks are stored in
+order behind a chunk table:
+
+	uint64_t chunkSize
+	uint64_t chunkEnds[chunkCount]  // end of each compressed chunk, relative to the table end
+
+chunkCount is derived from itemsCount, so decompression of chunks can be fanned out as well.
+
+*/
+template <typename T>
+class Parallel {
+   public:
+	typedef size_t (*CompressFunction)(const T* data, size_t count, char* output, size_t capacity);
+	typedef void (*DecompressFunction)(const char* input, size_t itemsCount, T* data);
+
+	static size_t maxCompressedSize(size_t count, size_t chunkSize);
+
+	/*
+	 Compresses count values by kernel's compress on a pool of threads (0 = one per CPU core).
+	 Returns 0 (nothing written) if capacity is less than maxCompressedSize(count, chunkSize).
+	*/
+	static size_t compress(CompressFunction compress,
+	                       const T* data,
+	                       size_t count,
+	                       char* output,
+	                       size_t capacity,
+	                       size_t threads,
+	                       size_t chunkSize);
+
+	static void decompress(DecompressFunction decompress,
+	                       const char* input,
+	                       size_t itemsCount,
+	                       T* data,
+	                       size_t threads);
+};
+
+}  // end namespace middleout
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,106 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef PRECISION_H
+#define PRECISION_H
+
+namespace middleout {
+
+/*
+
+Optional lossy pre-transform of doubles, applied before middle-out compression.
+
+Measured values rarely carry 52 significant mantissa bits, yet the noise in their low bits makes
+XORs of consecutive values long. Low mantissa bits of every value are zeroed (truncated towards
+zero) as long as the value stays within the error bound, so XORs get long runs of trailing zeros.
+Absolute bound keeps |original - truncated| <= error, relative one keeps it <= error * |original|.
+Zeros, infinities and NaNs are kept as they are, subnormal values too under the relative bound.
+Truncation is idempotent, truncated data truncated again by the same bound do not change.
+
+*/
+enum ErrorBoundMode {
+	ERROR_BOUND_NONE = 0,
+	ERROR_BOUND_ABSOLUTE = 1,
+	ERROR_BOUND_RELATIVE = 2
+};
+
+struct ErrorBound {
+	ErrorBoundMode mode;
+	double error;  // ignored for ERROR_BOUND_NONE
+};
+
+const ErrorBound LOSSLESS = {ERROR_BOUND_NONE, 0};
+
+const int DOUBLE_MANTISSA_BITS = 52;
+const int DOUBLE_EXPONENT_BIAS = 1023;
+const uint64_t DOUBLE_EXPONENT_MASK = 0x7FF;
+
+// number of truncated bits which zeroes the whole magnitude (the sign is kept)
+const int TRUNCATED_MAGNITUDE = 63;
+
+static inline bool isValidErrorBound(ErrorBound bound) {
+	if (bound.mode == ERROR_BOUND_NONE) {
+		return true;
+	}
+	return (bound.mode == ERROR_BOUND_ABSOLUTE || bound.mode == ERROR_BOUND_RELATIVE) &&
+	       bound.error > 0 && std::isfinite(bound.error);
+}
+
+/*
+ Truncated bits count of every normal value (relative bound) or the base of it, biased exponent of
+ the value is subtracted (absolute bound). Bound must be valid.
+*/
+static inline int getTruncationBase(ErrorBound bound) {
+	switch (bound.mode) {
+		case ERROR_BOUND_ABSOLUTE:
+			// value of the lowest kept bit does not exceed the error
+			return std::ilogb(bound.error) + DOUBLE_EXPONENT_BIAS + DOUBLE_MANTISSA_BITS;
+		case ERROR_BOUND_RELATIVE:
+			return std::min(std::ilogb(bound.error) + DOUBLE_MANTISSA_BITS, DOUBLE_MANTISSA_BITS);
+		default:
+			return 0;
+	}
+}
+
+/*
+ Number of low bits of double (given by its bits) which can be zeroed, TRUNCATED_MAGNITUDE if the
+ whole magnitude can be
+*/
+static inline int getTruncatedBitsCount(uint64_t bits, ErrorBoundMode mode, int base) {
+	int exponent = (bits >> DOUBLE_MANTISSA_BITS) & DOUBLE_EXPONENT_MASK;
+	if (exponent == DOUBLE_EXPONENT_MASK || mode == ERROR_BOUND_NONE) {
+		// infinity or NaN
+		return 0;
+	}
+	if (mode == ERROR_BOUND_RELATIVE) {
+		return exponent == 0 ? 0 : std::max(base, 0);
+	}
+	// subnormal values have the exponent of the smallest normal ones
+	int truncated = base - std::max(exponent, 1);
+	if (truncated > DOUBLE_MANTISSA_BITS) {
+		return TRUNCATED_MAGNITUDE;
+	}
+	return std::max(truncated, 0);
+}
+
+/*
+ Bits of double with its low bits zeroed within the bound, base is getTruncationBase(bound)
+*/
+static inline uint64_t truncateBits(uint64_t bits, ErrorBoundMode mode, int base) {
+	return bits & ~0ULL << getTruncatedBitsCount(bits, mode, base);
+}
+
+}  // end namespace middleout
+
+#endif /* PRECISION_H */
@@ -33,27 +33,83 @@ std::unique_ptr<std::vector<char>> Scalar<T>::compressSimple(std::vector<T>& dat
 	return compressed;
 }
 
+template <typename T>
+size_t Scalar<T>::compress(std::vector<T>& data, std::vector<char>& output) {
+	return Scalar<T>::compress(data.data(), data.size(), output.data(), output.size());
+}
+
+template <typename T>
+void Scalar<T>::decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data) {
+	Scalar<T>::decompress(input.data(), itemsCount, data.data());
+}
+
 /*
 
 AVX 512 block compatible
 
 */
-template <typename T>
-size_t Scalar<T>::compress(std::vector<T>& data, std::vector<char>& output) {
-	if (data.size() <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+template <bool CHECKSUM, bool LOSSY, Transform TRANSFORM, typename T>
+static size_t compressData(const T* data,
+                           size_t count,
+                           char* output,
+                           size_t capacity,
+                           ErrorBound bound = LOSSLESS) {
+	static_assert(!(CHECKSUM && LOSSY), "Truncated values are not checksummed.");
+	static_assert(!CHECKSUM || TRANSFORM == TRANSFORM_NONE,
+	              "Transformed values are not checksummed.");
+	static_assert(!LOSSY || TRANSFORM == TRANSFORM_NONE, "Truncated values are not transformed.");
+	// rows are truncated or transformed as they are loaded
+	constexpr bool LOADED = LOSSY || TRANSFORM != TRANSFORM_NONE;
+
+	if (capacity < Scalar<T>::maxCompressedSize(count)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
 		// not enough data to compress
-		return doNotCompressTheData(data, output);
+		if (LOSSY) {
+			Scalar<T>::truncatePrecision(data, count, reinterpret_cast<T*>(output), bound);
+			return sizeof(T) * count;
+		}
+		return doNotCompressTheData(data, count, output);
 	}
 
 	// skip first 8 init values
 	size_t outputIndex = sizeof(int64_t) * VECTOR_SIZE;
 	// "middle-out" data block size
-	size_t blockSize = data.size() / VECTOR_SIZE;
+	size_t blockSize = count / VECTOR_SIZE;
 	// just copy init reference values
 	fillStart(data, output, blockSize);
 
+	// lossy values are truncated as they are loaded, XORed with the previous truncated row
+	int truncationBase = getTruncationBase(bound);
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, output, sizeof(row));
+	// integers are transformed as they are loaded, reference values are kept
+	uint64_t values[VECTOR_SIZE];
+	uint64_t deltas[VECTOR_SIZE] = {0};
+	memcpy(values, row, sizeof(values));
+	if (LOSSY) {
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			row[j] = truncateBits(row[j], bound.mode, truncationBase);
+		}
+		memcpy(output, row, sizeof(row));
+	}
+
+	// checksum of values by rows, reference values are the row 0
+	RowHash hash;
+	if (CHECKSUM) {
+		initRowHash(&hash);
+		hashRow(&hash, row);
+	}
+
 	// main compression loop
 	for (size_t i = 1; i < blockSize; i += 1) {
+		if ((i & 7) == 0) {
+			prefetchRows<PREFETCH_READ>(data, blockSize, i);
+		}
+
 		uint8_t sameMask = 0;  // bit mask if current value is same as previous one
 		int maxLength = 0;     // max (within 8 values) length of compressed value in bytes
 
@@ -72,12 +128,29 @@ size_t Scalar<T>::compress(std::vector<T>& data, std::vector<char>& output) {
 		uint32_t offsetsShift = 3;  // skip 3 bits for max length
 		int notSameCount = 0;
 
+		// truncated or transformed row, previous one is in row
+		uint64_t loaded[VECTOR_SIZE];
+		if (LOADED) {
+			for (size_t j = 0; j < VECTOR_SIZE; j++) {
+				loaded[j] = reinterpret_cast<const uint64_t&>(data[blockSize * j + i]);
+			}
+		}
+		if (LOSSY) {
+			for (size_t j = 0; j < VECTOR_SIZE; j++) {
+				loaded[j] = truncateBits(loaded[j], bound.mode, truncationBase);
+			}
+		}
+		if (TRANSFORM != TRANSFORM_NONE) {
+			encodeDeltaRow(loaded, values, deltas, TRANSFORM);
+		}
+
 		for (size_t j = 0; j < VECTOR_SIZE; j++) {
 			// offset within input vector
 			size_t offset = blockSize * j + i;
 			// previous value - used for xor
-			int64_t prev = reinterpret_cast<uint64_t&>(data[offset - 1]);
-			int64_t curr = reinterpret_cast<uint64_t&>(data[offset]);
+			int64_t prev = LOADED ? row[j] : reinterpret_cast<const uint64_t&>(data[offset - 1]);
+			int64_t curr = LOADED ? loaded[j] : reinterpret_cast<const uint64_t&>(data[offset]);
+			row[j] = curr;
 
 			// xore current value with previous
 			int64_t xored = prev xor curr;
@@ -114,6 +187,9 @@ size_t Scalar<T>::compress(std::vector<T>& data, std::vector<char>& output) {
 			// write value to tmp array aligned to right
 			xoredShifted[j] = xored >> rightOffsetBits;
 		}
+		if (CHECKSUM) {
+			hashRow(&hash, row);
+		}
 
 		output[outputIndex++] = sameMask;
 
@@ -143,38 +219,106 @@ size_t Scalar<T>::compress(std::vector<T>& data, std::vector<char>& output) {
 	}
 
 	// write rest of the data without any compression
-	for (size_t i = blockSize * VECTOR_SIZE; i < data.size(); i++) {
+	for (size_t i = blockSize * VECTOR_SIZE; i < count; i++) {
 		T* outAsLongs = reinterpret_cast<T*>(&output[outputIndex]);
 		outAsLongs[0] = data[i];
 		outputIndex += sizeof(T);
 	}
+	if (LOSSY) {
+		size_t restCount = count - blockSize * VECTOR_SIZE;
+		T* rest = reinterpret_cast<T*>(&output[outputIndex - sizeof(T) * restCount]);
+		Scalar<T>::truncatePrecision(rest, restCount, rest, bound);
+	}
 
-	// write compress algorithm version and datatype constant
-	output[outputIndex++] = 0x7E;  //== 0b01111110
+	if (CHECKSUM) {
+		uint32_t checksum =
+		    finishRowHash(hash.accumulators, &data[blockSize * VECTOR_SIZE], count);
+		return writeChecksumTrailer(output, outputIndex, checksum);
+	}
+	return writeTrailer(output, outputIndex);
+}
+
+template <typename T>
+size_t Scalar<T>::compress(const T* data, size_t count, char* output, size_t capacity) {
+	return compressData<false, false, TRANSFORM_NONE>(data, count, output, capacity);
+}
 
-	// to avoid access to invalid memory on decompression
-	return outputIndex + 6;
+template <typename T>
+size_t Scalar<T>::compressChecksummed(const T* data, size_t count, char* output, size_t capacity) {
+	return compressData<true, false, TRANSFORM_NONE>(data, count, output, capacity);
+}
+
+template <typename T>
+size_t Scalar<T>::compressLossy(const T* data,
+                                size_t count,
+                                char* output,
+                                size_t capacity,
+                                ErrorBound bound) {
+	if (!isValidErrorBound(bound)) {
+		return 0;
+	}
+	return compressData<false, true, TRANSFORM_NONE>(data, count, output, capacity, bound);
+}
+
+template <typename T>
+size_t Scalar<T>::compressTransformed(const T* data,
+                                      size_t count,
+                                      char* output,
+                                      size_t capacity,
+                                      Transform transform) {
+	switch (transform) {
+		case TRANSFORM_DELTA:
+			return compressData<false, false, TRANSFORM_DELTA>(data, count, output, capacity);
+		case TRANSFORM_DELTA_OF_DELTA:
+			return compressData<false, false, TRANSFORM_DELTA_OF_DELTA>(data, count, output,
+			                                                            capacity);
+		default:
+			return compress(data, count, output, capacity);
+	}
 }
 
 //
 // DECOMPRESSION
 //
 
-template <typename T>
-inline void decompressValue(const size_t j,
-                            const long blockSize,
-                            std::vector<char>& input,
-                            std::vector<T>& data,
-                            uint64_t clearTopBitMask,
-                            size_t* inputIndex,
-                            const long i,
-                            int* offsetsShift,
-                            uint8_t maxLength,
-                            uint32_t compresedOffsets,
-                            uint8_t sameMask) {
+/*
+ Hashes decompressed row blockIndex, values are read back from data (row holds them if stored
+ non-temporally)
+*/
+template <bool NON_TEMPORAL, typename T>
+static inline void hashDecompressedRow(RowHash* hash,
+                                       const T* data,
+                                       uint64_t* row,
+                                       size_t blockSize,
+                                       size_t blockIndex) {
+	if (!NON_TEMPORAL) {
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			memcpy(&row[j], &data[blockSize * j + blockIndex], sizeof(uint64_t));
+		}
+	}
+	hashRow(hash, row);
+}
+
+/*
+ IN_ROW variant keeps the previous row in row and does not touch data (values stored
+ non-temporally are not read back, aggregated ones are not stored at all)
+*/
+template <bool IN_ROW, typename T>
+static inline void decompressValue(const size_t j,
+                                   const long blockSize,
+                                   const char* input,
+                                   T* data,
+                                   uint64_t* row,
+                                   uint64_t clearTopBitMask,
+                                   size_t* inputIndex,
+                                   const long i,
+                                   int* offsetsShift,
+                                   uint8_t maxLength,
+                                   uint32_t compresedOffsets,
+                                   uint8_t sameMask) {
 	// middle-out offset
 	size_t offset = blockSize * j + i;
-	uint64_t prev = reinterpret_cast<uint64_t&>(data[offset - 1]);
+	uint64_t prev = IN_ROW ? row[j] : reinterpret_cast<uint64_t&>(data[offset - 1]);
 
 	// get number of bits to shift xored data block
 	// - shift to get current's block offset:   >> offsetsShift
@@ -183,7 +327,7 @@ inline void decompressValue(const size_t j,
 	int shiftBits = ((compresedOffsets >> *offsetsShift) & 0b111) * 8;
 
 	// get data from unaligned possition
-	uint64_t toXor = reinterpret_cast<uint64_t*>(&input[*inputIndex])[0];
+	uint64_t toXor = reinterpret_cast<const uint64_t*>(&input[*inputIndex])[0];
 
 	// clear unused bytes
 	toXor &= clearTopBitMask;
@@ -221,19 +365,24 @@ inline void decompressValue(const size_t j,
 	    : "cc"                                          // cmpl instructions sets cc flags
 	    );
 
-	// write final data
-	data[offset] = reinterpret_cast<T&>(prev);
+	// write final data (rows kept in row are streamed by tiles or aggregated)
+	if (IN_ROW) {
+		row[j] = prev;
+	} else {
+		data[offset] = reinterpret_cast<T&>(prev);
+	}
 	// these assignments are optimized by compiler (happens in inline asm)
 	*inputIndex = newInputIndex;
 	*offsetsShift = newOffsetsShift;
 }
 
-template <bool CECK_FOR_ALL_SAME, typename T>
-inline void decompressBlock(std::vector<char>& input,
-                            std::vector<T>& data,
-                            size_t* inputIndex,
-                            const long blockSize,
-                            const long i) {
+template <bool CECK_FOR_ALL_SAME, bool IN_ROW, typename T>
+static inline void decompressBlock(const char* input,
+                                   T* data,
+                                   uint64_t* row,
+                                   size_t* inputIndex,
+                                   const long blockSize,
+                                   const long i) {
 	// read mask of same values
 	uint8_t sameMask = input[(*inputIndex)++];
 	size_t startInputIndex = *inputIndex;
@@ -242,8 +391,8 @@ inline void decompressBlock(std::vector<char>& input,
 	// checking is for preventing access to unallocated data
 	if (CECK_FOR_ALL_SAME) {
 		if (sameMask == 0b11111111) {
-			// just copy prev values
-			for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			// just copy prev values (row already holds them if IN_ROW)
+			for (size_t j = 0; j < VECTOR_SIZE && !IN_ROW; j++) {
 				size_t offset = blockSize * j + i;
 				data[offset] = data[offset - 1];
 			}
@@ -252,7 +401,8 @@ inline void decompressBlock(std::vector<char>& input,
 	}
 
 	// read unaligned offsets
-	uint32_t compresedOffsetsAndMaxLength = reinterpret_cast<uint32_t*>(&input[*inputIndex])[0];
+	uint32_t compresedOffsetsAndMaxLength =
+	    reinterpret_cast<const uint32_t*>(&input[*inputIndex])[0];
 	// +1 because only 3 bits are stored and valid lengths are 1-8
 	uint8_t maxLength = (compresedOffsetsAndMaxLength & 0b111) + 1;
 
@@ -267,9 +417,9 @@ inline void decompressBlock(std::vector<char>& input,
 	uint64_t clearTopBitMask = ~((uint64_t)0) >> (64 - 8 * maxLength);
 
 // manual unroll, some compilers do not like inline asm in body of loop for unroll
-#define CALL_DECOMPRESS_VALUE(POSITION)                                               \
-	decompressValue(POSITION, blockSize, input, data, clearTopBitMask, inputIndex, i, \
-	                &offsetsShift, maxLength, compresedOffsetsAndMaxLength, sameMask);
+#define CALL_DECOMPRESS_VALUE(POSITION)                                                            \
+	decompressValue<IN_ROW>(POSITION, blockSize, input, data, row, clearTopBitMask, inputIndex, i, \
+	                        &offsetsShift, maxLength, compresedOffsetsAndMaxLength, sameMask);
 
 	CALL_DECOMPRESS_VALUE(0)
 	CALL_DECOMPRESS_VALUE(1)
@@ -296,40 +446,546 @@ inline void decompressBlock(std::vector<char>& input,
 	*inputIndex = inputIndexFinal;
 }
 
-template <typename T>
-void Scalar<T>::decompress(std::vector<char>& input, size_t inputElements, std::vector<T>& data) {
+/*
+ Stores row of transformed values (kept in row) reverted by decodeDeltaRow, values and deltas hold
+ the state of the previous rows. Non-temporal rows are streamed by caller.
+*/
+template <Transform TRANSFORM, bool NON_TEMPORAL, typename T>
+static inline void storeDecodedRow(const uint64_t* row,
+                                   uint64_t* values,
+                                   uint64_t* deltas,
+                                   T* data,
+                                   size_t blockSize,
+                                   size_t blockIndex) {
+	if (TRANSFORM == TRANSFORM_NONE) {
+		return;
+	}
+	decodeDeltaRow(row, values, deltas, TRANSFORM);
+	for (size_t j = 0; j < VECTOR_SIZE && !NON_TEMPORAL; j++) {
+		memcpy(&data[blockSize * j + blockIndex], &values[j], sizeof(T));
+	}
+}
+
+/*
+ Returns position of the trailer, values are hashed to hash if CHECKSUM is set. Transformed rows
+ are reverted while decoding.
+*/
+template <bool NON_TEMPORAL, bool CHECKSUM, Transform TRANSFORM, typename T>
+static size_t decompressData(const char* input, size_t inputElements, T* data, RowHash* hash) {
+	static_assert(!CHECKSUM || TRANSFORM == TRANSFORM_NONE,
+	              "Transformed values are not checksummed.");
+	// transformed rows are kept in row, data hold the reverted values
+	constexpr bool IN_ROW = NON_TEMPORAL || TRANSFORM != TRANSFORM_NONE;
+
 	// not enough data to compress
 	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
-		return doNotDecompressTheData(input, inputElements, data);
+		doNotDecompressTheData(input, inputElements, data);
+		return sizeof(T) * inputElements;
 	}
 
 	// middle-out block size
 	long blockSize = inputElements / VECTOR_SIZE;
 	// copy first ref. values
+	uint64_t row[VECTOR_SIZE];
 	for (size_t i = 0; i < VECTOR_SIZE; i++) {
-		data[blockSize * i] = (reinterpret_cast<T*>(input.data()))[i];
+		data[blockSize * i] = (reinterpret_cast<const T*>(input))[i];
+		row[i] = (reinterpret_cast<const uint64_t*>(input))[i];
 	}
 
 	// skip first 8 init values
 	size_t inputIndex = sizeof(int64_t) * VECTOR_SIZE;
+	if (CHECKSUM) {
+		hashRow(hash, row);
+	}
+
+	// reverse transform state, reference values are kept
+	uint64_t values[VECTOR_SIZE];
+	uint64_t deltas[VECTOR_SIZE] = {0};
+	memcpy(values, row, sizeof(values));
+	const uint64_t* decoded = TRANSFORM == TRANSFORM_NONE ? row : values;
+
+	// rows collected for non-temporal stores
+	uint64_t tile[VECTOR_SIZE][VECTOR_SIZE];
+	size_t tileRows = 0;
 
 	// main decompression loop
 	long blockIndex = 1;
 	// boundary check for last 5 values (there potentially could be 5 bytes read ahead, that means
 	// max 5 blocks of data)
 	for (; blockIndex < blockSize - 5; blockIndex++) {
-		decompressBlock<false>(input, data, &inputIndex, blockSize, blockIndex);
+		// non-temporal stores do not need the lines in cache
+		if (!NON_TEMPORAL && (blockIndex & 7) == 0) {
+			prefetchRows<PREFETCH_WRITE>(data, blockSize, blockIndex);
+		}
+		decompressBlock<false, IN_ROW>(input, data, row, &inputIndex, blockSize, blockIndex);
+		storeDecodedRow<TRANSFORM, NON_TEMPORAL>(row, values, deltas, data, blockSize, blockIndex);
+		if (CHECKSUM) {
+			hashDecompressedRow<NON_TEMPORAL>(hash, data, row, blockSize, blockIndex);
+		}
+		if (NON_TEMPORAL) {
+			streamRow(data, blockSize, blockIndex, decoded, tile, &tileRows);
+		}
 	}
 	for (; blockIndex < blockSize; blockIndex++) {
 		// decompress last 5 blocks with boundary check (skip code if all elements are the same)
-		decompressBlock<true>(input, data, &inputIndex, blockSize, blockIndex);
+		decompressBlock<true, IN_ROW>(input, data, row, &inputIndex, blockSize, blockIndex);
+		storeDecodedRow<TRANSFORM, NON_TEMPORAL>(row, values, deltas, data, blockSize, blockIndex);
+		if (CHECKSUM) {
+			hashDecompressedRow<NON_TEMPORAL>(hash, data, row, blockSize, blockIndex);
+		}
+		if (NON_TEMPORAL) {
+			streamRow(data, blockSize, blockIndex, decoded, tile, &tileRows);
+		}
 	}
 
 	// copy rest of data (uncompressed)
 	for (size_t i = blockSize * VECTOR_SIZE; i < inputElements; i++) {
-		data[i] = (reinterpret_cast<T*>(&input[inputIndex]))[0];
+		data[i] = (reinterpret_cast<const T*>(&input[inputIndex]))[0];
 		inputIndex += sizeof(int64_t);
 	}
+	return inputIndex;
+}
+
+template <typename T>
+void Scalar<T>::decompress(const char* input, size_t inputElements, T* data) {
+	decompressData<false, false, TRANSFORM_NONE>(input, inputElements, data, NULL);
+}
+
+template <typename T>
+void Scalar<T>::decompressNonTemporal(const char* input, size_t inputElements, T* data) {
+	decompressData<true, false, TRANSFORM_NONE>(input, inputElements, data, NULL);
+	_mm_sfence();
+}
+
+template <typename T>
+void Scalar<T>::decompressTransformed(const char* input,
+                                      size_t inputElements,
+                                      T* data,
+                                      Transform transform) {
+	switch (transform) {
+		case TRANSFORM_DELTA:
+			decompressData<false, false, TRANSFORM_DELTA>(input, inputElements, data, NULL);
+			break;
+		case TRANSFORM_DELTA_OF_DELTA:
+			decompressData<false, false, TRANSFORM_DELTA_OF_DELTA>(input, inputElements, data,
+			                                                       NULL);
+			break;
+		default:
+			decompress(input, inputElements, data);
+	}
+}
+
+template <typename T>
+DecodeStatus Scalar<T>::decompressVerified(const char* input, size_t inputElements, T* data) {
+	RowHash hash;
+	initRowHash(&hash);
+	size_t trailerIndex =
+	    decompressData<false, true, TRANSFORM_NONE>(input, inputElements, data, &hash);
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		// stored uncompressed, without checksum
+		return DECODE_OK;
+	}
+	return verifyChecksum(&input[trailerIndex], hash.accumulators, data, inputElements);
+}
+
+/*
+ Values are hashed and verified if CHECKSUM is set, transformed rows are reverted
+*/
+template <bool CHECKSUM, Transform TRANSFORM, typename T>
+static DecodeStatus decompressSafeData(const char* input,
+                                       size_t inputSize,
+                                       size_t inputElements,
+                                       T* data) {
+	static_assert(!CHECKSUM || TRANSFORM == TRANSFORM_NONE,
+	              "Transformed values are not checksummed.");
+	constexpr bool IN_ROW = TRANSFORM != TRANSFORM_NONE;
+	long blockSize = inputElements / VECTOR_SIZE;
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, input, sizeof(row));
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		data[blockSize * j] = reinterpret_cast<T&>(row[j]);
+	}
+	size_t inputIndex = sizeof(row);
+	size_t rowsEnd = getRowsEnd(inputSize, inputElements);
+
+	RowHash hash;
+	if (CHECKSUM) {
+		initRowHash(&hash);
+		hashRow(&hash, row);
+	}
+	uint64_t values[VECTOR_SIZE];
+	uint64_t deltas[VECTOR_SIZE] = {0};
+	memcpy(values, row, sizeof(values));
+
+	// longest row and its read-ahead fit in front of rowsEnd (plus the trailer)
+	long blockIndex = 1;
+	for (; blockIndex < blockSize && inputIndex + MAX_ROW_LENGTH <= rowsEnd; blockIndex++) {
+		if ((blockIndex & 7) == 0) {
+			prefetchRows<PREFETCH_WRITE>(data, blockSize, blockIndex);
+		}
+		decompressBlock<false, IN_ROW>(input, data, row, &inputIndex, blockSize, blockIndex);
+		storeDecodedRow<TRANSFORM, false>(row, values, deltas, data, blockSize, blockIndex);
+		if (CHECKSUM) {
+			hashDecompressedRow<false>(&hash, data, row, blockSize, blockIndex);
+		}
+	}
+	for (; blockIndex < blockSize; blockIndex++) {
+		char padded[MAX_ROW_LENGTH + ROW_READ_AHEAD];
+		size_t length = padRow(&input[inputIndex], rowsEnd - inputIndex, padded);
+		if (length == 0) {
+			return DECODE_MALFORMED;
+		}
+		size_t paddedIndex = 0;
+		decompressBlock<false, IN_ROW>(padded, data, row, &paddedIndex, blockSize, blockIndex);
+		storeDecodedRow<TRANSFORM, false>(row, values, deltas, data, blockSize, blockIndex);
+		if (CHECKSUM) {
+			hashDecompressedRow<false>(&hash, data, row, blockSize, blockIndex);
+		}
+		inputIndex += length;
+	}
+
+	return decompressSafeRest(input, inputIndex, inputSize, inputElements, data,
+	                          CHECKSUM ? hash.accumulators : NULL);
+}
+
+template <typename T>
+DecodeStatus Scalar<T>::decompressSafe(const char* input,
+                                       size_t inputSize,
+                                       size_t inputElements,
+                                       T* data) {
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return decompressSafeUncompressed(input, inputSize, inputElements, data);
+	}
+	if (inputSize < getMinCompressedSize(inputElements)) {
+		return DECODE_TRUNCATED;
+	}
+
+	if (hasChecksum(input, inputSize)) {
+		return decompressSafeData<true, TRANSFORM_NONE>(input, inputSize, inputElements, data);
+	}
+	return decompressSafeData<false, TRANSFORM_NONE>(input, inputSize, inputElements, data);
+}
+
+template <typename T>
+DecodeStatus Scalar<T>::decompressSafeTransformed(const char* input,
+                                                  size_t inputSize,
+                                                  size_t inputElements,
+                                                  T* data,
+                                                  Transform transform) {
+	if (transform == TRANSFORM_NONE || inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return decompressSafe(input, inputSize, inputElements, data);
+	}
+	if (inputSize < getMinCompressedSize(inputElements)) {
+		return DECODE_TRUNCATED;
+	}
+	// transformed values are not checksummed, the trailer has to be plain
+	if (hasChecksum(input, inputSize)) {
+		return DECODE_MALFORMED;
+	}
+	if (transform == TRANSFORM_DELTA) {
+		return decompressSafeData<false, TRANSFORM_DELTA>(input, inputSize, inputElements, data);
+	}
+	return decompressSafeData<false, TRANSFORM_DELTA_OF_DELTA>(input, inputSize, inputElements,
+	                                                           data);
+}
+
+//
+// ADAPTIVE ROWS
+//
+
+template <typename T>
+size_t Scalar<T>::compressAdaptive(const T* data, size_t count, char* output, size_t capacity) {
+	if (capacity < maxCompressedSize(count)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		// not enough data to compress
+		return doNotCompressTheData(data, count, output);
+	}
+
+	size_t blockSize = count / VECTOR_SIZE;
+	fillStart(data, output, blockSize);
+	size_t outputIndex = sizeof(T) * VECTOR_SIZE;
+
+	uint64_t prev[VECTOR_SIZE];
+	memcpy(prev, output, sizeof(prev));
+	size_t unchangedRows = 0;
+
+	for (size_t i = 1; i < blockSize; i++) {
+		if ((i & 7) == 0) {
+			prefetchRows<PREFETCH_READ>(data, blockSize, i);
+		}
+
+		uint64_t curr[VECTOR_SIZE];
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			curr[j] = reinterpret_cast<const uint64_t&>(data[blockSize * j + i]);
+		}
+		outputIndex += compressAdaptiveRow(prev, curr, &output[outputIndex], &unchangedRows);
+		memcpy(prev, curr, sizeof(prev));
+	}
+	outputIndex += writeUnchangedRows(&output[outputIndex], unchangedRows);
+
+	// write rest of the data without any compression
+	for (size_t i = blockSize * VECTOR_SIZE; i < count; i++) {
+		memcpy(&output[outputIndex], &data[i], sizeof(T));
+		outputIndex += sizeof(T);
+	}
+
+	return writeTrailer(output, outputIndex);
+}
+
+/*
+ Stores decompressed row to its segments at blockIndex, a run of unchanged rows fills segments by
+ their last value
+*/
+template <typename T>
+static inline void storeAdaptiveRows(const uint64_t* row,
+                                     T* data,
+                                     size_t blockSize,
+                                     size_t blockIndex,
+                                     size_t rows) {
+	if (rows == 1) {
+		for (size_t j = 0; j < VECTOR_SIZE; j++) {
+			data[blockSize * j + blockIndex] = reinterpret_cast<const T&>(row[j]);
+		}
+		return;
+	}
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		std::fill_n(&data[blockSize * j + blockIndex], rows, reinterpret_cast<const T&>(row[j]));
+	}
+}
+
+template <typename T>
+void Scalar<T>::decompressAdaptive(const char* input, size_t inputElements, T* data) {
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		// not enough data to compress
+		return doNotDecompressTheData(input, inputElements, data);
+	}
+
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, input, sizeof(row));
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		data[blockSize * j] = reinterpret_cast<T&>(row[j]);
+	}
+	size_t inputIndex = sizeof(row);
+
+	size_t rows;
+	for (size_t i = 1; i < blockSize; i += rows) {
+		if ((i & 7) == 0) {
+			prefetchRows<PREFETCH_WRITE>(data, blockSize, i);
+		}
+
+		inputIndex += decompressAdaptiveRow(&input[inputIndex], row, blockSize - i, &rows);
+		storeAdaptiveRows(row, data, blockSize, i, rows);
+	}
+
+	// copy rest of data (uncompressed)
+	memcpy(&data[blockSize * VECTOR_SIZE], &input[inputIndex],
+	       sizeof(T) * (inputElements - blockSize * VECTOR_SIZE));
+}
+
+template <typename T>
+DecodeStatus Scalar<T>::decompressAdaptiveSafe(const char* input,
+                                               size_t inputSize,
+                                               size_t inputElements,
+                                               T* data) {
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return decompressSafeUncompressed(input, inputSize, inputElements, data);
+	}
+	if (inputSize < getMinAdaptiveSize(inputElements)) {
+		return DECODE_TRUNCATED;
+	}
+
+	size_t blockSize = inputElements / VECTOR_SIZE;
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, input, sizeof(row));
+	for (size_t j = 0; j < VECTOR_SIZE; j++) {
+		data[blockSize * j] = reinterpret_cast<T&>(row[j]);
+	}
+	size_t inputIndex = sizeof(row);
+	size_t rowsEnd = getRowsEnd(inputSize, inputElements);
+
+	size_t rows;
+	for (size_t i = 1; i < blockSize; i += rows) {
+		// the longest row and its read-ahead fit in input, the last rows are decoded from a padded
+		// copy
+		const char* rowInput = &input[inputIndex];
+		char padded[MAX_ADAPTIVE_ROW_LENGTH + ADAPTIVE_READ_AHEAD];
+		if (inputIndex + sizeof(padded) > inputSize) {
+			size_t size = std::min(rowsEnd - inputIndex, MAX_ADAPTIVE_ROW_LENGTH);
+			memcpy(padded, rowInput, size);
+			memset(&padded[size], 0, sizeof(padded) - size);
+			rowInput = padded;
+		}
+
+		size_t length = decompressAdaptiveRow(rowInput, row, blockSize - i, &rows);
+		if (length == 0 || length > rowsEnd - inputIndex || isCorruptedLeadingRow(rowInput)) {
+			return DECODE_MALFORMED;
+		}
+		inputIndex += length;
+		storeAdaptiveRows(row, data, blockSize, i, rows);
+	}
+
+	return decompressSafeRest(input, inputIndex, inputSize, inputElements, data, NULL);
+}
+
+//
+// AGGREGATION
+//
+
+template <typename T>
+void Scalar<T>::decompressAggregates(const char* input,
+                                     size_t inputElements,
+                                     Aggregates<T>* aggregates) {
+	initAggregates(aggregates, inputElements);
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		aggregateValues(input, inputElements, aggregates);
+		return;
+	}
+
+	// rows are kept in row only, nothing is stored
+	long blockSize = inputElements / VECTOR_SIZE;
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, input, sizeof(row));
+	LaneAggregates<T> lanes;
+	initLanes(&lanes);
+	aggregateRow(&lanes, row, false);
+
+	size_t inputIndex = sizeof(row);
+	long blockIndex = 1;
+	for (; blockIndex < blockSize - 5; blockIndex++) {
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		decompressBlock<false, true>(input, (T*)NULL, row, &inputIndex, blockSize, blockIndex);
+		aggregateRow(&lanes, row, unchanged);
+	}
+	for (; blockIndex < blockSize; blockIndex++) {
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		decompressBlock<true, true>(input, (T*)NULL, row, &inputIndex, blockSize, blockIndex);
+		aggregateRow(&lanes, row, unchanged);
+	}
+
+	mergeLanes(&lanes, aggregates);
+	aggregateValues(&input[inputIndex], inputElements % VECTOR_SIZE, aggregates);
+}
+
+template <ScanPredicate PREDICATE, typename T>
+static size_t scanData(const char* input, size_t inputElements, T threshold, uint64_t* bitmap) {
+	memset(bitmap, 0, sizeof(uint64_t) * scanBitmapWords(inputElements));
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		return scanValues<PREDICATE>(input, inputElements, threshold, bitmap, 0);
+	}
+
+	// rows are kept in row only, nothing is stored
+	long blockSize = inputElements / VECTOR_SIZE;
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, input, sizeof(row));
+	uint8_t mask = matchRow<PREDICATE>(row, threshold);
+	RowMasks rows = {0, 0};
+	addRowMask(&rows, bitmap, blockSize, 0, mask);
+
+	size_t inputIndex = sizeof(row);
+	long blockIndex = 1;
+	for (; blockIndex < blockSize - 5; blockIndex++) {
+		// unchanged row keeps the mask of the previous one
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		decompressBlock<false, true>(input, (T*)NULL, row, &inputIndex, blockSize, blockIndex);
+		mask = unchanged ? mask : matchRow<PREDICATE>(row, threshold);
+		addRowMask(&rows, bitmap, blockSize, blockIndex, mask);
+	}
+	for (; blockIndex < blockSize; blockIndex++) {
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		decompressBlock<true, true>(input, (T*)NULL, row, &inputIndex, blockSize, blockIndex);
+		mask = unchanged ? mask : matchRow<PREDICATE>(row, threshold);
+		addRowMask(&rows, bitmap, blockSize, blockIndex, mask);
+	}
+
+	size_t matching = finishRowMasks(&rows, bitmap, blockSize);
+	return matching + scanValues<PREDICATE>(&input[inputIndex], inputElements % VECTOR_SIZE,
+	                                        threshold, bitmap, blockSize * VECTOR_SIZE);
+}
+
+template <typename T>
+size_t Scalar<T>::scan(const char* input,
+                       size_t inputElements,
+                       ScanPredicate predicate,
+                       T threshold,
+                       uint64_t* bitmap) {
+	switch (predicate) {
+		case SCAN_LESS:
+			return scanData<SCAN_LESS>(input, inputElements, threshold, bitmap);
+		case SCAN_LESS_EQUAL:
+			return scanData<SCAN_LESS_EQUAL>(input, inputElements, threshold, bitmap);
+		case SCAN_GREATER:
+			return scanData<SCAN_GREATER>(input, inputElements, threshold, bitmap);
+		case SCAN_GREATER_EQUAL:
+			return scanData<SCAN_GREATER_EQUAL>(input, inputElements, threshold, bitmap);
+		case SCAN_EQUAL:
+			return scanData<SCAN_EQUAL>(input, inputElements, threshold, bitmap);
+		default:
+			return scanData<SCAN_NOT_EQUAL>(input, inputElements, threshold, bitmap);
+	}
+}
+
+template <typename T>
+size_t Scalar<T>::decompressBuckets(const char* input,
+                                    size_t inputElements,
+                                    size_t bucketWidth,
+                                    Bucket<T>* buckets) {
+	if (bucketWidth == 0) {
+		return 0;
+	}
+	size_t bucketsCount = getBucketsCount(inputElements, bucketWidth);
+	for (size_t i = 0; i < bucketsCount; i++) {
+		initBucket(&buckets[i]);
+	}
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD) {
+		bucketValues(input, inputElements, bucketWidth, buckets, 0);
+		return bucketsCount;
+	}
+
+	// rows are kept in row only, nothing is stored
+	long blockSize = inputElements / VECTOR_SIZE;
+	uint64_t row[VECTOR_SIZE];
+	memcpy(row, input, sizeof(row));
+	LaneBuckets<T> lanes;
+	initLaneBuckets(&lanes, blockSize, bucketWidth);
+	bucketRow(&lanes, row, false, bucketWidth, buckets);
+
+	size_t inputIndex = sizeof(row);
+	long blockIndex = 1;
+	for (; blockIndex < blockSize - 5; blockIndex++) {
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		decompressBlock<false, true>(input, (T*)NULL, row, &inputIndex, blockSize, blockIndex);
+		bucketRow(&lanes, row, unchanged, bucketWidth, buckets);
+	}
+	for (; blockIndex < blockSize; blockIndex++) {
+		bool unchanged = (uint8_t)input[inputIndex] == 0b11111111;
+		decompressBlock<true, true>(input, (T*)NULL, row, &inputIndex, blockSize, blockIndex);
+		bucketRow(&lanes, row, unchanged, bucketWidth, buckets);
+	}
+
+	finishLaneBuckets(&lanes, blockSize, bucketWidth, buckets);
+	bucketValues(&input[inputIndex], inputElements % VECTOR_SIZE, bucketWidth, buckets,
+	             blockSize * VECTOR_SIZE);
+	return bucketsCount;
+}
+
+//
+// PRECISION TRUNCATION
+//
+
+template <typename T>
+void Scalar<T>::truncatePrecision(const T* data, size_t count, T* output, ErrorBound bound) {
+	int base = getTruncationBase(bound);
+	for (size_t i = 0; i < count; i++) {
+		uint64_t bits;
+		memcpy(&bits, &data[i], sizeof(bits));
+		bits = truncateBits(bits, bound.mode, base);
+		memcpy(&output[i], &bits, sizeof(bits));
+	}
 }
 
-}  // end namespace middleout
\ No newline at end of file
+}  // end namespace middleout
@@ -11,6 +11,10 @@ See LICENSE.md file
 #include <cstddef>
 #include <type_traits>
 #include <memory>
+#include "aggregate.hpp"
+#include "delta.hpp"
+#include "precision.hpp"
+#include "status.hpp"
 
 #ifndef SCALAR2_H
 #define SCALAR2_H
@@ -29,14 +33,139 @@ class Scalar {
 
 	static size_t compress(std::vector<T>& data, std::vector<char>& output);
 
+	/*
+	 Compresses count values to output. Returns 0 (nothing written) if capacity is less than
+	 maxCompressedSize(count).
+	*/
+	static size_t compress(const T* data, size_t count, char* output, size_t capacity);
+
+	/*
+	 Same as compress, checksum of the values is stored in the trailer (see helpers.hpp). Output is
+	 read by decompress too.
+	*/
+	static size_t compressChecksummed(const T* data, size_t count, char* output, size_t capacity);
+
 	static void decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data);
 
+	static void decompress(const char* input, size_t itemsCount, T* data);
+
+	// writes data by non-temporal stores (bypassing caches)
+	static void decompressNonTemporal(const char* input, size_t itemsCount, T* data);
+
+	/*
+	 Decompresses output of compressChecksummed, verifies checksum of the values while decoding.
+	 Returns DECODE_CHECKSUM_MISMATCH or DECODE_MALFORMED (no checksum stored) if not valid.
+	*/
+	static DecodeStatus decompressVerified(const char* input, size_t itemsCount, T* data);
+
+	/*
+	 Aggregates of values of compress output (see aggregate.hpp), computed while decoding without
+	 storing the values
+	*/
+	static void decompressAggregates(const char* input,
+	                                 size_t itemsCount,
+	                                 Aggregates<T>* aggregates);
+
+	/*
+	 Marks values of compress output matching predicate (see aggregate.hpp) in bitmap of
+	 scanBitmapWords(itemsCount) words, computed while decoding without storing the values.
+	 Returns number of matching values.
+	*/
+	static size_t scan(const char* input,
+	                   size_t itemsCount,
+	                   ScanPredicate predicate,
+	                   T threshold,
+	                   uint64_t* bitmap);
+
+	/*
+	 Downsamples values of compress output to buckets of bucketWidth values (see aggregate.hpp),
+	 computed while decoding without storing the values. Returns number of buckets written
+	 (getBucketsCount), 0 if bucketWidth is 0.
+	*/
+	static size_t decompressBuckets(const char* input,
+	                                size_t itemsCount,
+	                                size_t bucketWidth,
+	                                Bucket<T>* buckets);
+
+	/*
+	 Validating decompress of untrusted input of exactly inputSize bytes (as returned by
+	 compress), reads nothing outside of it. Checksum is verified if there is one. data are
+	 clobbered if the input is not valid.
+	*/
+	static DecodeStatus decompressSafe(const char* input,
+	                                   size_t inputSize,
+	                                   size_t itemsCount,
+	                                   T* data);
+
+	/*
+	 Compresses by adaptive rows (see helpers.hpp), readable by decompressAdaptive only. Returns 0
+	 (nothing written) if capacity is less than maxCompressedSize(count).
+	*/
+	static size_t compressAdaptive(const T* data, size_t count, char* output, size_t capacity);
+
+	static void decompressAdaptive(const char* input, size_t itemsCount, T* data);
+
+	/*
+	 Validating decompressAdaptive of untrusted input of exactly inputSize bytes (as returned by
+	 compressAdaptive), reads nothing outside of it
+	*/
+	static DecodeStatus decompressAdaptiveSafe(const char* input,
+	                                           size_t inputSize,
+	                                           size_t itemsCount,
+	                                           T* data);
+
+	/*
+	 Writes data with low mantissa bits zeroed within bound (see precision.hpp) to output (may be
+	 data), values are taken as doubles
+	*/
+	static void truncatePrecision(const T* data, size_t count, T* output, ErrorBound bound);
+
+	/*
+	 Compresses data truncated within bound (see truncatePrecision) as they are loaded, output is
+	 read by decompress. Returns 0 (nothing written) if bound is not valid or capacity is less than
+	 maxCompressedSize(count).
+	*/
+	static size_t compressLossy(const T* data,
+	                            size_t count,
+	                            char* output,
+	                            size_t capacity,
+	                            ErrorBound bound);
+
+	/*
+	 Compresses data with transform (see delta.hpp) applied as the rows are loaded, output is read
+	 by decompressTransformed and decompressSafeTransformed with the same transform. Returns 0
+	 (nothing written) if capacity is less than maxCompressedSize(count).
+	*/
+	static size_t compressTransformed(const T* data,
+	                                  size_t count,
+	                                  char* output,
+	                                  size_t capacity,
+	                                  Transform transform);
+
+	// reverts transform as the rows are decoded
+	static void decompressTransformed(const char* input,
+	                                  size_t itemsCount,
+	                                  T* data,
+	                                  Transform transform);
+
+	/*
+	 Validating decompressTransformed (see decompressSafe), returns DECODE_MALFORMED if there is a
+	 checksum stored
+	*/
+	static DecodeStatus decompressSafeTransformed(const char* input,
+	                                              size_t inputSize,
+	                                              size_t itemsCount,
+	                                              T* data,
+	                                              Transform transform);
+
 	static size_t maxCompressedSize(size_t count) {
 		size_t blockCount = count / 8;
 		// 8*8            : init reference values
 		// 5*blockClount  : max size of block headers
 		// 8*8*blockCount : max size of xored data: 8 bytes * 8 values
 		// 8*(count%8)    : uncompressed rest of values
+		// there is one row less than counted, it leaves room for the trailer and for writes past
+		// the data (see compressBound in middleout.hpp for the exact size)
 		return 8 * 8 + blockCount * 5 + 8 * 8 * blockCount + 8 * (count % 8);
 	}
 };
@@ -0,0 +1,223 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "scalar32.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <memory>
+
+namespace middleout {
+
+template class Scalar32<float>;
+template class Scalar32<int32_t>;
+template class Scalar32<uint32_t>;
+
+template <typename T>
+Scalar32<T>::Scalar32() {}
+
+template <typename T>
+std::unique_ptr<std::vector<char>> Scalar32<T>::compressSimple(std::vector<T>& data) {
+	std::unique_ptr<std::vector<char>> compressed(
+	    new std::vector<char>(Scalar32<T>::maxCompressedSize(data.size())));
+	size_t size = Scalar32<T>::compress(data, *compressed);
+	compressed->resize(size);
+	compressed->shrink_to_fit();
+	return compressed;
+}
+
+template <typename T>
+size_t Scalar32<T>::compress(std::vector<T>& data, std::vector<char>& output) {
+	return Scalar32<T>::compress(data.data(), data.size(), output.data(), output.size());
+}
+
+template <typename T>
+void Scalar32<T>::decompress(std::vector<char>& input, size_t itemsCount, std::vector<T>& data) {
+	Scalar32<T>::decompress(input.data(), itemsCount, data.data());
+}
+
+/*
+
+AVX 512 block compatible
+
+*/
+template <typename T>
+size_t Scalar32<T>::compress(const T* data, size_t count, char* output, size_t capacity) {
+	if (capacity < maxCompressedSize(count)) {
+		// output could overflow
+		return 0;
+	}
+
+	if (count <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD_32) {
+		// not enough data to compress
+		return doNotCompressTheData(data, count, output);
+	}
+
+	const uint32_t* values = reinterpret_cast<const uint32_t*>(data);
+
+	// "middle-out" data block size
+	size_t blockSize = count / VECTOR_SIZE_32;
+	// just copy init reference values
+	for (size_t j = 0; j < VECTOR_SIZE_32; j++) {
+		memcpy(&output[sizeof(T) * j], &values[blockSize * j], sizeof(T));
+	}
+	// skip first 16 init values
+	size_t outputIndex = sizeof(T) * VECTOR_SIZE_32;
+
+	// main compression loop
+	for (size_t i = 1; i < blockSize; i += 1) {
+		uint16_t sameMask = 0;  // bit mask if current value is same as previous one
+		int maxLength = 0;      // max (within 16 values) length of compressed value in bytes
+
+		// 2 bit offsets (trailing zero bytes of xored value) of stored values, 16 fit to 32 bits
+		uint32_t compressedOffsets = 0;
+		uint32_t offsetsShift = 0;
+		int notSameCount = 0;
+
+		// temp arrays allow to perform compression logic wihout loop dependency
+		uint32_t xoredShifted[16];
+		int dataStoreFlags[16];
+
+		// branchless, changes are hardly predictable
+		for (size_t j = 0; j < VECTOR_SIZE_32; j++) {
+			size_t offset = blockSize * j + i;
+			uint32_t xored = values[offset - 1] ^ values[offset];
+			int isStored = xored != 0;
+
+			// set bits keep both counts defined for zero (length is negative then)
+			int rightOffsetBytes = __builtin_ctz(xored | 0x80000000) >> 3;
+			int leftOffsetBytes = __builtin_clz(xored | 1) >> 3;
+			maxLength = std::max(4 - leftOffsetBytes - rightOffsetBytes, maxLength);
+
+			sameMask |= (1 - isStored) << j;
+			compressedOffsets |= (uint32_t)(rightOffsetBytes * isStored) << offsetsShift;
+			offsetsShift += 2 * isStored;
+			notSameCount += isStored;
+
+			// aligned to right
+			xoredShifted[j] = xored >> (8 * rightOffsetBytes);
+			dataStoreFlags[j] = isStored;
+		}
+
+		memcpy(&output[outputIndex], &sameMask, sizeof(sameMask));
+		outputIndex += sizeof(sameMask);
+
+		// do not store max length and offsets if all values are the same
+		if (sameMask == 0xFFFF) {
+			continue;
+		}
+
+		// offsets follow 2 bits of max length
+		// -1 becasue we need to store only values 1-4, so 2 bits are enought
+		uint64_t header = (uint64_t)compressedOffsets << 2 | (maxLength - 1);
+		memcpy(&output[outputIndex], &header, sizeof(header));
+		// +1 because first 2 bits are maxLength
+		outputIndex += getBytesLengthOfOffsets32(notSameCount + 1);
+
+		// write prepared data, stored ones overwrite unused bytes of previous ones
+		for (size_t j = 0; j < VECTOR_SIZE_32; j++) {
+			memcpy(&output[outputIndex], &xoredShifted[j], sizeof(uint32_t));
+			outputIndex += dataStoreFlags[j] * maxLength;
+		}
+	}
+
+	// write rest of the data without any compression
+	for (size_t i = blockSize * VECTOR_SIZE_32; i < count; i++) {
+		memcpy(&output[outputIndex], &values[i], sizeof(T));
+		outputIndex += sizeof(T);
+	}
+
+	return writeTrailer(output, outputIndex);
+}
+
+//
+// DECOMPRESSION
+//
+
+static inline void decompressBlock(const char* input,
+                                   uint32_t* data,
+                                   size_t* inputIndex,
+                                   const size_t blockSize,
+                                   const size_t i) {
+	// read mask of same values
+	uint16_t sameMask;
+	memcpy(&sameMask, &input[*inputIndex], sizeof(sameMask));
+	*inputIndex += sizeof(sameMask);
+
+	if (sameMask == 0xFFFF) {
+		// just copy prev values
+		for (size_t j = 0; j < VECTOR_SIZE_32; j++) {
+			size_t offset = blockSize * j + i;
+			data[offset] = data[offset - 1];
+		}
+		return;
+	}
+
+	// read unaligned offsets (up to 34 bits)
+	uint64_t compresedOffsetsAndMaxLength;
+	memcpy(&compresedOffsetsAndMaxLength, &input[*inputIndex], sizeof(uint64_t));
+	// +1 because only 2 bits are stored and valid lengths are 1-4
+	uint8_t maxLength = (compresedOffsetsAndMaxLength & 0b11) + 1;
+	uint32_t clearTopBitMask = ~((uint32_t)0) >> (32 - 8 * maxLength);
+
+	int notSameCount = VECTOR_SIZE_32 - __builtin_popcount(sameMask);
+	// +1 because first 2 bits are maxLength
+	*inputIndex += getBytesLengthOfOffsets32(notSameCount + 1);
+
+	int offsetsShift = 2;  // skip 2 bits for maxLength
+	for (size_t j = 0; j < VECTOR_SIZE_32; j++) {
+		size_t offset = blockSize * j + i;
+		// all bits set if value is stored
+		uint32_t isStored = ((sameMask >> j) & 1) - 1;
+
+		uint32_t toXor;
+		memcpy(&toXor, &input[*inputIndex], sizeof(uint32_t));
+		int shiftBits = ((compresedOffsetsAndMaxLength >> offsetsShift) & 0b11) * 8;
+
+		// branchless: not stored values xor zero and do not move the cursors
+		data[offset] = data[offset - 1] ^ (((toXor & clearTopBitMask) << shiftBits) & isStored);
+		offsetsShift += 2 & isStored;
+		*inputIndex += maxLength & isStored;
+	}
+}
+
+template <typename T>
+void Scalar32<T>::decompress(const char* input, size_t inputElements, T* data) {
+	// not enough data to compress
+	if (inputElements <= MIN_DATA_SIZE_COMPRESSION_TRESHOLD_32) {
+		return doNotDecompressTheData(input, inputElements, data);
+	}
+
+	uint32_t* values = reinterpret_cast<uint32_t*>(data);
+
+	// middle-out block size
+	size_t blockSize = inputElements / VECTOR_SIZE_32;
+	// copy first ref. values
+	for (size_t j = 0; j < VECTOR_SIZE_32; j++) {
+		memcpy(&values[blockSize * j], &input[sizeof(T) * j], sizeof(T));
+	}
+
+	// skip first 16 init values
+	size_t inputIndex = sizeof(T) * VECTOR_SIZE_32;
+
+	// main decompression loop
+	for (size_t i = 1; i < blockSize; i++) {
+		decompressBlock(input, values, &inputIndex, blockSize, i);
+	}
+
+	// copy rest of data (uncompressed)
+	for (size_t i = blockSize * VECTOR_SIZE_32; i < inputElements; i++) {
+		memcpy(&values[i], &input[inputIndex], sizeof(T));
+		inputIndex += sizeof(T);
+	}
+}
+
+}  // end namespace middleout
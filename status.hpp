@@ -0,0 +1,27 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#ifndef STATUS_H
+#define STATUS_H
+
+namespace middleout {
+
+/*
+ Result of validating decompression (decompressSafe, decompressVerified)
+*/
+enum DecodeStatus {
+	DECODE_OK = 0,
+	DECODE_TRUNCATED,         // input is shorter than the compressed values can be
+	DECODE_MALFORMED,         // rows do not fit the input, input is longer or trailer is missing
+	DECODE_CHECKSUM_MISMATCH  // decompressed values do not match checksum of compressChecksummed
+};
+
+}  // end namespace middleout
+
+#endif /* STATUS_H */
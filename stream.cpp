@@ -0,0 +1,168 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include "stream.hpp"
+#include "frame.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+namespace middleout {
+
+template class StreamEncoder<double>;
+template class StreamEncoder<int64_t>;
+template class StreamEncoder<uint64_t>;
+
+template class StreamDecoder<double>;
+template class StreamDecoder<int64_t>;
+template class StreamDecoder<uint64_t>;
+
+//
+// ENCODER
+//
+
+template <typename T>
+StreamEncoder<T>::StreamEncoder(CompressFunction compress,
+                                Sink sink,
+                                size_t frameSize,
+                                bool checksum)
+    : compress(compress),
+      compressTransformed(NULL),
+      sink(sink),
+      frameSize(std::max<size_t>(1, frameSize)),
+      checksum(checksum),
+      transform(TRANSFORM_NONE),
+      output(Frame<T>::maxCompressedSize(this->frameSize, 0, TRANSFORM_NONE)) {
+	buffer.reserve(this->frameSize);
+}
+
+template <typename T>
+StreamEncoder<T>::StreamEncoder(TransformedCompressFunction compressTransformed,
+                                Sink sink,
+                                size_t frameSize,
+                                bool checksum,
+                                Transform transform)
+    : compress(NULL),
+      compressTransformed(compressTransformed),
+      sink(sink),
+      frameSize(std::max<size_t>(1, frameSize)),
+      checksum(checksum),
+      transform(transform),
+      output(Frame<T>::maxCompressedSize(this->frameSize, 0, transform)) {
+	// frames of transformed doubles are never written (see Frame::compress)
+	assert(transform == TRANSFORM_NONE || !std::is_floating_point<T>::value);
+	buffer.reserve(this->frameSize);
+}
+
+template <typename T>
+StreamEncoder<T>::~StreamEncoder() {
+	flush();
+}
+
+template <typename T>
+void StreamEncoder<T>::append(const T* data, size_t count) {
+	while (count > 0) {
+		if (buffer.size() >= frameSize) {
+			// frame cannot be written (see flush), values are kept
+			buffer.insert(buffer.end(), data, data + count);
+			return;
+		}
+		size_t length = std::min(count, frameSize - buffer.size());
+		buffer.insert(buffer.end(), data, data + length);
+		data += length;
+		count -= length;
+
+		if (buffer.size() == frameSize) {
+			flush();
+		}
+	}
+}
+
+template <typename T>
+bool StreamEncoder<T>::flush() {
+	if (buffer.empty()) {
+		return true;
+	}
+
+	size_t length;
+	if (compressTransformed != NULL) {
+		length = Frame<T>::compress(compressTransformed, buffer.data(), buffer.size(),
+		                            output.data(), output.size(), checksum, 0, transform);
+	} else {
+		length = Frame<T>::compress(compress, buffer.data(), buffer.size(), output.data(),
+		                            output.size(), checksum, 0);
+	}
+	if (length == 0) {
+		return false;
+	}
+	buffer.clear();
+	sink(output.data(), length);
+	return true;
+}
+
+//
+// DECODER
+//
+
+template <typename T>
+StreamDecoder<T>::StreamDecoder(DecompressFunction decompress,
+                                TransformedDecompressFunction decompressTransformed)
+    : decompress(decompress),
+      decompressTransformed(decompressTransformed),
+      position(0),
+      corrupted(false) {}
+
+template <typename T>
+void StreamDecoder<T>::feed(const char* input, size_t size) {
+	// drop decompressed frames, so buffer holds the incomplete frame only
+	buffer.erase(buffer.begin(), buffer.begin() + position);
+	position = 0;
+
+	buffer.insert(buffer.end(), input, input + size);
+}
+
+template <typename T>
+bool StreamDecoder<T>::next(std::vector<T>& values) {
+	if (corrupted) {
+		return false;
+	}
+
+	const char* frame = buffer.data() + position;
+	size_t size = buffer.size() - position;
+
+	FrameInfo info;
+	FrameStatus status = Frame<T>::parse(frame, size, &info);
+	if (status == FRAME_TRUNCATED) {
+		return false;
+	}
+
+	if (status == FRAME_MALFORMED) {
+		corrupted = true;
+		return false;
+	}
+
+	size_t frameLength = info.headerSize + info.indexSize + info.payloadSize;
+
+	values.resize(info.itemsCount);
+	bool decompressed =
+	    info.transform != TRANSFORM_NONE && decompressTransformed != NULL
+	        ? Frame<T>::decompress(decompressTransformed, frame, frameLength, values.data(),
+	                               values.size())
+	        : Frame<T>::decompress(decompress, frame, frameLength, values.data(), values.size());
+	if (!decompressed) {
+		corrupted = true;
+		return false;
+	}
+
+	position += frameLength;
+	return true;
+}
+
+}  // end namespace middleout
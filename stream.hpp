@@ -0,0 +1,151 @@
+/*
+
+Copyright (c) 2017, Schizofreny s.r.o - info@schizofreny.com
+All rights reserved.
+
+See LICENSE.md file
+
+*/
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "delta.hpp"
+#include "status.hpp"
+
+#ifndef STREAM_H
+#define STREAM_H
+
+namespace middleout {
+
+// default number of values in one frame of stream (64 KB of 64bit values)
+const size_t STREAM_FRAME_SIZE = 1 << 13;
+
+/*
+
+Incremental compression of values arriving one by one (live ingestion).
+
+Values are buffered until frameSize of them are collected, then compressed to a self-contained
+frame (see frame.hpp, integers optionally delta transformed) and handed to the sink. A stream is
+just a concatenation of frames, so memory of an open stream is bounded by one frame of values and
+one compressed frame. Doubles are never transformed, the encoder rejects a transform of them.
+
+*/
+template <typename T>
+class StreamEncoder {
+   public:
+	typedef size_t (*CompressFunction)(const T* data, size_t count, char* output, size_t capacity);
+	// compressTransformed, see Frame
+	typedef size_t (*TransformedCompressFunction)(const T* data,
+	                                              size_t count,
+	                                              char* output,
+	                                              size_t capacity,
+	                                              Transform transform);
+	// receives every finished frame, data are valid during the call only
+	typedef std::function<void(const char* frame, size_t length)> Sink;
+
+	StreamEncoder(CompressFunction compress,
+	              Sink sink,
+	              size_t frameSize = STREAM_FRAME_SIZE,
+	              bool checksum = false);
+
+	// frames of integers transformed by transform
+	StreamEncoder(TransformedCompressFunction compressTransformed,
+	              Sink sink,
+	              size_t frameSize,
+	              bool checksum,
+	              Transform transform);
+
+	// flushes buffered values
+	~StreamEncoder();
+
+	StreamEncoder(const StreamEncoder&) = delete;
+	StreamEncoder& operator=(const StreamEncoder&) = delete;
+
+	void append(T value) {
+		buffer.push_back(value);
+		if (buffer.size() >= frameSize) {
+			flush();
+		}
+	}
+
+	void append(const T* data, size_t count);
+
+	/*
+	 Writes buffered values (if any) as a frame, even if it is not full. Returns false if the frame
+	 cannot be compressed (nothing is handed to the sink, values stay buffered).
+	*/
+	bool flush();
+
+	// number of values waiting for the frame to fill
+	size_t pending() const { return buffer.size(); }
+
+   private:
+	CompressFunction compress;
+	TransformedCompressFunction compressTransformed;
+	Sink sink;
+	size_t frameSize;
+	bool checksum;
+	Transform transform;
+
+	std::vector<T> buffer;
+	std::vector<char> output;
+};
+
+/*
+
+Decompression of stream written by StreamEncoder, frame by frame. Input may be fed in arbitrary
+pieces, fed bytes are held until next() decompresses their frames (frames decompressed before are
+dropped by the following feed). Calling next() until it returns false after each feed keeps only
+one incomplete frame buffered, see buffered().
+
+*/
+template <typename T>
+class StreamDecoder {
+   public:
+	// validating decompress (decompressSafe), see Frame
+	typedef DecodeStatus (*DecompressFunction)(const char* input,
+	                                           size_t inputSize,
+	                                           size_t itemsCount,
+	                                           T* data);
+	// decompressSafeTransformed, see Frame
+	typedef DecodeStatus (*TransformedDecompressFunction)(const char* input,
+	                                                      size_t inputSize,
+	                                                      size_t itemsCount,
+	                                                      T* data,
+	                                                      Transform transform);
+
+	/*
+	 Transformed frames are decompressed by decompressTransformed, stream holding them is failed
+	 without it
+	*/
+	explicit StreamDecoder(DecompressFunction decompress,
+	                       TransformedDecompressFunction decompressTransformed = NULL);
+
+	void feed(const char* input, size_t size);
+
+	/*
+	 Decompresses next complete frame to values (resized to the frame length). Returns false if
+	 more input is needed or stream is corrupted (see failed).
+	*/
+	bool next(std::vector<T>& values);
+
+	// stream is malformed, holds other type or checksum does not match
+	bool failed() const { return corrupted; }
+
+	// bytes fed but not decompressed yet, including complete frames waiting for next()
+	size_t buffered() const { return buffer.size() - position; }
+
+   private:
+	DecompressFunction decompress;
+	TransformedDecompressFunction decompressTransformed;
+
+	std::vector<char> buffer;
+	size_t position;  // start of the next frame within buffer
+	bool corrupted;
+};
+
+}  // end namespace middleout
+
+#endif /* STREAM_H */